@@ -0,0 +1,828 @@
+/* bench.c - throughput benchmarks, run all with `make bench` or one with `build/bench/bench <name>` */
+
+#include <stdio.h>
+#include <string.h>
+
+// Define TEST_BUILD before including main.c to exclude main()
+#define TEST_BUILD
+#include "engine.c"
+#include "main.c"
+
+typedef struct {
+    const char* name;
+    void (*run)(void);
+} Bench;
+
+// Fixed position set shared by the benchmarks
+Game* bench_game(unsigned int seed) {
+    static Game game;
+    memset(&game, 0, sizeof(Game));
+    srand(seed);
+    camels_init_game(&game);
+    return &game;
+}
+
+double per_second(uint64_t count, uint64_t ns) { return (double) count * 1e9 / (double) (ns > 0 ? ns : 1); }
+
+//////////////////////////////////// Evaluation //////////////////////////////////////
+
+#define EVAL_BATCH  256
+#define EVAL_ROUNDS 2000
+
+void bench_eval_kind(EvalKind kind) {
+    static Evaluator ev;
+    static _Alignas(16) float features[EVAL_BATCH * N_FEATURES];
+    static float out[EVAL_BATCH * N_EVAL_OUTPUTS];
+    Rng rng = {.state = 1};
+
+    ev.kind = kind;
+    for (int h = 0; h < EVAL_HIDDEN; h++) {
+        for (int i = 0; i < N_FEATURES_USED; i++) {
+            ev.w1[h][i] = (float) rng_range(&rng, -100, 100) / 1000.0f;
+        }
+    }
+    for (int o = 0; o < N_EVAL_OUTPUTS; o++) {
+        for (int h = 0; h < EVAL_HIDDEN; h++) {
+            ev.w2[o][h] = (float) rng_range(&rng, -100, 100) / 1000.0f;
+        }
+    }
+    for (int i = 0; i < EVAL_BATCH; i++) {
+        Game* game = bench_game((unsigned int) i);
+        for (int r = 0; r < i % 12; r++) {
+            sim_roll(game, &rng);
+        }
+        extract_features(game, features + i * N_FEATURES);
+    }
+
+    uint64_t start = now_ns();
+    for (int r = 0; r < EVAL_ROUNDS; r++) {
+        eval_batch(&ev, features, EVAL_BATCH, out);
+    }
+    uint64_t ns = now_ns() - start;
+    printf("  eval %-6s batch %d: %12.0f evals/s\n", kind == EVAL_LINEAR ? "linear" : "mlp", EVAL_BATCH,
+           per_second((uint64_t) EVAL_BATCH * EVAL_ROUNDS, ns));
+}
+
+void bench_eval(void) {
+    bench_eval_kind(EVAL_LINEAR);
+    bench_eval_kind(EVAL_MLP);
+
+    Game* game = bench_game(1);
+    _Alignas(16) float features[N_FEATURES];
+    int n          = 200000;
+    uint64_t start = now_ns();
+    for (int i = 0; i < n; i++) {
+        extract_features(game, features);
+    }
+    printf("  extract_features:   %12.0f positions/s\n", per_second((uint64_t) n, now_ns() - start));
+}
+
+//////////////////////////////////// Self-play //////////////////////////////////////
+
+void bench_self_play(void) {
+    const char* path = "build/bench/self_play.dat";
+    for (int compress = 0; compress <= 1; compress++) {
+        SelfPlayConfig config = {.games = 2000, .sample_rate = 0.25, .seed = 1, .compress = compress};
+        SelfPlayResult result;
+        if (!camels_self_play(&config, path, &result)) {
+            printf("  could not write %s\n", path);
+            return;
+        }
+        printf("  self-play %-10s %ld games: %10.0f positions/s, %.1f bytes/position\n",
+               compress ? "compressed" : "raw", result.games, (double) result.positions / result.seconds,
+               (double) result.bytes / (double) result.positions);
+    }
+    remove(path);
+}
+
+//////////////////////////////////// Columnar Export //////////////////////////////////////
+
+void bench_export(void) {
+    const char* path = "build/bench/export.col";
+    long games       = 20000;
+    uint64_t rows, bytes;
+    uint64_t start = now_ns();
+    if (!camels_export_games(path, games, 1, &rows, &bytes)) {
+        printf("  could not write %s\n", path);
+        return;
+    }
+    uint64_t ns = now_ns() - start;
+    printf("  export %ld games: %.0f games/s, %.2f bytes/row, %.1f MB per million games\n", games,
+           per_second((uint64_t) games, ns), (double) bytes / (double) rows, (double) bytes / (double) games);
+
+    static int64_t values[COLUMN_GROUP_ROWS];
+    ColumnReader reader;
+    uint64_t scanned = 0;
+    start            = now_ns();
+    columns_open(&reader, path, COL_COLOR);
+    for (size_t n; (n = columns_next(&reader, values)) > 0;) {
+        scanned += n;
+    }
+    columns_close_reader(&reader);
+    printf("  scan color column: %.0f rows/s\n", per_second(scanned, now_ns() - start));
+    remove(path);
+}
+
+//////////////////////////////////// Sessions //////////////////////////////////////
+
+#define BENCH_SESSIONS 10000
+
+void bench_sessions(void) {
+    Session* sessions       = calloc(BENCH_SESSIONS, sizeof(Session));
+    Policy seats[N_PLAYERS] = {camels_bot_random, camels_bot_greedy, camels_bot_random,
+                               camels_bot_greedy, camels_bot_random, camels_bot_greedy};
+    Event events[8];
+    bool saved         = camels_log_enabled;
+    camels_log_enabled = false;
+
+    uint64_t start = now_ns();
+    for (int i = 0; i < BENCH_SESSIONS; i++) {
+        camels_start_game(&sessions[i], seats, (uint64_t) i);
+    }
+    // round robin, a few events per game per pass, like a worker serving many tables
+    uint64_t turns = 0;
+    int live       = BENCH_SESSIONS;
+    while (live > 0) {
+        live = 0;
+        for (int i = 0; i < BENCH_SESSIONS; i++) {
+            if (session_over(&sessions[i])) {
+                continue;
+            }
+            live++;
+            int n = camels_poll_events(&sessions[i], events, 8);
+            for (int e = 0; e < n; e++) {
+                turns += events[e].type == EV_TURN;
+            }
+        }
+    }
+    uint64_t ns        = now_ns() - start;
+    camels_log_enabled = saved;
+    printf("  %d concurrent bot games on one thread: %.2fs, %.0f games/s, %.0f turns/s\n", BENCH_SESSIONS,
+           (double) ns / 1e9, per_second(BENCH_SESSIONS, ns), per_second(turns, ns));
+    free(sessions);
+}
+
+//////////////////////////////////// Forks //////////////////////////////////////
+
+#define FORK_ROUNDS 1000000
+
+void bench_forks(void) {
+    Game* game = bench_game(3);
+    Rng rng    = {.state = 5};
+    for (int r = 0; r < 3; r++) {
+        sim_roll(game, &rng);
+    }
+    Roll dice[64];
+    for (int i = 0; i < 64; i++) {
+        DiceColor left[N_DICE + 1];
+        int n   = remaining_dice(game, left);
+        dice[i] = die_face(left[rng_range(&rng, 0, n - 1)], rng_range(&rng, 0, 1), rng_range(&rng, 1, 3));
+    }
+
+    static Game copy;
+    uint64_t checksum = 0;
+    uint64_t start    = now_ns();
+    for (int i = 0; i < FORK_ROUNDS; i++) {
+        copy = *game;
+        stack_push(&copy.dice, dice[i % 64]);
+        move_camel(&copy, dice[i % 64].color, dice[i % 64].value);
+        checksum += (uint64_t) copy.winner;
+    }
+    uint64_t copy_ns = now_ns() - start;
+
+    GameFork root, child;
+    fork_from_game(&root, game);
+    start = now_ns();
+    for (int i = 0; i < FORK_ROUNDS; i++) {
+        fork_game(&root, &child);
+        fork_roll(&child, dice[i % 64]);
+        checksum += (uint64_t) child.winner;
+        fork_release(&child);
+    }
+    uint64_t fork_ns = now_ns() - start;
+    fork_release(&root);
+
+    printf("  struct copy (%zu bytes) + roll: %12.0f what-ifs/s\n", sizeof(Game), per_second(FORK_ROUNDS, copy_ns));
+    printf("  cow fork + roll (%zu bytes):    %12.0f what-ifs/s (checksum %lu)\n",
+           sizeof(GameFork) + sizeof(SharedBoard) + 2 * sizeof(Tile), per_second(FORK_ROUNDS, fork_ns),
+           (unsigned long) checksum);
+}
+
+//////////////////////////////////// Leg Odds //////////////////////////////////////
+
+#define LEG_GAMES     20
+#define LEG_MAX_TURNS 256
+
+typedef struct {
+    Game* positions;
+    int n;
+} LegCorpus;
+
+void leg_corpus_on_turn(void* ctx, Game* game, int player_id) {
+    (void) player_id;
+    LegCorpus* corpus = ctx;
+    if (corpus->n < LEG_GAMES * LEG_MAX_TURNS) {
+        corpus->positions[corpus->n++] = *game;
+    }
+}
+
+// every position of a few seeded bot games
+LegCorpus leg_corpus(void) {
+    LegCorpus corpus        = {.positions = malloc(LEG_GAMES * LEG_MAX_TURNS * sizeof(Game))};
+    Policy seats[N_PLAYERS] = {camels_bot_random, camels_bot_greedy, camels_bot_random,
+                               camels_bot_greedy, camels_bot_random, camels_bot_greedy};
+    GameHooks hooks         = {.on_turn = leg_corpus_on_turn, .ctx = &corpus};
+    bool saved              = camels_log_enabled;
+    camels_log_enabled      = false;
+    for (int i = 0; i < LEG_GAMES; i++) {
+        Rng rng         = {.state = (uint64_t) i};
+        Game game       = {0};
+        camels_game_rng = &rng;
+        camels_init_game(&game);
+        camels_game_rng = NULL;
+        camels_play_bot_game(&game, seats, &rng, &hooks);
+    }
+    camels_log_enabled = saved;
+    printf("  %d positions from %d bot games\n", corpus.n, LEG_GAMES);
+    return corpus;
+}
+
+// replays the positions of a few bot games through a color-keyed and a canonical cache
+void bench_leg_cache(void) {
+    LegCorpus corpus = leg_corpus();
+
+    for (int canonical = 0; canonical <= 1; canonical++) {
+        LegCache cache;
+        leg_cache_init(&cache, 18, canonical);
+        LegOdds odds;
+        uint64_t start = now_ns();
+        for (int i = 0; i < corpus.n; i++) {
+            cached_leg_odds(&cache, &corpus.positions[i], &odds);
+        }
+        uint64_t ns = now_ns() - start;
+        uint64_t lookups = cache.hits + cache.misses;
+        printf("  %-9s keys: %5.1f%% hits, %8lu positions walked, %.2fs, %.0f queries/s\n",
+               canonical ? "canonical" : "color", 100.0 * (double) cache.hits / (double) lookups,
+               (unsigned long) cache.misses, (double) ns / 1e9, per_second((uint64_t) corpus.n, ns));
+        leg_cache_free(&cache);
+    }
+    free(corpus.positions);
+}
+
+// turn by turn through bot games: a LegTracker that lives for the whole game against a cold cache per query,
+// split by what happened since the last query
+typedef enum { AFTER_LEG_START, AFTER_ROLL, AFTER_SPECTATOR, AFTER_OTHER, N_AFTER } LegAfter;
+
+typedef struct {
+    LegTracker tracker;
+    LegCache cold;
+    LegAfter after;
+    uint64_t queries[N_AFTER];
+    uint64_t warm_ns[N_AFTER], cold_ns[N_AFTER];
+    uint64_t warm_walked[N_AFTER], cold_walked[N_AFTER];
+} TrackerBench;
+
+void tracker_on_turn(void* ctx, Game* game, int player_id) {
+    (void) player_id;
+    TrackerBench* b = ctx;
+    LegAfter after  = b->after;
+    LegOdds odds;
+    uint64_t misses = b->tracker.cache.misses;
+    uint64_t start  = now_ns();
+    camels_leg_tracker_odds(&b->tracker, game, &odds);
+    b->warm_ns[after] += now_ns() - start;
+    b->warm_walked[after] += b->tracker.cache.misses - misses;
+
+    memset(b->cold.entries, 0, (b->cold.mask + 1) * sizeof(LegCacheEntry));
+    b->cold.misses = 0;
+    start          = now_ns();
+    cached_leg_odds(&b->cold, game, &odds);
+    b->cold_ns[after] += now_ns() - start;
+    b->cold_walked[after] += b->cold.misses;
+    b->queries[after]++;
+}
+
+void tracker_on_turn_done(void* ctx, Game* game, int player_id, Turn* turn) {
+    (void) player_id;
+    TrackerBench* b = ctx;
+    switch (turn->turn_type) {
+        case ROLL:
+            b->after = game->dice.count == N_DICE || game->winner ? AFTER_LEG_START : AFTER_ROLL;
+            break;
+        case SPECTATOR:
+            b->after = AFTER_SPECTATOR;
+            break;
+        case WAGER:
+        case TICKET:
+        default:
+            b->after = AFTER_OTHER;
+            break;
+    }
+}
+
+void bench_leg_tracker(void) {
+    static TrackerBench b;
+    camels_leg_tracker_init(&b.tracker, 16);
+    leg_cache_init(&b.cold, 16, true);
+    Policy seats[N_PLAYERS] = {camels_bot_random, camels_bot_greedy, camels_bot_random,
+                               camels_bot_greedy, camels_bot_random, camels_bot_greedy};
+    GameHooks hooks         = {.on_turn = tracker_on_turn, .on_turn_done = tracker_on_turn_done, .ctx = &b};
+    bool saved              = camels_log_enabled;
+    camels_log_enabled      = false;
+    for (int i = 0; i < LEG_GAMES; i++) {
+        Rng rng         = {.state = (uint64_t) i};
+        Game game       = {0};
+        camels_game_rng = &rng;
+        camels_init_game(&game);
+        camels_game_rng = NULL;
+        camels_play_bot_game(&game, seats, &rng, &hooks);
+    }
+    camels_log_enabled = saved;
+
+    const char* names[N_AFTER] = {"leg start", "roll", "spectator", "ticket/wager"};
+    for (int a = 0; a < N_AFTER; a++) {
+        double n = (double) b.queries[a];
+        printf("  %-12s %5lu queries: tracker %8.1f us %7.1f walked, cold %8.1f us %7.1f walked\n", names[a],
+               (unsigned long) b.queries[a], (double) b.warm_ns[a] / n / 1e3, (double) b.warm_walked[a] / n,
+               (double) b.cold_ns[a] / n / 1e3, (double) b.cold_walked[a] / n);
+    }
+    printf("  %lu answered from the root without a lookup\n", (unsigned long) b.tracker.root_hits);
+    camels_leg_tracker_free(&b.tracker);
+    leg_cache_free(&b.cold);
+}
+
+// batch latency and throughput over the leg corpus by batch size and thread count. Approximate odds are
+// timed in steady state; exact odds once per pool, starting from cold caches
+void bench_batch(void) {
+    LegCorpus corpus = leg_corpus();
+    PositionBatch all;
+    BatchOdds out;
+    position_batch_alloc(&all, corpus.n);
+    batch_odds_alloc(&out, corpus.n);
+    for (int i = 0; i < corpus.n; i++) {
+        position_batch_push(&all, &corpus.positions[i]);
+    }
+
+    int sizes[]   = {1, 16, 256, 1024};
+    int threads[] = {1, 2, 4};
+    for (size_t t = 0; t < sizeof(threads) / sizeof(threads[0]); t++) {
+        EvalPool pool;
+        eval_pool_init(&pool, threads[t]);
+        uint64_t exact_ns = eval_pool_run(&pool, &all, &out, true);
+        printf("  %d threads: exact %.0f positions/s cold\n", threads[t], per_second((uint64_t) corpus.n, exact_ns));
+        eval_pool_run(&pool, &all, &out, false); // approx tables are built on first use
+        for (size_t s = 0; s < sizeof(sizes) / sizeof(sizes[0]); s++) {
+            // a window of the corpus viewed as a smaller batch
+            PositionBatch view = all;
+            view.count         = sizes[s];
+            uint64_t total = 0, worst = 0;
+            int batches    = 0;
+            for (int begin = 0; begin + sizes[s] <= corpus.n; begin += sizes[s]) {
+                for (int c = 0; c < N_CAMELS; c++) {
+                    view.space[c]  = all.space[c] + begin;
+                    view.height[c] = all.height[c] + begin;
+                }
+                view.rolled = all.rolled + begin;
+                view.specs  = all.specs + begin;
+                for (int c = 0; c < N_BETS_COLORS; c++) {
+                    view.ticket[c] = all.ticket[c] + begin;
+                }
+                uint64_t ns = eval_pool_run(&pool, &view, &out, false);
+                total += ns;
+                worst = ns > worst ? ns : worst;
+                batches++;
+            }
+            printf("    approx batch %5d: %8.1f us mean, %8.1f us max, %10.0f positions/s\n", sizes[s],
+                   (double) total / batches / 1e3, (double) worst / 1e3,
+                   per_second((uint64_t) batches * (uint64_t) sizes[s], total));
+        }
+        eval_pool_free(&pool);
+    }
+    position_batch_free(&all);
+    batch_odds_free(&out);
+    free(corpus.positions);
+}
+
+#define SHM_BENCH_QUERIES 4000 // per client
+
+int compare_u64(const void* a, const void* b) {
+    uint64_t x = *(const uint64_t*) a, y = *(const uint64_t*) b;
+    return (x > y) - (x < y);
+}
+
+// round trips through the shared memory ring from client processes, approximate odds so the ring itself
+// is most of what is measured
+void bench_shm(void) {
+    LegCorpus corpus = leg_corpus();
+    const char* path = "build/bench/shm.ring";
+    ShmServer server;
+    if (!shm_server_start(&server, path, 1)) {
+        printf("  could not create %s\n", path);
+        return;
+    }
+    int clients[] = {1, 4, 16};
+    for (size_t k = 0; k < sizeof(clients) / sizeof(clients[0]); k++) {
+        size_t n         = (size_t) clients[k] * SHM_BENCH_QUERIES;
+        // latencies come back through a shared file mapping, unlinked straight away
+        int fd = open("build/bench/shm.rtt", O_RDWR | O_CREAT | O_TRUNC, 0600);
+        unlink("build/bench/shm.rtt");
+        if (fd < 0 || ftruncate(fd, (off_t) (n * sizeof(uint64_t))) != 0) {
+            printf("  could not map latencies\n");
+            break;
+        }
+        uint64_t* rtt = mmap(NULL, n * sizeof(uint64_t), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+        close(fd);
+        uint64_t start = now_ns();
+        pid_t pids[16];
+        fflush(NULL);
+        for (int c = 0; c < clients[k]; c++) {
+            pids[c] = fork();
+            if (pids[c] == 0) {
+                ShmMap map;
+                if (!shm_client_open(&map, path)) {
+                    _exit(1);
+                }
+                for (int q = 0; q < SHM_BENCH_QUERIES; q++) {
+                    ShmAnswer answer;
+                    uint64_t t = now_ns();
+                    shm_query(&map, &corpus.positions[(c * 131 + q) % corpus.n], 0, false, &answer);
+                    rtt[(size_t) c * SHM_BENCH_QUERIES + (size_t) q] = now_ns() - t;
+                }
+                _exit(0);
+            }
+        }
+        for (int c = 0; c < clients[k]; c++) {
+            waitpid(pids[c], NULL, 0);
+        }
+        uint64_t ns = now_ns() - start;
+        qsort(rtt, n, sizeof(uint64_t), compare_u64);
+        printf("  %2d clients: p50 %6.1f us, p99 %7.1f us, %8.0f queries/s\n", clients[k],
+               (double) rtt[n / 2] / 1e3, (double) rtt[n * 99 / 100] / 1e3, per_second((uint64_t) n, ns));
+        munmap(rtt, n * sizeof(uint64_t));
+    }
+    shm_server_stop(&server);
+    free(corpus.positions);
+}
+
+#define APPROX_REPEATS 20
+
+// camels_approx_leg_odds against the exact walk on the same corpus: time per call and error per bet
+void bench_approx_leg(void) {
+    LegCorpus corpus = leg_corpus();
+    LegOdds* exact   = malloc((size_t) corpus.n * sizeof(LegOdds));
+    LegCache cache;
+    leg_cache_init(&cache, 18, true);
+    for (int i = 0; i < corpus.n; i++) {
+        cached_leg_odds(&cache, &corpus.positions[i], &exact[i]);
+    }
+    leg_cache_free(&cache);
+
+    LegOdds odds;
+    camels_approx_leg_odds(&corpus.positions[0], &odds); // builds the tables
+    double checksum = 0.0;
+    uint64_t start  = now_ns();
+    for (int r = 0; r < APPROX_REPEATS; r++) {
+        for (int i = 0; i < corpus.n; i++) {
+            camels_approx_leg_odds(&corpus.positions[i], &odds);
+            checksum += odds.first[0];
+        }
+    }
+    uint64_t ns = now_ns() - start;
+    printf("  approx: %.0f ns/call (checksum %.3f)\n", (double) ns / (APPROX_REPEATS * (double) corpus.n), checksum);
+
+    double mean[3] = {0}, worst[3] = {0};
+    int agree = 0;
+    for (int i = 0; i < corpus.n; i++) {
+        camels_approx_leg_odds(&corpus.positions[i], &odds);
+        const double* got[3]  = {odds.first, odds.second, odds.last};
+        const double* want[3] = {exact[i].first, exact[i].second, exact[i].last};
+        int best = 0, best_exact = 0;
+        for (int c = 0; c < N_BETS_COLORS; c++) {
+            for (int k = 0; k < 3; k++) {
+                double err = fabs(got[k][c] - want[k][c]);
+                mean[k] += err / N_BETS_COLORS;
+                worst[k] = err > worst[k] ? err : worst[k];
+            }
+            best       = odds.first[c] > odds.first[best] ? c : best;
+            best_exact = exact[i].first[c] > exact[i].first[best_exact] ? c : best_exact;
+        }
+        agree += best == best_exact;
+    }
+    const char* names[3] = {"first", "second", "last"};
+    for (int k = 0; k < 3; k++) {
+        printf("  %-6s mean abs error %.4f, max %.3f\n", names[k], mean[k] / corpus.n, worst[k]);
+    }
+    printf("  favorite matches exact in %.1f%% of positions\n", 100.0 * agree / corpus.n);
+    free(exact);
+    free(corpus.positions);
+}
+
+//////////////////////////////////// Sequential Sampling //////////////////////////////////////
+
+#define SEQ_BENCH_STRIDE 8    // every 8th corpus position
+#define SEQ_HALF_WIDTH   0.01 // ±1% at 95%
+#define SEQ_FIXED        9604 // playouts a fixed count needs for ±1% at 95% when p = 0.5
+
+// whole-race odds and ticket comparisons at a target precision against the fixed count that guarantees it
+void bench_sequential(void) {
+    LegCorpus corpus = leg_corpus();
+    Rng rng          = {.state = 3};
+    double p_first[N_BETS_COLORS], p_last[N_BETS_COLORS];
+
+    // every probability, then only the current leader's chance to win the race
+    int queries = 0;
+    for (int pass = 0; pass < 2; pass++) {
+        long samples   = 0;
+        uint64_t start = now_ns();
+        for (int i = 0; i < corpus.n; i += SEQ_BENCH_STRIDE) {
+            int first, second;
+            get_top_camels(&corpus.positions[i], &first, &second);
+            unsigned watch = pass == 0 ? SEQ_WATCH_ALL : SEQ_WATCH_FIRST(first);
+            samples += race_odds_within(&corpus.positions[i], &rng, watch, SEQ_HALF_WIDTH, 0.95, SEQ_FIXED, p_first,
+                                        p_last);
+        }
+        uint64_t ns = now_ns() - start;
+        queries     = (corpus.n + SEQ_BENCH_STRIDE - 1) / SEQ_BENCH_STRIDE;
+        printf("  %-13s %5.0f playouts/query, %6.2f ms per query\n", pass == 0 ? "all odds:" : "leader wins:",
+               (double) samples / queries, (double) ns / 1e6 / queries);
+    }
+
+    uint64_t start = now_ns();
+    for (int i = 0; i < corpus.n; i += SEQ_BENCH_STRIDE) {
+        race_odds(&corpus.positions[i], &rng, 1e9, SEQ_FIXED, p_first, p_last);
+    }
+    uint64_t fixed_ns = now_ns() - start;
+    printf("  %-13s %5d playouts/query, %6.2f ms per query\n", "fixed:", SEQ_FIXED, (double) fixed_ns / 1e6 / queries);
+
+    // the leader's ticket against the runner-up's, decided or shown to be within 0.1 coins
+    long compare_samples = 0;
+    int decided          = 0;
+    start                = now_ns();
+    for (int i = 0; i < corpus.n; i += SEQ_BENCH_STRIDE) {
+        int first, second;
+        get_top_camels(&corpus.positions[i], &first, &second);
+        Bet a        = {.kind = BET_TICKET, .color = (BetColor) first};
+        Bet b        = {.kind = BET_TICKET, .color = (BetColor) second};
+        Comparison c = race_compare(&corpus.positions[i], &rng, a, b, 0.1, 0.95, SEQ_FIXED);
+        compare_samples += c.samples;
+        decided += c.verdict != 0;
+    }
+    uint64_t compare_ns = now_ns() - start;
+    printf("  %-13s %5.0f playouts/query, %6.2f ms per query, %.1f%% decided\n", "ticket A/B:",
+           (double) compare_samples / queries, (double) compare_ns / 1e6 / queries, 100.0 * decided / queries);
+    free(corpus.positions);
+}
+
+//////////////////////////////////// Variance Reduction //////////////////////////////////////
+
+#define VR_STRIDE     16   // every 16th corpus position
+#define VR_REPLICATES 20   // independent estimates per position and mode
+#define VR_SAMPLES    1024 // playouts per estimate
+
+// spread of race_odds_sampled estimates per mode, and how much CPU each needs for plain sampling's precision
+void bench_variance(void) {
+    LegCorpus corpus = leg_corpus();
+    double plain_cost = 0.0;
+    for (int mode = 0; mode < N_SAMPLE_MODES; mode++) {
+        Rng rng         = {.state = 9};
+        double variance = 0.0; // summed over first and last of every color, averaged over positions
+        int positions   = 0;
+        uint64_t ns     = 0;
+        for (int i = 0; i < corpus.n; i += VR_STRIDE, positions++) {
+            double sum[2 * N_BETS_COLORS] = {0}, sum_sq[2 * N_BETS_COLORS] = {0};
+            for (int r = 0; r < VR_REPLICATES; r++) {
+                double p[2 * N_BETS_COLORS];
+                DiceSampler sampler;
+                uint64_t start = now_ns();
+                sampler_init(&sampler, (SampleMode) mode, &corpus.positions[i], &rng);
+                race_odds_sampled(&corpus.positions[i], &sampler, VR_SAMPLES, p, p + N_BETS_COLORS);
+                ns += now_ns() - start;
+                for (int k = 0; k < 2 * N_BETS_COLORS; k++) {
+                    sum[k] += p[k];
+                    sum_sq[k] += p[k] * p[k];
+                }
+            }
+            for (int k = 0; k < 2 * N_BETS_COLORS; k++) {
+                double mean = sum[k] / VR_REPLICATES;
+                variance += (sum_sq[k] - VR_REPLICATES * mean * mean) / (VR_REPLICATES - 1);
+            }
+        }
+        variance /= positions;
+        double seconds = (double) ns / 1e9 / (positions * VR_REPLICATES);
+        double cost    = variance * seconds; // lower is better: CPU-seconds to reach unit variance
+        if (mode == SAMPLE_PLAIN) {
+            plain_cost = cost;
+        }
+        printf("  %-10s variance %.3e, %6.2f ms per estimate, %.2fx plain's efficiency\n",
+               sample_mode_name((SampleMode) mode), variance, seconds * 1e3, plain_cost / cost);
+    }
+    free(corpus.positions);
+}
+
+//////////////////////////////////// Placement //////////////////////////////////////
+
+#define SCALING_DEALS 40
+
+// tournament throughput on one pinned thread, then on every core of the first 1, 2, .. nodes
+void bench_scaling(void) {
+    const Topology* topo = get_topology();
+    const char* kinds[]  = {"explicit huge pages", "transparent huge pages", "no huge pages"};
+    LegCache cache;
+    leg_cache_init(&cache, 18, true);
+    printf("  %d cpus on %d nodes, leg cache on %s\n", topo->n_cpus, topo->n_nodes, kinds[cache.table.kind]);
+    leg_cache_free(&cache);
+
+    // one core, then whole nodes added one at a time
+    int steps[PLACEMENT_MAX_NODES + 1] = {1};
+    for (int n = 0; n < topo->n_nodes; n++) {
+        steps[n + 1] = steps[n] - (n == 0) + topo->node_cpus[n];
+    }
+
+    bool saved    = placement.pin;
+    placement.pin = true;
+    double single = 0.0;
+    for (int s = 0; s <= topo->n_nodes; s++) {
+        TournamentConfig config = {.deals = SCALING_DEALS * steps[s], .threads = steps[s], .seed = 1, .n_entrants = 2};
+        config.entrants[0]      = camels_builtin_entrants[0];
+        config.entrants[1]      = camels_builtin_entrants[1];
+        TournamentResult result;
+        camels_tournament(&config, &result);
+        double rate = (double) result.games / result.seconds;
+        single      = s == 0 ? rate : single;
+        char label[16];
+        snprintf(label, sizeof(label), s == 0 ? "1 core" : "%d node%s", s, s > 1 ? "s" : "");
+        printf("  %-8s %3d threads: %8.0f games/s, %5.2fx one core, %3.0f%% per thread\n", label, steps[s], rate,
+               rate / single, 100.0 * rate / single / steps[s]);
+    }
+    placement.pin = saved;
+}
+
+//////////////////////////////////// Stack Moves //////////////////////////////////////
+
+#define MOVE_GAMES 4096
+#define MOVE_STEPS 64
+
+// random moves over dealt boards, through move_camel with each stack kernel
+void bench_moves(void) {
+    static Game start[MOVE_GAMES], game;
+    static int8_t moves[MOVE_STEPS][2];
+    Rng rng = {.state = 5};
+    for (int g = 0; g < MOVE_GAMES; g++) {
+        camels_game_rng = &rng;
+        camels_init_game(&start[g]);
+        camels_game_rng = NULL;
+    }
+    for (int s = 0; s < MOVE_STEPS; s++) {
+        moves[s][0] = (int8_t) rng_range(&rng, 0, N_CAMELS - 1);
+        moves[s][1] = (int8_t) rng_range(&rng, -3, 3);
+    }
+
+    StackMover movers[2] = {move_stack, move_stack_block};
+    const char* names[2] = {"pop/push", "block"};
+    uint64_t checksum    = 0;
+    for (int k = 0; k < 2; k++) {
+        uint64_t start_ns = now_ns();
+        for (int g = 0; g < MOVE_GAMES; g++) {
+            game = start[g];
+            for (int s = 0; s < MOVE_STEPS; s++) {
+                move_camel_with(&game, (CamelColor) moves[s][0], moves[s][1], movers[k]);
+            }
+            checksum += (uint64_t) get_camel(&game, CRED)->space;
+        }
+        uint64_t ns = now_ns() - start_ns;
+        printf("  %-8s %6.1fM moves/s\n", names[k], per_second((uint64_t) MOVE_GAMES * MOVE_STEPS, ns) / 1e6);
+    }
+
+    // the kernels alone, every split of the seven camels between two tiles, in both directions
+    static CamelStack stacks[2 * N_CAMELS][2];
+    int n_pairs = 0;
+    for (int below = 0; below < N_CAMELS; below++) {
+        for (int o = 0; o < 2; o++, n_pairs++) {
+            CamelStack* pair = stacks[n_pairs];
+            pair[0]          = (CamelStack) {.capacity = N_CAMELS};
+            pair[1]          = (CamelStack) {.capacity = N_CAMELS};
+            for (int c = 0; c < N_CAMELS; c++) {
+                Camel camel = {.color = (uint8_t) c, .orientation = (uint8_t) o, .space = c < below ? 1 : 0};
+                stack_push(c < below ? &pair[1] : &pair[0], camel);
+            }
+        }
+    }
+    for (int k = 0; k < 2; k++) {
+        uint64_t start_ns = now_ns();
+        for (int r = 0; r < 20000; r++) {
+            for (int p = 0; p < n_pairs; p++) {
+                CamelStack from = stacks[p][0], to = stacks[p][1];
+                movers[k](&from, &to, (CamelColor) (N_CAMELS - 1 - r % 3), 1, (Orientation) (p % 2));
+                checksum += to.count;
+            }
+        }
+        uint64_t ns = now_ns() - start_ns;
+        printf("  %-8s %6.1fM kernel calls/s\n", names[k], per_second((uint64_t) 20000 * (uint64_t) n_pairs, ns) / 1e6);
+    }
+    printf("  (checksum %lu)\n", (unsigned long) checksum);
+}
+
+// ranks and unranks of the positions of a few bot games, against the leg cache's key and hash
+void bench_ranking(void) {
+    LegCorpus corpus = leg_corpus();
+    static Game game;
+    uint64_t* ranks   = malloc((size_t) corpus.n * sizeof(uint64_t));
+    uint64_t checksum = 0;
+    int rounds        = 200;
+
+    uint64_t start = now_ns();
+    for (int r = 0; r < rounds; r++) {
+        for (int i = 0; i < corpus.n; i++) {
+            ranks[i] = race_rank(&corpus.positions[i], true);
+            checksum += ranks[i];
+        }
+    }
+    uint64_t ns = now_ns() - start;
+    printf("  race_rank    %6.1fM/s\n", per_second((uint64_t) rounds * (uint64_t) corpus.n, ns) / 1e6);
+
+    start = now_ns();
+    for (int r = 0; r < rounds; r++) {
+        for (int i = 0; i < corpus.n; i++) {
+            race_unrank(ranks[i], true, &game);
+            checksum += game.board[BOARD_SIZE - 1].camel_stack.count;
+        }
+    }
+    ns = now_ns() - start;
+    printf("  race_unrank  %6.1fM/s\n", per_second((uint64_t) rounds * (uint64_t) corpus.n, ns) / 1e6);
+
+    start = now_ns();
+    for (int r = 0; r < rounds; r++) {
+        for (int i = 0; i < corpus.n; i++) {
+            LegKey key;
+            uint8_t perm[N_BETS_COLORS];
+            leg_key(&corpus.positions[i], false, &key, perm);
+            checksum += leg_key_hash(&key);
+        }
+    }
+    ns = now_ns() - start;
+    printf("  leg_key+hash %6.1fM/s\n", per_second((uint64_t) rounds * (uint64_t) corpus.n, ns) / 1e6);
+    printf("  (checksum %lu)\n", (unsigned long) checksum);
+    free(ranks);
+    free(corpus.positions);
+}
+
+// depth reached and nodes searched per second on positions of a few bot games, each mode under the same budget
+void bench_search(void) {
+    LegCorpus corpus = leg_corpus();
+    const char* names[2] = {"max-n", "paranoid"};
+    for (int m = 0; m < 2; m++) {
+        static Searcher s;
+        camels_searcher_init(&s, (SearchConfig) {.mode = (SearchMode) m, .budget_ms = 20.0});
+        uint64_t nodes = 0, cutoffs = 0, probes = 0;
+        double seconds = 0.0;
+        int searches = 0, depth = 0;
+        for (int i = 0; i < corpus.n; i += 50) {
+            Turn turn;
+            search_best(&s, &corpus.positions[i], corpus.positions[i].turn % N_PLAYERS, &turn);
+            nodes += s.stats.nodes;
+            cutoffs += s.stats.cutoffs;
+            probes += s.stats.probe_cutoffs;
+            seconds += s.stats.seconds;
+            depth += s.stats.depth;
+            searches++;
+        }
+        printf("  %-8s  depth %4.1f  %6.2fM nodes/s  %6.0f nodes/search  %5.0f cuts  %5.0f probe cuts\n", names[m],
+               (double) depth / searches, (double) nodes / seconds / 1e6, (double) nodes / searches,
+               (double) cutoffs / searches, (double) probes / searches);
+        camels_searcher_free(&s);
+    }
+    free(corpus.positions);
+}
+
+//////////////////////////////////// Runner //////////////////////////////////////
+
+static Bench benches[] = {
+    {"eval", bench_eval},
+    {"self_play", bench_self_play},
+    {"export", bench_export},
+    {"sessions", bench_sessions},
+    {"forks", bench_forks},
+    {"leg_cache", bench_leg_cache},
+    {"approx_leg", bench_approx_leg},
+    {"leg_tracker", bench_leg_tracker},
+    {"batch", bench_batch},
+    {"shm", bench_shm},
+    {"sequential", bench_sequential},
+    {"variance", bench_variance},
+    {"scaling", bench_scaling},
+    {"moves", bench_moves},
+    {"ranking", bench_ranking},
+    {"search", bench_search},
+};
+
+int main(int argc, char** argv) {
+    printf("=== Camel Up Benchmarks ===\n\n");
+    for (size_t i = 0; i < sizeof(benches) / sizeof(benches[0]); i++) {
+        if (argc > 1 && strcmp(argv[1], benches[i].name) != 0) {
+            continue;
+        }
+        printf("%s\n", benches[i].name);
+        benches[i].run();
+    }
+    return 0;
+}
@@ -0,0 +1,105 @@
+// libcamels: the Camel Up engine as a library, built by `make lib` into bin/libcamels.a and bin/libcamels.so.
+//
+// A CamelsGame is an opaque handle to one game. camels_poll advances it until a human seat has to move, a leg
+// is scored, or the event buffer is full; camels_submit hands in that human's turn. Bot seats move inside
+// camels_poll. Nothing blocks and each game draws its dice from its own seeded stream, so games on different
+// threads are independent. A handle itself is not thread safe.
+//
+// The ABI is versioned by CAMELS_ABI_VERSION: structs here only grow at the end and enum values never change.
+
+#ifndef CAMELS_H
+#define CAMELS_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#if defined(__GNUC__)
+#define CAMELS_API __attribute__((visibility("default")))
+#else
+#define CAMELS_API
+#endif
+
+#define CAMELS_ABI_VERSION 1
+
+#define CAMELS_PLAYERS    6
+#define CAMELS_COLORS     5  // racing camels, the ones tickets and wagers are on
+#define CAMELS_SPACES     17 // 16 track spaces and the finish
+#define CAMELS_MAX_TURNS  48 // most turns a player can have on offer
+#define CAMELS_STATE_SIZE 512
+
+typedef struct CamelsGame CamelsGame;
+
+typedef enum { CAMELS_RED, CAMELS_BLUE, CAMELS_YELLOW, CAMELS_GREEN, CAMELS_PURPLE } CamelsColor;
+typedef enum { CAMELS_WAGER, CAMELS_ROLL, CAMELS_TICKET, CAMELS_SPECTATOR } CamelsTurnType;
+typedef enum { CAMELS_HUMAN, CAMELS_RANDOM_BOT, CAMELS_GREEDY_BOT } CamelsSeat;
+
+typedef enum {
+    CAMELS_AWAIT_TURN,  // player has to submit a turn
+    CAMELS_TURN,        // player made turn
+    CAMELS_REJECTED,    // player's turn was not allowed, an AWAIT_TURN follows
+    CAMELS_LEG_SCORED,  // first and second are the leg's leaders
+    CAMELS_ROUND_ENDED, // the next leg has been set up
+    CAMELS_GAME_OVER
+} CamelsEventType;
+
+typedef struct {
+    CamelsTurnType type;
+    bool winner;  // WAGER: on the overall winner, else the overall loser
+    bool forward; // SPECTATOR: the +1 side
+    int color;    // WAGER and TICKET
+    int space;    // SPECTATOR
+} CamelsTurn;
+
+typedef struct {
+    CamelsEventType type;
+    int player;
+    CamelsTurn turn;
+    int first;
+    int second;
+} CamelsEvent;
+
+typedef struct {
+    double first[CAMELS_COLORS]; // chance each camel leads when the leg ends
+    double second[CAMELS_COLORS];
+    double last[CAMELS_COLORS];
+} CamelsOdds;
+
+// CAMELS_ABI_VERSION of the library actually loaded
+CAMELS_API int camels_abi_version(void);
+
+// a new game dealt from seed, NULL when out of memory. seats[i] says who plays seat i
+CAMELS_API CamelsGame* camels_new(uint64_t seed, const CamelsSeat seats[CAMELS_PLAYERS]);
+// a game from a camels_state string, NULL when the string is not a valid state. Every seat is human
+CAMELS_API CamelsGame* camels_load(const char* state);
+CAMELS_API CamelsGame* camels_clone(const CamelsGame* game);
+CAMELS_API void camels_free(CamelsGame* game);
+
+// advances the game and moves up to max events into out, returns how many
+CAMELS_API int camels_poll(CamelsGame* game, CamelsEvent* out, int max);
+// false if it is not player's turn or the turn is not allowed
+CAMELS_API bool camels_submit(CamelsGame* game, int player, const CamelsTurn* turn);
+// the turns player could make now, writes at most CAMELS_MAX_TURNS. 0 for a player out of range
+CAMELS_API int camels_legal_turns(const CamelsGame* game, int player, CamelsTurn out[CAMELS_MAX_TURNS]);
+
+// whose turn it is, -1 once the game is over
+CAMELS_API int camels_to_move(const CamelsGame* game);
+// -1 for a player out of range
+CAMELS_API int camels_points(const CamelsGame* game, int player);
+// space of a racing camel, CAMELS_SPACES - 1 once it has crossed the finish, -1 for a color out of range
+CAMELS_API int camels_space(const CamelsGame* game, int color);
+CAMELS_API int camels_round(const CamelsGame* game);
+// exact odds of how the current leg ends
+CAMELS_API void camels_leg_odds(const CamelsGame* game, CamelsOdds* odds);
+// the position as one line of text (see Engine Protocol in the sources), false when size is too small
+CAMELS_API bool camels_state(const CamelsGame* game, char* buf, size_t size);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // CAMELS_H
@@ -0,0 +1,5509 @@
+// #define DYNAMIC_ARRAY_IMPLEMENTATION
+// #include "da.h"
+
+#include <assert.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <math.h>
+#include <pthread.h>
+#include <sched.h>
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "engine.h"
+
+#ifdef __SSE__
+#include <xmmintrin.h>
+#endif
+
+/*
+TODO:
+- convert Orientation to bool
+- break main and get_user_input into smaller functions
+*/
+
+bool camels_log_enabled = false; // stderr belongs to the host, the terminal frontend turns it on
+
+//////////////////////////////////// Stack //////////////////////////////////////
+
+//////////////////////////////////// Stats //////////////////////////////////////
+// Hot-path counters, compiled in with -DCAMELS_STATS (make STATS=1). Each thread counts into its own
+// stats_local and folds it into camels_stats_total with camels_stats_merge; without the flag the STAT_* macros
+// are empty
+
+_Thread_local Stats stats_local;
+Stats camels_stats_total;
+pthread_mutex_t stats_lock = PTHREAD_MUTEX_INITIALIZER;
+
+void stats_record_turn(uint64_t ns) {
+    int bucket = 0;
+    while (bucket < STAT_LATENCY_BUCKETS - 1 && (ns >> (bucket + 1)) > 0) {
+        bucket++;
+    }
+    stats_local.turn_latency[bucket]++;
+    stats_local.turn_ns += ns;
+    if (ns > stats_local.turn_ns_max) {
+        stats_local.turn_ns_max = ns;
+    }
+}
+
+// fold this thread's counters into camels_stats_total and zero them
+void camels_stats_merge(void) {
+    pthread_mutex_lock(&stats_lock);
+    uint64_t* dst = (uint64_t*) &camels_stats_total;
+    uint64_t* src = (uint64_t*) &stats_local;
+    for (size_t i = 0; i < sizeof(Stats) / sizeof(uint64_t); i++) {
+        dst[i] += src[i];
+    }
+    // maxima do not add up
+    camels_stats_total.move_carried_max -= stats_local.move_carried_max;
+    camels_stats_total.turn_ns_max -= stats_local.turn_ns_max;
+    if (stats_local.move_carried_max > camels_stats_total.move_carried_max) {
+        camels_stats_total.move_carried_max = stats_local.move_carried_max;
+    }
+    if (stats_local.turn_ns_max > camels_stats_total.turn_ns_max) {
+        camels_stats_total.turn_ns_max = stats_local.turn_ns_max;
+    }
+    pthread_mutex_unlock(&stats_lock);
+    stats_local = (Stats) {0};
+}
+
+void camels_stats_dump(FILE* out, Stats* s) {
+    fprintf(out, "move_camel.calls %lu\n", (unsigned long) s->move_calls);
+    fprintf(out, "move_camel.carried %lu\n", (unsigned long) s->move_carried);
+    fprintf(out, "move_camel.carried_max %lu\n", (unsigned long) s->move_carried_max);
+    fprintf(out, "move_camel.reverse_inserts %lu\n", (unsigned long) s->reverse_inserts);
+    fprintf(out, "move_camel.spectator_hits %lu\n", (unsigned long) s->spectator_hits);
+    fprintf(out, "get_camel.calls %lu\n", (unsigned long) s->get_camel_calls);
+    fprintf(out, "get_camel.scanned %lu\n", (unsigned long) s->get_camel_scanned);
+    fprintf(out, "score_round.calls %lu\n", (unsigned long) s->score_round_calls);
+    fprintf(out, "assign_points.calls %lu\n", (unsigned long) s->assign_points_calls);
+    fprintf(out, "score_wagers.calls %lu\n", (unsigned long) s->score_wagers_calls);
+    fprintf(out, "next_turn.turns %lu\n", (unsigned long) s->turns);
+    fprintf(out, "next_turn.invalid %lu\n", (unsigned long) s->invalid_turns);
+    fprintf(out, "next_turn.ns_total %lu\n", (unsigned long) s->turn_ns);
+    fprintf(out, "next_turn.ns_max %lu\n", (unsigned long) s->turn_ns_max);
+    for (int b = 0; b < STAT_LATENCY_BUCKETS; b++) {
+        if (s->turn_latency[b] > 0) {
+            fprintf(out, "next_turn.latency_ns[%lu,%lu) %lu\n", 1UL << b, 1UL << (b + 1),
+                    (unsigned long) s->turn_latency[b]);
+        }
+    }
+}
+
+#ifdef CAMELS_STATS
+#define STAT_ADD(field, n) (stats_local.field += (uint64_t) (n))
+#define STAT_MAX(field, n) (stats_local.field = (uint64_t) (n) > stats_local.field ? (uint64_t) (n) : stats_local.field)
+#define STAT_TIMER(t)      uint64_t t = now_ns()
+#define STAT_TURN(t)       stats_record_turn(now_ns() - (t))
+#else
+#define STAT_ADD(field, n) ((void) 0)
+#define STAT_MAX(field, n) ((void) 0)
+#define STAT_TIMER(t)      ((void) 0)
+#define STAT_TURN(t)       ((void) 0)
+#endif
+
+//////////////////////////////////// Game State //////////////////////////////////////
+
+int hand_size(Player* player) { return __builtin_popcount(player->hand); }
+
+bool remove_card_from_hand(Player* player, BetColor color) {
+    uint8_t card = (uint8_t) (1u << color);
+    if (!(player->hand & card)) {
+        return false;
+    }
+    player->hand = (uint8_t) (player->hand & ~card);
+    return true;
+}
+
+void init_player_hand(Player* player) { player->hand = FULL_HAND; }
+
+bool has_card_in_hand(Player* player, BetColor color) { return (player->hand >> color) & 1u; }
+
+void add_points(Player* player, int amount) { player->points = (int16_t) (player->points + amount); }
+
+// when set, the game's own draws (camel setup and dice) come from this thread's stream instead of rand(),
+// so bot games are reproducible and can run on any thread
+_Thread_local Rng* camels_game_rng = NULL;
+
+int rand_range(int low, int high) {
+    if (camels_game_rng != NULL) {
+        return rng_range(camels_game_rng, low, high);
+    }
+    return (rand() % (high - low + 1)) + low;
+}
+
+void reset_tickets(Game* game) {
+    static const int8_t amounts[N_TICKETS] = {5, 3, 2, 2};
+
+    for (int i = 0; i < N_BETS_COLORS; i++) {
+        TicketStack* tickets = &game->tickets[i];
+        tickets->count       = 0; // ← Reset count
+        tickets->top         = 0;
+        for (int j = 0; j < N_TICKETS; j++) {
+            Ticket t = {.amount = amounts[j], .player_id = -1};
+            stack_push(tickets, t);
+        }
+    }
+}
+
+void reset_dice(Game* game) {
+    Dice dice     = {0};
+    dice.capacity = N_DICE;
+    game->dice    = dice;
+}
+
+void camels_init_game(Game* game) {
+    game->turn = 0;
+    reset_dice(game);
+    game->winner = false;
+
+    ///// set up board /////////
+    for (int i = 0; i < BOARD_SIZE; i++) {
+        CamelStack cs              = {0};
+        cs.capacity                = N_CAMELS;
+        game->board[i].camel_stack = cs;
+        game->board[i].has_spec    = false;
+    }
+
+    ///// Place camels on board /////////
+    for (int c = 0; c < N_CAMELS; c++) {
+        int starting_tile = rand_range(0, 2);
+        Camel camel       = {0};
+        camel.color       = (CamelColor) c;
+        camel.orientation = FORWARD;
+
+        if ((CamelColor) c == CBLACK || (CamelColor) c == CWHITE) {
+            starting_tile     = BOARD_SIZE - starting_tile - 2;
+            camel.orientation = REVERSE;
+        }
+        camel.space   = (int8_t) starting_tile;
+        CamelStack* s = &game->board[starting_tile].camel_stack;
+        stack_push(s, camel);
+    }
+
+    ///// Players /////////
+    for (int i = 0; i < N_PLAYERS; i++) {
+        Player p         = {.id = (uint8_t) i, .points = 0, .used_spec = false, .hand = FULL_HAND};
+        game->players[i] = p;
+    }
+    for (int i = 0; i < N_BETS_COLORS; i++) {
+        game->tickets[i].capacity = N_TICKETS;
+        game->tickets[i].count    = 0;
+    }
+    reset_tickets(game);
+
+    ///// Wagers /////////
+    WagerStack losing_bets = {0};
+    losing_bets.capacity   = MAX_WAGERS;
+    game->loser_bets       = losing_bets;
+
+    WagerStack winning_bets = {0};
+    winning_bets.capacity   = MAX_WAGERS;
+    game->winner_bets       = winning_bets;
+}
+
+// points for a correct wager with `correct_ahead` correct wagers before it in the queue
+int wager_payout(int correct_ahead) {
+    int scores[5] = {8, 5, 3, 2, 1}; // Points for 1st, 2nd, 3rd, 4th, 5th+ correct wagers
+    // Use the score corresponding to their order, floor at 1 point
+    return (correct_ahead < 5) ? scores[correct_ahead] : 1;
+}
+
+void score_wagers(Game* game, BetColor first, BetColor last) {
+    STAT_ADD(score_wagers_calls, 1);
+    // Process Winner Bets FIFO
+    int winner_idx = 0;
+    for (size_t i = 0; i < game->winner_bets.count; i++) {
+        Wager w = game->winner_bets.items[i];
+        if (w.color == first) {
+            add_points(&game->players[w.player], wager_payout(winner_idx));
+            winner_idx++;
+        } else {
+            game->players[w.player].points--;
+        }
+    }
+
+    // Process Loser Bets FIFO
+    int loser_idx = 0;
+    for (size_t i = 0; i < game->loser_bets.count; i++) {
+        Wager w = game->loser_bets.items[i];
+        if (w.color == last) {
+            add_points(&game->players[w.player], wager_payout(loser_idx));
+            loser_idx++;
+        } else {
+            game->players[w.player].points--;
+        }
+    }
+    // resset for testing
+    game->winner_bets.count = 0; //
+    game->loser_bets.count  = 0; //
+}
+
+void assign_points(Game* game, CamelColor top, CamelColor second) {
+    STAT_ADD(assign_points_calls, 1);
+
+    // assign points to anyone holding a winning color ticket
+    for (int i = 0; i < N_BETS_COLORS; i++) {
+        for (int j = 0; j < game->tickets[i].top; j++) {
+            Ticket t       = game->tickets[i].items[j];
+            Player* holder = &game->players[t.player_id];
+            if (i == (int) top) {
+                add_points(holder, t.amount); // give points to winner
+            } else if (i == (int) second) {
+                add_points(holder, 1); // give 1 point for second
+            } else {
+                add_points(holder, -1); // minus 1 point for 3rd or worse
+            }
+        }
+    }
+}
+
+// last place is the lowest racing camel on the rearmost occupied tile
+int get_last_camel(Game* game) {
+    for (int b = 0; b < BOARD_SIZE; b++) {
+        CamelStack* stack = &game->board[b].camel_stack;
+        for (size_t j = 0; j < stack_count(stack); j++) {
+            CamelColor bottom = stack->items[j].color;
+            if (bottom != CBLACK && bottom != CWHITE) {
+                return (int) bottom;
+            }
+        }
+    }
+    return -1;
+}
+
+void get_top_camels(Game* game, int* first, int* second) {
+
+    // get top_camel and second place dont count black and white camel
+    *first  = -1;
+    *second = -1;
+
+    for (size_t b = BOARD_SIZE; b > 0; b--) {
+        CamelStack* stack = &game->board[b - 1].camel_stack;
+        for (size_t j = stack_count(stack); j > 0; j--) {
+            CamelColor top = stack->items[j - 1].color;
+            if (top != CBLACK && top != CWHITE) {
+                if (*first == -1) {
+                    *first = (int) top;
+                } else {
+                    *second = (int) top;
+                    return;
+                }
+            }
+        }
+    }
+}
+
+void score_round(Game* game, int* first, int* second) {
+    STAT_ADD(score_round_calls, 1);
+    get_top_camels(game, first, second);
+    assign_points(game, (CamelColor) *first, (CamelColor) *second);
+
+    if (game->winner) {
+        int last = get_last_camel(game);
+        assert(last != -1 && "Could not get losing camel");
+        score_wagers(game, (BetColor) *first, (BetColor) last);
+    }
+}
+
+void end_round(Game* game) {
+    game->round++;
+    reset_dice(game);
+
+    // remove spec cards
+    for (int i = 0; i < N_PLAYERS; i++) {
+        game->players[i].used_spec = false;
+    }
+
+    for (int i = 0; i < BOARD_SIZE; i++) {
+        game->board[i].has_spec = false;
+    }
+    reset_tickets(game);
+}
+
+//////////////////////////////////// Turn //////////////////////////////////////
+
+// hands the best ticket left on the stack to player_id, -1 if none are left
+int take_ticket(TicketStack* tickets, int player_id) {
+    if (tickets->top == tickets->count) {
+        return -1;
+    }
+    Ticket* t    = &tickets->items[tickets->top++];
+    t->player_id = (int8_t) player_id;
+    return t->amount;
+}
+
+// the best ticket left for color, NULL once the stack is dealt out
+Ticket* top_ticket(TicketStack* tickets) {
+    return tickets->top < tickets->count ? &tickets->items[tickets->top] : NULL;
+}
+
+// -1 if ticket is not available, else the amount
+int assign_ticket(Game* game, BetColor color, int player_id) {
+    return take_ticket(&game->tickets[(int) color], player_id);
+}
+
+
+void get_available_tickets(Game* game, TicketStack* tickets) {
+    for (int i = 0; i < N_BETS_COLORS; i++) {
+        for (int j = game->tickets[i].top; j < game->tickets[i].count; j++) {
+            stack_push(tickets, game->tickets[i].items[j]);
+        }
+    }
+}
+
+void get_possible_spec_location(Game* game, Locations* buff) {
+    for (int i = 0; i < BOARD_SIZE - 1; i++) { // cant put peice on last spot
+        if (!(stack_count((&game->board[i].camel_stack)) > 0 || game->board[i].has_spec ||
+              (i != BOARD_SIZE && game->board[i + 1].has_spec) || (i != 0 && game->board[i - 1].has_spec))) {
+            stack_push(buff, i);
+        }
+    }
+}
+
+bool place_spec_tile(Game* game, int player_id, int space, Spectator spec) {
+
+    if (game->players[player_id].used_spec || space < 0 || space >= BOARD_SIZE - 1) {
+        return false;
+    }
+
+    // check if spec next to tile or on tile
+    if (stack_count((&game->board[space].camel_stack)) > 0 || game->board[space].has_spec ||
+        (space != BOARD_SIZE && game->board[space + 1].has_spec) || (space != 0 && game->board[space - 1].has_spec)) {
+        return false;
+    }
+    game->board[space].has_spec          = true;
+    game->board[space].spec              = spec;
+    game->players[player_id].used_spec = true;
+    return true;
+}
+
+// dice still in the pyramid this leg, returns how many were written to buff (at most N_DICE + 1)
+int remaining_dice(Game* game, DiceColor* buff) {
+    int n = 0;
+    for (int d = 0; d <= (int) DGREY; d++) {
+        bool rolled = false;
+        for (size_t i = 0; i < game->dice.count; i++) {
+            CamelColor c = game->dice.items[i].color;
+            if ((c == CBLACK || c == CWHITE) ? d == (int) DGREY : d == (int) c) {
+                rolled = true;
+            }
+        }
+        if (!rolled) {
+            buff[n++] = (DiceColor) d;
+        }
+    }
+    return n;
+}
+
+// crazy: 0 or 1 picks white or black when the grey die comes up, value is 1-3
+Roll die_face(DiceColor color, int crazy, int value) {
+    Roll die = {0};
+    if (color == DGREY) {
+        die.color = (CamelColor) (crazy + N_BETS_COLORS);
+        die.value = (int8_t) -value;
+    } else {
+        die.color = (CamelColor) color;
+        die.value = (int8_t) value;
+    }
+    return die;
+}
+
+void roll_dice(Game* game) {
+    DiceColor left[N_DICE + 1];
+    int n = remaining_dice(game, left);
+    assert(n > 0 && "No dice left in the pyramid");
+
+    DiceColor random_color = left[rand_range(0, n - 1)];
+    // if Grey randomly select 0 or 1 for black or white
+    int crazy = random_color == DGREY ? rand_range(0, 1) : 0;
+
+    stack_push(&game->dice, die_face(random_color, crazy, rand_range(1, 3)));
+}
+
+Camel* get_camel(Game* game, CamelColor color) {
+    STAT_ADD(get_camel_calls, 1);
+
+    for (int i = 0; i < BOARD_SIZE; i++) {
+        CamelStack* stack = &game->board[i].camel_stack;
+        for (size_t j = 0; j < stack_count(stack); j++) {
+            STAT_ADD(get_camel_scanned, 1);
+            if (stack->items[j].color == color) {
+                return &stack->items[j];
+            }
+        }
+    }
+    return NULL;
+}
+
+// spaces moved once a spectator on the landing tile is applied
+int spectator_spaces(Spectator spec, Orientation camel_orientation, int spaces) {
+    if (spec.orientation == camel_orientation) { // forward and +1 or reverse and -1
+        return spaces + 1;
+    }
+    return spaces - 1;
+}
+
+// lifts color and every camel above it off stack and drops them on dest_stack (tile dest),
+// on top when moving forward, underneath when moving in reverse
+void move_stack(CamelStack* stack, CamelStack* dest_stack, CamelColor color, int dest, Orientation move_orientation) {
+    // move all camels in stack to dest
+    CamelStack tmp   = {0};
+    tmp.capacity     = N_CAMELS;
+    CamelStack tmp2  = {0}; // only used if going backwards
+    tmp2.capacity    = N_CAMELS;
+    Camel curr_camel = {0};
+
+    bool match_found = false;
+    while (!match_found && stack->count > 0) { // pop from start stack until we reach desired camel
+        stack_pop(stack, &curr_camel);
+        match_found = curr_camel.color == color ? true : false;
+        stack_push(&tmp, curr_camel);
+    }
+    STAT_ADD(move_calls, 1);
+    STAT_ADD(move_carried, tmp.count);
+    STAT_MAX(move_carried_max, tmp.count);
+
+    // if camels are going in reverse, pop the dest stack into a tmp stack, then push start stack into dest and then
+    // push dest stack
+    if (move_orientation == REVERSE) {
+        STAT_ADD(reverse_inserts, 1);
+        while (!stack_empty(dest_stack)) {
+            stack_pop(dest_stack, &curr_camel);
+            stack_push(&tmp2, curr_camel);
+        }
+    }
+
+    while (!stack_empty(&tmp)) {
+        stack_pop(&tmp, &curr_camel);
+        // printf("pushed: %s ", enum2char(curr_camel.color));
+        curr_camel.space = (int8_t) dest;
+        stack_push(dest_stack, curr_camel);
+    }
+
+    if (move_orientation == REVERSE) {
+        while (!stack_empty(&tmp2)) {
+            stack_pop(&tmp2, &curr_camel);
+            curr_camel.space = (int8_t) dest;
+            stack_push(dest_stack, curr_camel);
+        }
+    }
+}
+
+// move_stack without the temporary stacks: the camels from color up are copied straight onto dest_stack, or
+// under it after shifting it up when moving in REVERSE. Only a stack moved onto itself goes through a
+// buffer. Same result as move_stack
+void move_stack_block(CamelStack* stack, CamelStack* dest_stack, CamelColor color, int dest,
+                      Orientation move_orientation) {
+    int from = stack->count;
+    while (from > 0 && stack->items[--from].color != color) {
+    }
+    int moving = stack->count - from;
+    STAT_ADD(move_calls, 1);
+    STAT_ADD(move_carried, moving);
+    STAT_MAX(move_carried_max, moving);
+
+    Camel carried[N_CAMELS];
+    const Camel* src = stack->items + from;
+    if (stack == dest_stack) {
+        memcpy(carried, src, (size_t) moving * sizeof(Camel));
+        src = carried;
+    }
+    stack->count = (uint8_t) from;
+
+    int below = dest_stack->count;
+    Camel* out = dest_stack->items + below;
+    if (move_orientation == REVERSE) {
+        STAT_ADD(reverse_inserts, 1);
+        for (int i = below - 1; i >= 0; i--) {
+            dest_stack->items[i + moving] = dest_stack->items[i];
+        }
+        out = dest_stack->items;
+    }
+    for (int i = 0; i < moving; i++) {
+        out[i]       = src[i];
+        out[i].space = (int8_t) dest;
+    }
+    dest_stack->count = (uint8_t) (below + moving);
+}
+
+typedef void (*StackMover)(CamelStack* stack, CamelStack* dest_stack, CamelColor color, int dest,
+                           Orientation move_orientation);
+
+// move_camel with the stack kernel given, so the kernels can be checked against each other
+void move_camel_with(Game* game, CamelColor color, int spaces, StackMover mover) {
+    int dest;
+    Camel* camel = get_camel(game, color);
+    assert(camel != NULL && "Could not find your camel");
+    int curr_space = camel->space;
+
+    Orientation move_orientation = camel->orientation;
+
+    // landing past either end of the board can never hit a spectator
+    int landing = curr_space + spaces;
+    if (landing >= 0 && landing < BOARD_SIZE - 1 && game->board[landing].has_spec) {
+        Spectator spec = game->board[landing].spec;
+        STAT_ADD(spectator_hits, 1);
+
+        move_orientation = spec.orientation;
+
+        game->players[spec.player].points++; // Give point to player who placed spec
+        spaces = spectator_spaces(spec, camel->orientation, spaces);
+    }
+    dest = curr_space + spaces;
+
+    if (dest < 0)
+        dest = 0;
+
+    if (dest >= BOARD_SIZE - 1) {
+        game->winner = true;
+        dest         = BOARD_SIZE - 1;
+    }
+
+    mover(&game->board[curr_space].camel_stack, &game->board[dest].camel_stack, color, dest, move_orientation);
+}
+
+void move_camel(Game* game, CamelColor color, int spaces) { move_camel_with(game, color, spaces, move_stack_block); }
+
+bool apply_turn(Game* game, Turn* turn, int curr_player_id) {
+
+    // get next players input
+    switch (turn->turn_type) {
+        case WAGER: {
+            LOG("Turn %d: %d made wagered %s to %s \n", game->turn, curr_player_id, enum2char((CamelColor) turn->color),
+                orient2char(turn->orientation));
+
+            if (!remove_card_from_hand(&game->players[curr_player_id], turn->color)) {
+                return false;
+            }
+
+            Wager w = {.color = (uint8_t) turn->color, .player = (uint8_t) curr_player_id};
+            if (turn->orientation == FORWARD) {
+                stack_push(&game->winner_bets, w);
+            } else {
+                stack_push(&game->loser_bets, w);
+            }
+
+            break;
+        }
+        case ROLL: {
+            roll_dice(game);
+            Roll die = stack_peak(&game->dice);
+            LOG("Turn %d: %d rolled %s%d\n", game->turn, curr_player_id, enum2char((CamelColor) die.color), die.value);
+            move_camel(game, die.color, die.value);
+            game->players[curr_player_id].points++;
+            break;
+        }
+        case TICKET: {
+            int amount = assign_ticket(game, turn->color, curr_player_id);
+            if (amount == -1) {
+                LOG("Turn %d: Could not assign ticket to %d", game->turn, curr_player_id);
+                return false;
+            }
+            LOG("Turn %d: %d picked a %s:%d Ticket", game->turn, curr_player_id, enum2char((CamelColor) turn->color),
+                amount);
+            break;
+        }
+
+        case SPECTATOR: {
+            Spectator spec = {.orientation = (uint8_t) turn->orientation, .player = (uint8_t) curr_player_id};
+            bool allowed   = place_spec_tile(game, curr_player_id, turn->position, spec);
+            if (!allowed) {
+                LOG("Turn %d: %d COULD NOT place Spectator card (%s1) on %d", game->turn, curr_player_id,
+                    orient2char(turn->orientation), turn->position);
+                return false;
+            }
+            LOG("Turn %d: %d placed Spectator card (%s1) on %d", game->turn, curr_player_id,
+                orient2char(turn->orientation), turn->position);
+            break;
+        }
+        default:
+            break;
+    }
+    return true;
+}
+
+// false if the turn is not allowed, the game is left untouched
+bool next_turn(Game* game, Turn* turn, int curr_player_id) {
+    STAT_TIMER(start);
+    bool valid = apply_turn(game, turn, curr_player_id);
+    STAT_ADD(turns, 1);
+    STAT_ADD(invalid_turns, !valid);
+    STAT_TURN(start);
+    return valid;
+}
+
+//////////////////////////////////// Placement //////////////////////////////////////
+// Where simulator threads run and where their memory lives. Worker threads call placement_enter, which
+// pins them to a core when pinning is on, filling one NUMA node before the next. It returns the node the
+// thread is on, and the worker takes its Game clone from that node's WorkerBlock pool. Blocks
+// are first touched by a thread of their node, so their pages stay on it. huge_alloc backs large tables
+// with explicit huge pages (MAP_HUGETLB), then transparent huge pages, then plain calloc, using the first
+// that works.
+// Pinning and huge pages are set by CAMELS_PIN=1 and CAMELS_HUGE_PAGES=0 in the environment or by
+// assigning placement before starting workers. Without a NUMA sysfs everything is node 0
+
+#define PLACEMENT_MAX_CPUS  512
+#define PLACEMENT_MAX_NODES 64
+#define HUGE_PAGE_BYTES     ((size_t) 2 << 20)
+#define HUGE_MIN_BYTES      HUGE_PAGE_BYTES // smaller tables are not worth a huge page
+
+typedef struct {
+    bool pin;        // pin worker threads, one core each
+    bool huge_pages; // try huge pages for tables of HUGE_MIN_BYTES or more
+} PlacementConfig;
+
+typedef struct {
+    int n_cpus;
+    int cpus[PLACEMENT_MAX_CPUS]; // cpus this process may use, node by node
+    int node_of[PLACEMENT_MAX_CPUS];
+    int n_nodes;
+    int node_cpus[PLACEMENT_MAX_NODES]; // how many of cpus are on each node
+} Topology;
+
+// per worker state, recycled through the pool of the node it was first touched on
+typedef struct WorkerBlock {
+    struct WorkerBlock* next;
+    int node;
+    _Alignas(64) Game game; // own cache lines, and a size aligned_alloc accepts
+} WorkerBlock;
+
+PlacementConfig placement = {.pin = false, .huge_pages = true};
+Topology topology;
+pthread_once_t topology_once = PTHREAD_ONCE_INIT;
+WorkerBlock* node_pools[PLACEMENT_MAX_NODES];
+pthread_mutex_t node_pools_lock = PTHREAD_MUTEX_INITIALIZER;
+
+// adds the cpus of a sysfs list such as "0-3,8-11" that are in allowed
+void add_cpu_list(const char* list, const cpu_set_t* allowed, int node) {
+    while (*list != '\0' && *list != '\n') {
+        char* end;
+        long lo = strtol(list, &end, 10), hi = lo;
+        if (*end == '-') {
+            hi = strtol(end + 1, &end, 10);
+        }
+        for (long cpu = lo; cpu <= hi && cpu < CPU_SETSIZE; cpu++) {
+            if (CPU_ISSET((size_t) cpu, allowed) && topology.n_cpus < PLACEMENT_MAX_CPUS) {
+                topology.cpus[topology.n_cpus]    = (int) cpu;
+                topology.node_of[topology.n_cpus] = node;
+                topology.n_cpus++;
+                topology.node_cpus[node]++;
+            }
+        }
+        if (*end != ',') {
+            break;
+        }
+        list = end + 1;
+    }
+}
+
+void topology_detect(void) {
+    const char* pin  = getenv("CAMELS_PIN");
+    const char* huge = getenv("CAMELS_HUGE_PAGES");
+    placement.pin        = placement.pin || (pin != NULL && strcmp(pin, "1") == 0);
+    placement.huge_pages = placement.huge_pages && !(huge != NULL && strcmp(huge, "0") == 0);
+
+    cpu_set_t allowed;
+    CPU_ZERO(&allowed);
+    if (sched_getaffinity(0, sizeof(allowed), &allowed) != 0) {
+        for (int cpu = 0; cpu < CPU_SETSIZE && cpu < sysconf(_SC_NPROCESSORS_ONLN); cpu++) {
+            CPU_SET((size_t) cpu, &allowed);
+        }
+    }
+    for (int node = 0; node < PLACEMENT_MAX_NODES; node++) {
+        char path[64], list[4096];
+        snprintf(path, sizeof(path), "/sys/devices/system/node/node%d/cpulist", node);
+        FILE* f = fopen(path, "r");
+        if (f == NULL) {
+            continue;
+        }
+        if (fgets(list, sizeof(list), f) != NULL) {
+            add_cpu_list(list, &allowed, topology.n_nodes);
+            topology.n_nodes += topology.node_cpus[topology.n_nodes] > 0;
+        }
+        fclose(f);
+    }
+    if (topology.n_cpus == 0) {
+        memset(&topology, 0, sizeof(topology));
+        for (int cpu = 0; cpu < CPU_SETSIZE && topology.n_cpus < PLACEMENT_MAX_CPUS; cpu++) {
+            if (CPU_ISSET((size_t) cpu, &allowed)) {
+                topology.cpus[topology.n_cpus++] = cpu;
+            }
+        }
+        topology.node_cpus[0] = topology.n_cpus;
+    }
+    topology.n_nodes = topology.n_nodes > 0 ? topology.n_nodes : 1;
+}
+
+const Topology* get_topology(void) {
+    pthread_once(&topology_once, topology_detect);
+    return &topology;
+}
+
+// pins the calling thread for worker number worker when pinning is on. Returns the thread's node
+int placement_enter(int worker) {
+    const Topology* topo = get_topology();
+    int slot             = worker % topo->n_cpus;
+    if (placement.pin) {
+        cpu_set_t set;
+        CPU_ZERO(&set);
+        CPU_SET((size_t) topo->cpus[slot], &set);
+        if (pthread_setaffinity_np(pthread_self(), sizeof(set), &set) == 0) {
+            return topo->node_of[slot];
+        }
+    }
+    int cpu = sched_getcpu();
+    for (int i = 0; i < topo->n_cpus; i++) {
+        if (topo->cpus[i] == cpu) {
+            return topo->node_of[i];
+        }
+    }
+    return 0;
+}
+
+// a WorkerBlock on node, reused when the node has one spare. NULL when out of memory
+WorkerBlock* worker_block_get(int node) {
+    pthread_mutex_lock(&node_pools_lock);
+    WorkerBlock* block = node_pools[node];
+    if (block != NULL) {
+        node_pools[node] = block->next;
+    }
+    pthread_mutex_unlock(&node_pools_lock);
+    if (block == NULL) {
+        block = aligned_alloc(64, sizeof(WorkerBlock));
+        if (block == NULL) {
+            return NULL;
+        }
+        memset(block, 0, sizeof(WorkerBlock)); // first touch, from the node it will be used on
+        block->node = node;
+    }
+    return block;
+}
+
+void worker_block_put(WorkerBlock* block) {
+    if (block == NULL) {
+        return;
+    }
+    pthread_mutex_lock(&node_pools_lock);
+    block->next             = node_pools[block->node];
+    node_pools[block->node] = block;
+    pthread_mutex_unlock(&node_pools_lock);
+}
+
+// zeroed memory for a large table, on huge pages when placement allows and the kernel has them
+bool huge_alloc(HugeRegion* region, size_t size) {
+    get_topology(); // CAMELS_HUGE_PAGES is read into placement there, possibly not yet
+    region->kind = HUGE_NONE;
+    region->size = 0;
+    if (placement.huge_pages && size >= HUGE_MIN_BYTES) {
+        size_t rounded = (size + HUGE_PAGE_BYTES - 1) & ~(HUGE_PAGE_BYTES - 1);
+        void* p = mmap(NULL, rounded, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+        if (p != MAP_FAILED) {
+            *region = (HugeRegion) {.base = p, .size = rounded, .kind = HUGE_EXPLICIT};
+            return true;
+        }
+        // no reserved huge pages: over-map, trim to a huge page boundary and ask for THP
+        p = mmap(NULL, rounded + HUGE_PAGE_BYTES, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if (p != MAP_FAILED) {
+            uintptr_t start = ((uintptr_t) p + HUGE_PAGE_BYTES - 1) & ~(uintptr_t) (HUGE_PAGE_BYTES - 1);
+            size_t head     = start - (uintptr_t) p;
+            if (head > 0) {
+                munmap(p, head);
+            }
+            munmap((void*) (start + rounded), HUGE_PAGE_BYTES - head);
+            HugeKind kind = madvise((void*) start, rounded, MADV_HUGEPAGE) == 0 ? HUGE_TRANSPARENT : HUGE_NONE;
+            *region       = (HugeRegion) {.base = (void*) start, .size = rounded, .kind = kind};
+            return true;
+        }
+    }
+    region->base = calloc(1, size);
+    return region->base != NULL;
+}
+
+void huge_free(HugeRegion* region) {
+    if (region->size > 0) {
+        munmap(region->base, region->size);
+    } else {
+        free(region->base);
+    }
+    region->base = NULL;
+}
+
+//////////////////////////////////// Simulation //////////////////////////////////////
+
+// roll one die from the pyramid and move its camel, starting a new leg first if the pyramid is spent
+void sim_roll(Game* game, Rng* rng) {
+    if (game->dice.count == N_DICE) {
+        reset_dice(game);
+        for (int i = 0; i < BOARD_SIZE; i++) {
+            game->board[i].has_spec = false;
+        }
+    }
+    DiceColor left[N_DICE + 1];
+    int n    = remaining_dice(game, left);
+    Roll die = die_face(left[rng_range(rng, 0, n - 1)], rng_range(rng, 0, 1), rng_range(rng, 1, 3));
+    stack_push(&game->dice, die);
+    move_camel(game, die.color, die.value);
+}
+
+// roll until a camel crosses the finish, only the race is played out: no tickets, wagers or new spectators
+void play_out_race(Game* game, Rng* rng) {
+    while (!game->winner) {
+        sim_roll(game, rng);
+    }
+}
+
+// Monte Carlo whole-race odds, stops after max_samples playouts or budget_ms of wall time. The deadline is on
+// the monotonic clock like search_best's, so busy threads elsewhere in the process do not eat the budget.
+// Returns the number of playouts used
+int race_odds(Game* game, Rng* rng, double budget_ms, int max_samples, double p_first[N_BETS_COLORS],
+              double p_last[N_BETS_COLORS]) {
+    int first_count[N_BETS_COLORS] = {0};
+    int last_count[N_BETS_COLORS]  = {0};
+    uint64_t deadline_ns           = now_ns() + (uint64_t) (budget_ms * 1e6);
+
+    int n = 0;
+    while (n < max_samples && (n % 64 != 0 || now_ns() < deadline_ns)) {
+        Game sim = *game;
+        play_out_race(&sim, rng);
+        int first, second;
+        get_top_camels(&sim, &first, &second);
+        first_count[first]++;
+        last_count[get_last_camel(&sim)]++;
+        n++;
+    }
+    for (int c = 0; c < N_BETS_COLORS; c++) {
+        p_first[c] = n > 0 ? (double) first_count[c] / n : 0.0;
+        p_last[c]  = n > 0 ? (double) last_count[c] / n : 0.0;
+    }
+    return n;
+}
+
+//////////////////////////////////// Tablebase //////////////////////////////////////
+// Exact whole-race winner and loser odds for every leg-start position with all racing camels inside the
+// last `span` tiles and both crazy camels parked behind them. A parked crazy camel only moves away from the
+// pack, so it never lands on or carries a racing camel again and the race depends on the racing camels
+// alone. Every leg moves at least four of them forward, so the positions form a DAG and are solved exactly
+// back from the finish, under the same race-only model as play_out_race.
+// Camels are labeled in reading order (rearmost lowest first), which makes a position its sorted tile
+// offsets t0 <= .. <= t4 and stores one entry per relabeling class, addressed by the combinatorial number
+// system: index = sum C(t_i + i, i + 1). The file is a TablebaseHeader and the entries, mapped read-only
+
+const Tablebase* camels_tablebase = NULL; // when set, value_wagers reads exact odds from it before sampling
+
+uint32_t choose(int n, int k) {
+    if (k < 0 || n < k) {
+        return 0;
+    }
+    uint64_t c = 1;
+    for (int i = 1; i <= k; i++) {
+        c = c * (uint64_t) (n - k + i) / (uint64_t) i;
+    }
+    return (uint32_t) c;
+}
+
+uint32_t tb_entries(int span) { return choose(span + N_BETS_COLORS - 1, N_BETS_COLORS); }
+
+// entry index and reading order (label -> color) of a leg-start position, false if it is not in the table
+bool tb_index(Game* game, int span, uint8_t order[N_BETS_COLORS], uint32_t* index) {
+    int base        = BOARD_SIZE - 1 - span;
+    int label       = 0;
+    int rear        = -1;
+    int crazy_front = -1;
+    *index          = 0;
+    for (int b = 0; b < BOARD_SIZE; b++) {
+        CamelStack* stack = &game->board[b].camel_stack;
+        for (int j = 0; j < stack->count; j++) {
+            int color = stack->items[j].color;
+            if (color >= N_BETS_COLORS) {
+                crazy_front = b;
+                continue;
+            }
+            if (b < base || b >= BOARD_SIZE - 1) {
+                return false;
+            }
+            rear         = label == 0 ? b : rear;
+            order[label] = (uint8_t) color;
+            *index += choose(b - base + label, label + 1);
+            label++;
+        }
+    }
+    return label == N_BETS_COLORS && crazy_front < rear;
+}
+
+// sorted tile offsets of entry index
+void tb_unrank(uint32_t index, int offsets[N_BETS_COLORS]) {
+    for (int i = N_BETS_COLORS - 1; i >= 0; i--) {
+        int x = i;
+        while (choose(x + 1, i + 1) <= index) {
+            x++;
+        }
+        index -= choose(x, i + 1);
+        offsets[i] = x - i;
+    }
+}
+
+// leg-start position of entry index with only the racing camels on the board, label l is color l
+void tb_position(Game* game, int span, uint32_t index) {
+    int offsets[N_BETS_COLORS];
+    tb_unrank(index, offsets);
+    memset(game, 0, sizeof(Game));
+    for (int b = 0; b < BOARD_SIZE; b++) {
+        game->board[b].camel_stack.capacity = N_CAMELS;
+    }
+    reset_dice(game);
+    for (int l = 0; l < N_BETS_COLORS; l++) { // pushed in reading order
+        int space   = BOARD_SIZE - 1 - span + offsets[l];
+        Camel camel = {.color = (uint8_t) l, .orientation = FORWARD, .space = (int8_t) space};
+        stack_push(&game->board[space].camel_stack, camel);
+    }
+}
+
+typedef struct {
+    int span;
+    double (*memo)[2][N_BETS_COLORS]; // [index * TB_DICE_STATES + rolled], by label
+    uint8_t* done;
+} TbSolver;
+
+// whole-race odds by color of a position with every camel in the table's span, memoized per dice state
+void tb_solve(TbSolver* solver, Game* game, double out[2][N_BETS_COLORS]) {
+    memset(out, 0, 2 * N_BETS_COLORS * sizeof(double));
+    if (game->winner) {
+        int first, second;
+        get_top_camels(game, &first, &second);
+        out[0][first]                = 1.0;
+        out[1][get_last_camel(game)] = 1.0;
+        return;
+    }
+    if (game->dice.count == N_DICE) {
+        reset_dice(game);
+    }
+    uint8_t order[N_BETS_COLORS], label_of[N_BETS_COLORS];
+    uint32_t index;
+    bool inside = tb_index(game, solver->span, order, &index);
+    assert(inside && "Racing camels only move forward, the solver never leaves the table");
+    (void) inside;
+    for (int l = 0; l < N_BETS_COLORS; l++) {
+        label_of[order[l]] = (uint8_t) l;
+    }
+    int rolled = 0;
+    for (int i = 0; i < game->dice.count; i++) {
+        int color = game->dice.items[i].color;
+        rolled |= 1 << (color < N_BETS_COLORS ? label_of[color] : N_BETS_COLORS);
+    }
+    size_t state = (size_t) index * TB_DICE_STATES + (size_t) rolled;
+
+    if (!solver->done[state]) {
+        double odds[2][N_BETS_COLORS] = {{0}}, sub[2][N_BETS_COLORS];
+        DiceColor left[N_DICE + 1];
+        int n = remaining_dice(game, left);
+        for (int d = 0; d < n; d++) {
+            int faces = left[d] == DGREY ? 1 : 3; // the grey die only moves a parked crazy camel
+            for (int value = 1; value <= faces; value++) {
+                Game next = *game;
+                Roll die  = die_face(left[d], 0, value);
+                stack_push(&next.dice, die);
+                if (left[d] != DGREY) {
+                    move_camel(&next, (CamelColor) die.color, die.value);
+                }
+                tb_solve(solver, &next, sub);
+                for (int k = 0; k < 2; k++) {
+                    for (int c = 0; c < N_BETS_COLORS; c++) {
+                        odds[k][c] += sub[k][c] / (n * faces);
+                    }
+                }
+            }
+        }
+        for (int k = 0; k < 2; k++) {
+            for (int c = 0; c < N_BETS_COLORS; c++) {
+                solver->memo[state][k][label_of[c]] = odds[k][c];
+            }
+        }
+        solver->done[state] = 1;
+    }
+    for (int k = 0; k < 2; k++) {
+        for (int l = 0; l < N_BETS_COLORS; l++) {
+            out[k][order[l]] = solver->memo[state][k][l];
+        }
+    }
+}
+
+// solves every entry for span and writes the file, entries is set to how many were written
+bool camels_tablebase_generate(const char* path, int span, uint32_t* entries) {
+    if (span < 1 || span > BOARD_SIZE - 1) {
+        return false;
+    }
+    uint32_t n      = tb_entries(span);
+    TbSolver solver = {.span = span};
+    HugeRegion memo;
+    bool ok     = huge_alloc(&memo, (size_t) n * TB_DICE_STATES * sizeof(*solver.memo));
+    solver.memo = memo.base;
+    solver.done = calloc((size_t) n * TB_DICE_STATES, 1);
+    FILE* f     = fopen(path, "wb");
+    ok          = ok && solver.done != NULL && f != NULL;
+
+    TablebaseHeader header = {.version = TB_VERSION, .span = (uint32_t) span, .entries = n,
+                              .entry_size = sizeof(TablebaseEntry)};
+    memcpy(header.magic, TB_MAGIC, sizeof(header.magic));
+    ok = ok && fwrite(&header, sizeof(header), 1, f) == 1;
+
+    for (uint32_t i = 0; ok && i < n; i++) {
+        Game game;
+        tb_position(&game, span, i);
+        double odds[2][N_BETS_COLORS];
+        tb_solve(&solver, &game, odds);
+        TablebaseEntry entry;
+        for (int c = 0; c < N_BETS_COLORS; c++) {
+            entry.first[c] = (float) odds[0][c];
+            entry.last[c]  = (float) odds[1][c];
+        }
+        ok = fwrite(&entry, sizeof(entry), 1, f) == 1;
+    }
+    if (f != NULL) {
+        ok = fclose(f) == 0 && ok;
+    }
+    huge_free(&memo);
+    free(solver.done);
+    *entries = n;
+    return ok;
+}
+
+bool camels_tablebase_open(Tablebase* tb, const char* path) {
+    struct stat st;
+    FILE* f = fopen(path, "rb");
+    if (f == NULL) {
+        return false;
+    }
+    bool ok = fstat(fileno(f), &st) == 0 && (size_t) st.st_size >= sizeof(TablebaseHeader);
+    if (ok) {
+        tb->size  = (size_t) st.st_size;
+        void* mem = mmap(NULL, tb->size, PROT_READ, MAP_PRIVATE, fileno(f), 0);
+        ok        = mem != MAP_FAILED;
+        tb->data  = mem;
+    }
+    fclose(f);
+    if (!ok) {
+        return false;
+    }
+    TablebaseHeader header;
+    memcpy(&header, tb->data, sizeof(header));
+    if (memcmp(header.magic, TB_MAGIC, sizeof(header.magic)) != 0 || header.version != TB_VERSION ||
+        header.span < 1 || header.span > BOARD_SIZE - 1 || header.entries != tb_entries((int) header.span) ||
+        header.entry_size != sizeof(TablebaseEntry) ||
+        tb->size != sizeof(header) + (size_t) header.entries * sizeof(TablebaseEntry)) {
+        munmap((void*) tb->data, tb->size);
+        return false;
+    }
+    tb->span    = (int) header.span;
+    tb->entries = header.entries;
+    tb->table   = (const TablebaseEntry*) (tb->data + sizeof(header));
+    return true;
+}
+
+void tablebase_close(Tablebase* tb) { munmap((void*) tb->data, tb->size); }
+
+bool tablebase_walk(const Tablebase* tb, Game* game, double weight, double p_first[N_BETS_COLORS],
+                    double p_last[N_BETS_COLORS]) {
+    if (game->winner) {
+        int first, second;
+        get_top_camels(game, &first, &second);
+        p_first[first] += weight;
+        p_last[get_last_camel(game)] += weight;
+        return true;
+    }
+    bool has_spec = false;
+    for (int b = 0; b < BOARD_SIZE; b++) {
+        has_spec |= game->board[b].has_spec;
+    }
+    if (game->dice.count == N_DICE || (game->dice.count == 0 && !has_spec)) {
+        uint8_t order[N_BETS_COLORS];
+        uint32_t index;
+        if (!tb_index(game, tb->span, order, &index)) {
+            return false;
+        }
+        const TablebaseEntry* entry = &tb->table[index];
+        for (int l = 0; l < N_BETS_COLORS; l++) {
+            p_first[order[l]] += weight * entry->first[l];
+            p_last[order[l]] += weight * entry->last[l];
+        }
+        return true;
+    }
+    if (N_DICE - game->dice.count > TB_WALK_ROLLS) {
+        return false;
+    }
+    DiceColor left[N_DICE + 1];
+    int n = remaining_dice(game, left);
+    for (int d = 0; d < n; d++) {
+        int faces = left[d] == DGREY ? 2 : 1;
+        for (int crazy = 0; crazy < faces; crazy++) {
+            for (int value = 1; value <= 3; value++) {
+                Game next = *game;
+                Roll die  = die_face(left[d], crazy, value);
+                stack_push(&next.dice, die);
+                move_camel(&next, (CamelColor) die.color, die.value);
+                if (!tablebase_walk(tb, &next, weight / (n * faces * 3), p_first, p_last)) {
+                    return false;
+                }
+            }
+        }
+    }
+    return true;
+}
+
+// exact whole-race odds from the table, walking the rest of the leg exactly when it is short enough.
+// False when the position (or a leg end it can reach) is outside the table, p_first and p_last are then
+// meaningless and the caller should fall back to sampling
+bool camels_tablebase_odds(const Tablebase* tb, Game* game, double p_first[N_BETS_COLORS],
+                           double p_last[N_BETS_COLORS]) {
+    memset(p_first, 0, N_BETS_COLORS * sizeof(double));
+    memset(p_last, 0, N_BETS_COLORS * sizeof(double));
+    return tablebase_walk(tb, game, 1.0, p_first, p_last);
+}
+
+//////////////////////////////////// Race Ranking //////////////////////////////////////
+// A perfect rank of race configurations: the tile of every camel and the order of each stack, optionally
+// with which dice are still in the pyramid. Read the board rearmost tile first, each stack bottom up, and a
+// configuration is a permutation of the colors plus their sorted tiles t0 <= .. <= t6. The two are
+// independent, so rank = tiles * N_CAMELS! + order: order is the permutation's Lehmer code and tiles the
+// combinatorial number system of the Tablebase, sum C(t_i + i, i + 1). With dice, the mask of dice left
+// (never empty) is the lowest digit. Every index below race_configurations is a configuration, reachable in
+// play or not, so tables keyed by rank are flat arrays with no hashing
+
+#define RACE_ORDERS     5040                      // N_CAMELS!
+#define RACE_DICE_MASKS ((1 << (N_DICE + 1)) - 1) // bit per DiceColor left, at least one always is
+#define RACE_ALL_CAMELS ((1u << N_CAMELS) - 1)
+
+uint32_t race_binomial[BOARD_SIZE + N_CAMELS][N_CAMELS + 1];
+uint8_t race_popcount[1 << N_CAMELS];        // the builtin is a library call without -mpopcnt
+uint8_t race_orders[RACE_ORDERS][N_CAMELS]; // colors in reading order by Lehmer code, unrank's only divisions
+const uint32_t race_factorial[N_CAMELS] = {1, 1, 2, 6, 24, 120, 720};
+pthread_once_t race_once                 = PTHREAD_ONCE_INIT;
+
+void init_race_tables(void) {
+    for (int n = 0; n < BOARD_SIZE + N_CAMELS; n++) {
+        for (int k = 0; k <= N_CAMELS; k++) {
+            race_binomial[n][k] = choose(n, k);
+        }
+    }
+    for (int m = 0; m < 1 << N_CAMELS; m++) {
+        race_popcount[m] = (uint8_t) __builtin_popcount((unsigned) m);
+    }
+    for (uint32_t r = 0; r < RACE_ORDERS; r++) {
+        unsigned unused = RACE_ALL_CAMELS;
+        uint32_t order  = r;
+        for (int i = 0; i < N_CAMELS; i++) {
+            unsigned pick = unused;
+            for (uint32_t k = order / race_factorial[N_CAMELS - 1 - i]; k > 0; k--) {
+                pick &= pick - 1;
+            }
+            order %= race_factorial[N_CAMELS - 1 - i];
+            race_orders[r][i] = (uint8_t) __builtin_ctz(pick);
+            unused &= ~(1u << race_orders[r][i]);
+        }
+    }
+}
+
+uint64_t race_configurations(bool with_dice) {
+    uint64_t n = (uint64_t) choose(BOARD_SIZE + N_CAMELS - 1, N_CAMELS) * RACE_ORDERS;
+    return with_dice ? n * RACE_DICE_MASKS : n;
+}
+
+// bit per DiceColor still in the pyramid
+int race_dice_left(const Game* game) {
+    int left = RACE_DICE_MASKS;
+    for (int i = 0; i < game->dice.count; i++) {
+        int color = game->dice.items[i].color;
+        left &= ~(1 << (color < N_BETS_COLORS ? color : (int) DGREY));
+    }
+    return left;
+}
+
+uint64_t race_rank(const Game* game, bool with_dice) {
+    pthread_once(&race_once, init_race_tables);
+    uint32_t tiles  = 0;
+    uint32_t order  = 0;
+    unsigned unused = RACE_ALL_CAMELS;
+    int i           = 0;
+    for (int b = 0; b < BOARD_SIZE; b++) {
+        const CamelStack* stack = &game->board[b].camel_stack;
+        for (int j = 0; j < stack->count; j++, i++) {
+            unsigned bit = 1u << stack->items[j].color;
+            tiles += race_binomial[b + i][i + 1];
+            order += race_popcount[unused & (bit - 1)] * race_factorial[N_CAMELS - 1 - i];
+            unused &= ~bit;
+        }
+    }
+    assert(i == N_CAMELS && unused == 0 && "Every camel is on the board once");
+    uint64_t rank = (uint64_t) tiles * RACE_ORDERS + order;
+    return with_dice ? rank * RACE_DICE_MASKS + (uint64_t) (race_dice_left(game) - 1) : rank;
+}
+
+// the configuration of rank on an empty board, like tb_position only the camels and dice are set. Rolled
+// dice are pushed in color order showing 1, the grey one as the white camel's
+void race_unrank(uint64_t rank, bool with_dice, Game* game) {
+    pthread_once(&race_once, init_race_tables);
+    memset(game, 0, sizeof(Game));
+    for (int b = 0; b < BOARD_SIZE; b++) {
+        game->board[b].camel_stack.capacity = N_CAMELS;
+    }
+    reset_dice(game);
+    if (with_dice) {
+        int left = (int) (rank % RACE_DICE_MASKS) + 1;
+        rank /= RACE_DICE_MASKS;
+        for (int d = 0; d <= (int) DGREY; d++) {
+            if (!((left >> d) & 1)) {
+                stack_push(&game->dice, die_face((DiceColor) d, 0, 1));
+            }
+        }
+    }
+    uint32_t order = (uint32_t) (rank % RACE_ORDERS);
+    uint32_t tiles = (uint32_t) (rank / RACE_ORDERS);
+    int space[N_CAMELS];
+    int t = BOARD_SIZE - 1;
+    for (int i = N_CAMELS - 1; i >= 0; i--) { // t_i only falls with i, so one downward pass finds them all
+        while (race_binomial[t + i][i + 1] > tiles) {
+            t--;
+        }
+        tiles -= race_binomial[t + i][i + 1];
+        space[i] = t;
+    }
+    const uint8_t* colors = race_orders[order];
+    for (int i = 0; i < N_CAMELS; i++) {
+        int color   = colors[i];
+        Camel camel = {.color       = (uint8_t) color,
+                       .orientation = color < N_BETS_COLORS ? FORWARD : REVERSE,
+                       .space       = (int8_t) space[i]};
+        stack_push(&game->board[space[i]].camel_stack, camel);
+        game->winner |= color < N_BETS_COLORS && space[i] == BOARD_SIZE - 1;
+    }
+}
+
+//////////////////////////////////// Wager Valuation //////////////////////////////////////
+
+#define WAGER_BUDGET_MS  20.0 // advisor budget per query
+#define WAGER_MAX_SAMPLES 20000
+
+// chance an opponent spends a turn on an overall wager, rises as the leader nears the finish
+double opponent_wager_rate(Game* game) {
+    // crazy camels start near the finish, only count tiles with a racing camel
+    for (int b = BOARD_SIZE - 1; b >= 0; b--) {
+        CamelStack* stack = &game->board[b].camel_stack;
+        for (size_t j = 0; j < stack_count(stack); j++) {
+            if (stack->items[j].color != CBLACK && stack->items[j].color != CWHITE) {
+                return (double) b / (BOARD_SIZE - 1);
+            }
+        }
+    }
+    return 0.0;
+}
+
+int correct_bets_on(WagerStack* bets, BetColor color) {
+    int n = 0;
+    for (size_t i = 0; i < bets->count; i++) {
+        if (bets->items[i].color == color) {
+            n++;
+        }
+    }
+    return n;
+}
+
+// EV of a wager that is right with probability p, queued behind `ahead` bets on the same color plus a
+// Poisson-binomial number of future opponent bets with per-opponent probabilities q[0..n_opp)
+double queued_wager_ev(double p, int ahead, const double* q, int n_opp) {
+    double dist[N_PLAYERS + 1] = {1.0};
+    for (int o = 0; o < n_opp; o++) {
+        for (int k = o + 1; k > 0; k--) {
+            dist[k] = dist[k] * (1.0 - q[o]) + dist[k - 1] * q[o];
+        }
+        dist[0] *= 1.0 - q[o];
+    }
+    double pay = 0.0;
+    for (int k = 0; k <= n_opp; k++) {
+        pay += dist[k] * wager_payout(ahead + k);
+    }
+    return p * pay - (1.0 - p);
+}
+
+// Values every overall wager for player_id: now versus after one more lap of the table.
+// Opponents are modelled as betting a color they still hold at opponent_wager_rate, weighted by its odds.
+// Returns the number of playouts behind the odds, 0 when they came exact from the tablebase
+int value_wagers(Game* game, int player_id, Rng* rng, double budget_ms, WagerValue out[N_BETS_COLORS]) {
+    double p_first[N_BETS_COLORS], p_last[N_BETS_COLORS];
+    int samples = 0;
+    if (camels_tablebase == NULL || !camels_tablebase_odds(camels_tablebase, game, p_first, p_last)) {
+        samples = race_odds(game, rng, budget_ms, WAGER_MAX_SAMPLES, p_first, p_last);
+    }
+    double rate = opponent_wager_rate(game);
+
+    for (int c = 0; c < N_BETS_COLORS; c++) {
+        BetColor color = (BetColor) c;
+        double q_win[N_PLAYERS], q_lose[N_PLAYERS];
+        int n_opp = 0;
+        for (int o = 0; o < N_PLAYERS; o++) {
+            if (o != player_id && has_card_in_hand(&game->players[o], color)) {
+                q_win[n_opp]  = rate * p_first[c];
+                q_lose[n_opp] = rate * p_last[c];
+                n_opp++;
+            }
+        }
+        int win_ahead  = correct_bets_on(&game->winner_bets, color);
+        int lose_ahead = correct_bets_on(&game->loser_bets, color);
+
+        WagerValue v  = {0};
+        v.available   = has_card_in_hand(&game->players[player_id], color);
+        v.p_first     = p_first[c];
+        v.p_last      = p_last[c];
+        v.winner_now  = queued_wager_ev(p_first[c], win_ahead, q_win, 0);
+        v.winner_wait = queued_wager_ev(p_first[c], win_ahead, q_win, n_opp);
+        v.loser_now   = queued_wager_ev(p_last[c], lose_ahead, q_lose, 0);
+        v.loser_wait  = queued_wager_ev(p_last[c], lose_ahead, q_lose, n_opp);
+        out[c]        = v;
+    }
+    return samples;
+}
+
+//////////////////////////////////// Sequential Sampling //////////////////////////////////////
+// Playouts that run until the answer is precise enough, not for a fixed count. race_odds_within keeps
+// sampling until the whole-race first and last probabilities the caller watches are within ±half_width at
+// the requested confidence. race_compare plays paired playouts for two bets. It stops once one bet is better at that
+// confidence, or once the difference is known to be under margin. Both report how many playouts they used.
+// Both check their intervals at doubling sample counts and spend alpha/2, alpha/4, .. of the error budget on
+// those checks, so stopping early does not raise the error rate above 1 - confidence. race_odds_within also
+// splits each check's share evenly across the probabilities it watches, so all of them hold at once
+
+#define SEQ_MIN_SAMPLES 256 // the normal approximation is too rough to stop on before this
+#define SEQ_WATCH_FIRST(c) (1u << (c))                   // race_odds_within watch bits
+#define SEQ_WATCH_LAST(c)  (1u << (N_BETS_COLORS + (c)))
+#define SEQ_WATCH_ALL      ((1u << (2 * N_BETS_COLORS)) - 1)
+
+typedef enum { BET_TICKET, BET_WINNER, BET_LOSER } BetKind;
+
+typedef struct {
+    BetKind kind;
+    BetColor color;
+} Bet;
+
+typedef struct {
+    int samples;
+    double mean;       // payoff of A minus payoff of B, in coins
+    double half_width; // of mean, at the last check
+    int verdict;       // 1 when A is better, -1 when B is, 0 when within margin or out of samples
+} Comparison;
+
+// z such that P(Z <= z) = p for a standard normal Z
+double normal_quantile(double p) {
+    double lo = -10.0, hi = 10.0;
+    for (int i = 0; i < 64; i++) {
+        double mid = 0.5 * (lo + hi);
+        if (0.5 * erfc(-mid / sqrt(2.0)) < p) {
+            lo = mid;
+        } else {
+            hi = mid;
+        }
+    }
+    return 0.5 * (lo + hi);
+}
+
+// true when counts[c] / n is known to ±half_width for every color in the watch bits. The interval is centred
+// Agresti-Coull style, so a color that has not come up yet does not look certain
+bool counts_within(const int counts[N_BETS_COLORS], unsigned watch, int n, double z, double half_width) {
+    for (int c = 0; c < N_BETS_COLORS; c++) {
+        if (!(watch & (1u << c))) {
+            continue;
+        }
+        double m = n + z * z;
+        double p = (counts[c] + 0.5 * z * z) / m;
+        if (z * sqrt(p * (1.0 - p) / m) > half_width) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// race_odds until the watched p_first and p_last (SEQ_WATCH_* bits) are within ±half_width at confidence, or
+// max_samples. Returns the number of playouts used, 0 with all odds 0 when watch has no SEQ_WATCH_* bit set
+int race_odds_within(Game* game, Rng* rng, unsigned watch, double half_width, double confidence, int max_samples,
+                     double p_first[N_BETS_COLORS], double p_last[N_BETS_COLORS]) {
+    double alpha                   = 1.0 - confidence;
+    int watched                    = __builtin_popcount(watch & SEQ_WATCH_ALL);
+    int first_count[N_BETS_COLORS] = {0};
+    int last_count[N_BETS_COLORS]  = {0};
+    int look                       = 0;
+    int next_look                  = SEQ_MIN_SAMPLES;
+
+    int n = 0;
+    while (watched > 0 && n < max_samples) {
+        Game sim = *game;
+        play_out_race(&sim, rng);
+        int first, second;
+        get_top_camels(&sim, &first, &second);
+        first_count[first]++;
+        last_count[get_last_camel(&sim)]++;
+        n++;
+        if (n == next_look) {
+            // two sided alpha / 2^(look + 1), shared by the watched probabilities
+            double z = normal_quantile(1.0 - alpha / (watched * pow(2.0, look + 2)));
+            if (counts_within(first_count, watch, n, z, half_width) &&
+                counts_within(last_count, watch >> N_BETS_COLORS, n, z, half_width)) {
+                break;
+            }
+            look++;
+            next_look *= 2;
+        }
+    }
+    for (int c = 0; c < N_BETS_COLORS; c++) {
+        p_first[c] = n > 0 ? (double) first_count[c] / n : 0.0;
+        p_last[c]  = n > 0 ? (double) last_count[c] / n : 0.0;
+    }
+    return n;
+}
+
+// coins bet pays for one playout, given what it pays when right. A ticket pays +1 for second, else -1
+double bet_payoff(Bet bet, int pays, int leg_first, int leg_second, int race_first, int race_last) {
+    int color = (int) bet.color;
+    switch (bet.kind) {
+        case BET_TICKET:
+            return color == leg_first ? pays : color == leg_second ? 1.0 : -1.0;
+        case BET_WINNER:
+            return color == race_first ? pays : -1.0;
+        case BET_LOSER:
+            return color == race_last ? pays : -1.0;
+        default:
+            return 0.0;
+    }
+}
+
+// what bet pays in game when it comes in, 0 for a ticket that is gone
+int bet_pays(Game* game, Bet bet) {
+    switch (bet.kind) {
+        case BET_TICKET: {
+            Ticket* ticket = top_ticket(&game->tickets[bet.color]);
+            return ticket != NULL ? ticket->amount : 0;
+        }
+        case BET_WINNER:
+            return wager_payout(correct_bets_on(&game->winner_bets, bet.color));
+        case BET_LOSER:
+            return wager_payout(correct_bets_on(&game->loser_bets, bet.color));
+        default:
+            return 0;
+    }
+}
+
+// which of a and b pays more for the player taking it now, from paired playouts of the rest of the race
+Comparison race_compare(Game* game, Rng* rng, Bet a, Bet b, double margin, double confidence, int max_samples) {
+    double alpha  = 1.0 - confidence;
+    int pays_a    = bet_pays(game, a);
+    int pays_b    = bet_pays(game, b);
+    double sum    = 0.0;
+    double sum_sq = 0.0;
+    int look      = 0;
+    int next_look = SEQ_MIN_SAMPLES;
+    Comparison c  = {0};
+
+    while (c.samples < max_samples) {
+        Game sim = *game;
+        while (sim.dice.count < N_DICE && !sim.winner) {
+            sim_roll(&sim, rng);
+        }
+        int leg_first, leg_second, race_first, race_second;
+        get_top_camels(&sim, &leg_first, &leg_second);
+        play_out_race(&sim, rng);
+        get_top_camels(&sim, &race_first, &race_second);
+        int race_last = get_last_camel(&sim);
+
+        double d = bet_payoff(a, pays_a, leg_first, leg_second, race_first, race_last) -
+                   bet_payoff(b, pays_b, leg_first, leg_second, race_first, race_last);
+        sum += d;
+        sum_sq += d * d;
+        c.samples++;
+
+        if (c.samples == next_look || (c.samples == max_samples && c.samples > 1)) {
+            double z     = normal_quantile(1.0 - alpha / pow(2.0, look + 2)); // two sided alpha / 2^(look + 1)
+            c.mean       = sum / c.samples;
+            double var   = fmax(0.0, (sum_sq - c.samples * c.mean * c.mean) / (c.samples - 1));
+            c.half_width = z * sqrt(var / c.samples);
+            if (fabs(c.mean) > c.half_width) {
+                c.verdict = c.mean > 0 ? 1 : -1;
+                break;
+            }
+            if (c.half_width < margin) {
+                break;
+            }
+            look++;
+            next_look *= 2;
+        }
+    }
+    return c;
+}
+
+//////////////////////////////////// Variance Reduction //////////////////////////////////////
+// Ways of drawing playout dice that give the same expected odds as plain sampling with less spread. Each roll
+// takes three draws (which die leaves the pyramid, white or black for grey, face value), and a DiceSampler
+// decides how those draws are made:
+//   PLAIN       independent draws, as sim_roll
+//   STRATIFIED  the first two dice out of the pyramid cycle through every ordered pair, so each
+//               order gets its exact share of the playouts
+//   ANTITHETIC  playouts come in pairs that replay the same stream. The second of each pair takes every
+//               face value mirrored (1 <-> 3)
+//   QMC         the first QMC_DIMS draws come from a Kronecker sequence (i * sqrt(prime) mod 1) under a
+//               random shift, so they fill the unit cube evenly and estimates stay unbiased. Later draws are
+//               plain
+// race_odds_sampled rounds its sample count down to whole cycles of strata or pairs
+
+#define QMC_DIMS 24 // three draws per roll for the first eight rolls
+
+typedef enum { SAMPLE_PLAIN, SAMPLE_STRATIFIED, SAMPLE_ANTITHETIC, SAMPLE_QMC, N_SAMPLE_MODES } SampleMode;
+typedef enum { DRAW_DIE, DRAW_CRAZY, DRAW_VALUE } DrawKind;
+
+typedef struct {
+    SampleMode mode;
+    Rng* rng;
+    int draw;               // draws taken in this playout
+    int first_choices;      // STRATIFIED: dice the first and second roll choose from
+    int second_choices;
+    int stratum;
+    Rng pair;               // ANTITHETIC: start of the stream both playouts of a pair replay
+    Rng stream;
+    bool mirror;
+    double alpha[QMC_DIMS]; // QMC: step of each dimension, sqrt(prime) mod 1
+    double shift[QMC_DIMS];
+    double point[QMC_DIMS];
+} DiceSampler;
+
+const char* sample_mode_name(SampleMode mode) {
+    switch (mode) {
+        case SAMPLE_PLAIN:
+            return "plain";
+        case SAMPLE_STRATIFIED:
+            return "stratified";
+        case SAMPLE_ANTITHETIC:
+            return "antithetic";
+        case SAMPLE_QMC:
+            return "qmc";
+        case N_SAMPLE_MODES:
+        default:
+            return "?";
+    }
+}
+
+double rng_unit(Rng* rng) { return (double) (rng_next(rng) >> 11) * 0x1.0p-53; }
+
+void sampler_init(DiceSampler* s, SampleMode mode, Game* game, Rng* rng) {
+    memset(s, 0, sizeof(DiceSampler));
+    s->mode = mode;
+    s->rng  = rng;
+
+    // sim_roll starts a new leg first when the pyramid is spent
+    DiceColor left[N_DICE + 1];
+    s->first_choices  = game->dice.count == N_DICE ? N_DICE + 1 : remaining_dice(game, left);
+    s->second_choices = game->dice.count + 1 == N_DICE ? N_DICE + 1 : s->first_choices - 1;
+
+    static const int primes[QMC_DIMS] = {2,  3,  5,  7,  11, 13, 17, 19, 23, 29, 31, 37,
+                                         41, 43, 47, 53, 59, 61, 67, 71, 73, 79, 83, 89};
+    for (int d = 0; d < QMC_DIMS; d++) {
+        s->alpha[d] = sqrt((double) primes[d]) - floor(sqrt((double) primes[d]));
+        s->shift[d] = rng_unit(rng);
+    }
+}
+
+int sampler_round(DiceSampler* s) {
+    return s->mode == SAMPLE_STRATIFIED ? s->first_choices * s->second_choices : s->mode == SAMPLE_ANTITHETIC ? 2 : 1;
+}
+
+void sampler_begin(DiceSampler* s, uint64_t playout) {
+    s->draw = 0;
+    switch (s->mode) {
+        case SAMPLE_STRATIFIED:
+            s->stratum = (int) (playout % (uint64_t) (s->first_choices * s->second_choices));
+            break;
+        case SAMPLE_ANTITHETIC:
+            s->mirror = playout % 2 == 1;
+            if (!s->mirror) {
+                s->pair.state = rng_next(s->rng);
+            }
+            s->stream = s->pair;
+            break;
+        case SAMPLE_QMC:
+            for (int d = 0; d < QMC_DIMS; d++) {
+                double x    = s->shift[d] + (double) (playout + 1) * s->alpha[d];
+                s->point[d] = x - floor(x);
+            }
+            break;
+        case SAMPLE_PLAIN:
+        case N_SAMPLE_MODES:
+        default:
+            break;
+    }
+}
+
+// uniform in [0, n)
+int sampler_draw(DiceSampler* s, DrawKind kind, int n) {
+    int d = s->draw++;
+    switch (s->mode) {
+        case SAMPLE_STRATIFIED:
+            if (kind == DRAW_DIE && d == 0) {
+                return s->stratum % s->first_choices % n;
+            }
+            if (kind == DRAW_DIE && d == 3) {
+                return s->stratum / s->first_choices % n;
+            }
+            break;
+        case SAMPLE_ANTITHETIC: {
+            int k = rng_range(&s->stream, 0, n - 1);
+            return s->mirror && kind == DRAW_VALUE ? n - 1 - k : k;
+        }
+        case SAMPLE_QMC:
+            if (d < QMC_DIMS) {
+                return (int) (s->point[d] * n);
+            }
+            break;
+        case SAMPLE_PLAIN:
+        case N_SAMPLE_MODES:
+        default:
+            break;
+    }
+    return rng_range(s->rng, 0, n - 1);
+}
+
+// sim_roll with the draws made by s
+void sampled_roll(Game* game, DiceSampler* s) {
+    if (game->dice.count == N_DICE) {
+        reset_dice(game);
+        for (int i = 0; i < BOARD_SIZE; i++) {
+            game->board[i].has_spec = false;
+        }
+    }
+    DiceColor left[N_DICE + 1];
+    int n      = remaining_dice(game, left);
+    int die    = sampler_draw(s, DRAW_DIE, n);
+    int crazy  = sampler_draw(s, DRAW_CRAZY, 2);
+    int value  = sampler_draw(s, DRAW_VALUE, 3) + 1;
+    Roll face  = die_face(left[die], crazy, value);
+    stack_push(&game->dice, face);
+    move_camel(game, face.color, face.value);
+}
+
+// race_odds over samples playouts drawn by s, returns the playouts used
+int race_odds_sampled(Game* game, DiceSampler* s, int samples, double p_first[N_BETS_COLORS],
+                      double p_last[N_BETS_COLORS]) {
+    int first_count[N_BETS_COLORS] = {0};
+    int last_count[N_BETS_COLORS]  = {0};
+    int round                      = sampler_round(s);
+    int n                          = samples >= round ? samples - samples % round : round;
+
+    for (int i = 0; i < n; i++) {
+        sampler_begin(s, (uint64_t) i);
+        Game sim = *game;
+        while (!sim.winner) {
+            sampled_roll(&sim, s);
+        }
+        int first, second;
+        get_top_camels(&sim, &first, &second);
+        first_count[first]++;
+        last_count[get_last_camel(&sim)]++;
+    }
+    for (int c = 0; c < N_BETS_COLORS; c++) {
+        p_first[c] = (double) first_count[c] / n;
+        p_last[c]  = (double) last_count[c] / n;
+    }
+    return n;
+}
+
+//////////////////////////////////// Evaluation //////////////////////////////////////
+// Dense features of a Game and a small linear / one hidden layer evaluator for scoring search leaves.
+// Feature layout (N_FEATURES_USED floats, zero padded to N_FEATURES):
+//   [0, 7)    camel distance to the finish / (BOARD_SIZE - 1), by CamelColor
+//   [7, 14)   camel height in its stack / (N_CAMELS - 1)
+//   [14, 30)  spectator on tile: +1 forward, -1 reverse, 0 none
+//   [30, 36)  die still in the pyramid, by DiceColor
+//   [36, 41)  top ticket left / 5, by BetColor
+//   [41, 47)  player points / 10
+//   [47, 77)  player holds card, player-major
+// Outputs are three softmaxed groups of N_BETS_COLORS: leg winner, race winner, race loser
+
+void extract_features(Game* game, float features[N_FEATURES]) {
+    memset(features, 0, sizeof(float) * N_FEATURES);
+
+    for (int b = 0; b < BOARD_SIZE; b++) {
+        CamelStack* stack = &game->board[b].camel_stack;
+        for (size_t j = 0; j < stack_count(stack); j++) {
+            int c           = (int) stack->items[j].color;
+            features[c]     = (float) (BOARD_SIZE - 1 - b) / (BOARD_SIZE - 1);
+            features[7 + c] = (float) j / (N_CAMELS - 1);
+        }
+        if (b < BOARD_SIZE - 1 && game->board[b].has_spec) {
+            features[14 + b] = game->board[b].spec.orientation == FORWARD ? 1.0f : -1.0f;
+        }
+    }
+
+    DiceColor left[N_DICE + 1];
+    int n = remaining_dice(game, left);
+    for (int i = 0; i < n; i++) {
+        features[30 + (int) left[i]] = 1.0f;
+    }
+
+    for (int c = 0; c < N_BETS_COLORS; c++) {
+        Ticket* t = top_ticket(&game->tickets[c]);
+        if (t != NULL) {
+            features[36 + c] = (float) t->amount / 5.0f;
+        }
+    }
+
+    for (int p = 0; p < N_PLAYERS; p++) {
+        features[41 + p] = (float) game->players[p].points / 10.0f;
+        for (int c = 0; c < N_BETS_COLORS; c++) {
+            features[47 + p * N_BETS_COLORS + c] = has_card_in_hand(&game->players[p], (BetColor) c) ? 1.0f : 0.0f;
+        }
+    }
+}
+
+// n must be a multiple of 4, both arrays 16 byte aligned
+float dot(const float* a, const float* b, int n) {
+#ifdef __SSE__
+    __m128 acc = _mm_setzero_ps();
+    for (int i = 0; i < n; i += 4) {
+        acc = _mm_add_ps(acc, _mm_mul_ps(_mm_load_ps(a + i), _mm_load_ps(b + i)));
+    }
+    _Alignas(16) float lanes[4];
+    _mm_store_ps(lanes, acc);
+    return (lanes[0] + lanes[1]) + (lanes[2] + lanes[3]);
+#else
+    float acc = 0.0f;
+    for (int i = 0; i < n; i++) {
+        acc += a[i] * b[i];
+    }
+    return acc;
+#endif
+}
+
+void softmax_groups(float* out) {
+    for (int g = 0; g < N_EVAL_OUTPUTS; g += N_BETS_COLORS) {
+        float max = out[g];
+        for (int c = 1; c < N_BETS_COLORS; c++) {
+            max = out[g + c] > max ? out[g + c] : max;
+        }
+        float sum = 0.0f;
+        for (int c = 0; c < N_BETS_COLORS; c++) {
+            out[g + c] = expf(out[g + c] - max);
+            sum += out[g + c];
+        }
+        for (int c = 0; c < N_BETS_COLORS; c++) {
+            out[g + c] /= sum;
+        }
+    }
+}
+
+// features: n rows of N_FEATURES (16 byte aligned), out: n rows of N_EVAL_OUTPUTS probabilities
+void eval_batch(const Evaluator* ev, const float* features, int n, float* out) {
+    _Alignas(16) float hidden[EVAL_HIDDEN];
+    for (int i = 0; i < n; i++) {
+        const float* x = features + (size_t) i * N_FEATURES;
+        float* y       = out + (size_t) i * N_EVAL_OUTPUTS;
+        if (ev->kind == EVAL_LINEAR) {
+            for (int o = 0; o < N_EVAL_OUTPUTS; o++) {
+                y[o] = dot(ev->w1[o], x, N_FEATURES) + ev->b1[o];
+            }
+        } else {
+            for (int h = 0; h < EVAL_HIDDEN; h++) {
+                float a   = dot(ev->w1[h], x, N_FEATURES) + ev->b1[h];
+                hidden[h] = a > 0.0f ? a : 0.0f;
+            }
+            for (int o = 0; o < N_EVAL_OUTPUTS; o++) {
+                y[o] = dot(ev->w2[o], hidden, EVAL_HIDDEN) + ev->b2[o];
+            }
+        }
+        softmax_groups(y);
+    }
+}
+
+void camels_eval_game(const Evaluator* ev, Game* game, float out[N_EVAL_OUTPUTS]) {
+    _Alignas(16) float features[N_FEATURES];
+    extract_features(game, features);
+    eval_batch(ev, features, 1, out);
+}
+
+bool read_floats(FILE* f, float* dst, int rows, int cols, int stride) {
+    for (int r = 0; r < rows; r++) {
+        for (int c = 0; c < cols; c++) {
+            if (fscanf(f, "%f", &dst[r * stride + c]) != 1) {
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+// text format: "camels-eval linear|mlp <features> <hidden> <outputs>" then w1, b1 (and w2, b2 for mlp) row-major
+bool camels_eval_load(Evaluator* ev, const char* path) {
+    FILE* f = fopen(path, "r");
+    if (f == NULL) {
+        return false;
+    }
+    char kind[16];
+    int n_in, hidden, n_out;
+    bool ok = fscanf(f, "camels-eval %15s %d %d %d", kind, &n_in, &hidden, &n_out) == 4 &&
+              n_in == N_FEATURES_USED && n_out == N_EVAL_OUTPUTS;
+    memset(ev, 0, sizeof(Evaluator));
+    if (ok && strcmp(kind, "linear") == 0) {
+        ev->kind = EVAL_LINEAR;
+        ok       = hidden == 0 && read_floats(f, &ev->w1[0][0], N_EVAL_OUTPUTS, N_FEATURES_USED, N_FEATURES) &&
+             read_floats(f, ev->b1, 1, N_EVAL_OUTPUTS, 0);
+    } else if (ok && strcmp(kind, "mlp") == 0) {
+        ev->kind = EVAL_MLP;
+        ok       = hidden == EVAL_HIDDEN && read_floats(f, &ev->w1[0][0], EVAL_HIDDEN, N_FEATURES_USED, N_FEATURES) &&
+             read_floats(f, ev->b1, 1, EVAL_HIDDEN, 0) &&
+             read_floats(f, &ev->w2[0][0], N_EVAL_OUTPUTS, EVAL_HIDDEN, EVAL_HIDDEN) &&
+             read_floats(f, ev->b2, 1, N_EVAL_OUTPUTS, 0);
+    } else {
+        ok = false;
+    }
+    fclose(f);
+    return ok;
+}
+
+void write_floats(FILE* f, const float* src, int rows, int cols, int stride) {
+    for (int r = 0; r < rows; r++) {
+        for (int c = 0; c < cols; c++) {
+            fprintf(f, "%.9g%c", (double) src[r * stride + c], c == cols - 1 ? '\n' : ' ');
+        }
+    }
+}
+
+bool eval_save(const Evaluator* ev, const char* path) {
+    FILE* f = fopen(path, "w");
+    if (f == NULL) {
+        return false;
+    }
+    if (ev->kind == EVAL_LINEAR) {
+        fprintf(f, "camels-eval linear %d 0 %d\n", N_FEATURES_USED, N_EVAL_OUTPUTS);
+        write_floats(f, &ev->w1[0][0], N_EVAL_OUTPUTS, N_FEATURES_USED, N_FEATURES);
+        write_floats(f, ev->b1, 1, N_EVAL_OUTPUTS, 0);
+    } else {
+        fprintf(f, "camels-eval mlp %d %d %d\n", N_FEATURES_USED, EVAL_HIDDEN, N_EVAL_OUTPUTS);
+        write_floats(f, &ev->w1[0][0], EVAL_HIDDEN, N_FEATURES_USED, N_FEATURES);
+        write_floats(f, ev->b1, 1, EVAL_HIDDEN, 0);
+        write_floats(f, &ev->w2[0][0], N_EVAL_OUTPUTS, EVAL_HIDDEN, EVAL_HIDDEN);
+        write_floats(f, ev->b2, 1, N_EVAL_OUTPUTS, 0);
+    }
+    return fclose(f) == 0;
+}
+
+//////////////////////////////////// Bots //////////////////////////////////////
+
+// every turn next_turn would accept from player_id, returns how many were written to buff
+int legal_turns(Game* game, int player_id, Turn* buff) {
+    int n     = 0;
+    buff[n++] = (Turn) {.turn_type = ROLL};
+
+    for (int c = 0; c < N_BETS_COLORS; c++) {
+        if (top_ticket(&game->tickets[c]) != NULL) {
+            buff[n++] = (Turn) {.turn_type = TICKET, .color = (BetColor) c};
+        }
+        if (has_card_in_hand(&game->players[player_id], (BetColor) c)) {
+            buff[n++] = (Turn) {.turn_type = WAGER, .orientation = FORWARD, .color = (BetColor) c};
+            buff[n++] = (Turn) {.turn_type = WAGER, .orientation = REVERSE, .color = (BetColor) c};
+        }
+    }
+
+    if (!game->players[player_id].used_spec) {
+        int spots[BOARD_SIZE];
+        Locations locations = {.count = 0, .capacity = BOARD_SIZE - 1, .items = spots};
+        get_possible_spec_location(game, &locations);
+        for (size_t i = 0; i < locations.count; i++) {
+            buff[n++] = (Turn) {.turn_type = SPECTATOR, .orientation = FORWARD, .position = spots[i]};
+            buff[n++] = (Turn) {.turn_type = SPECTATOR, .orientation = REVERSE, .position = spots[i]};
+        }
+    }
+    return n;
+}
+
+void camels_bot_random(Game* game, int player_id, Rng* rng, Turn* turn) {
+    Turn options[MAX_TURN_OPTIONS];
+    int n = legal_turns(game, player_id, options);
+    *turn = options[rng_range(rng, 0, n - 1)];
+}
+
+// takes the leader's ticket while it is worth 3 or more, wagers on the leader near the finish, otherwise rolls
+void camels_bot_greedy(Game* game, int player_id, Rng* rng, Turn* turn) {
+    (void) rng;
+    int first, second;
+    get_top_camels(game, &first, &second);
+    *turn = (Turn) {.turn_type = ROLL};
+
+    double lead = opponent_wager_rate(game);
+    if (lead > 0.75 && has_card_in_hand(&game->players[player_id], (BetColor) first)) {
+        *turn = (Turn) {.turn_type = WAGER, .orientation = FORWARD, .color = (BetColor) first};
+        return;
+    }
+    Ticket* t = top_ticket(&game->tickets[first]);
+    if (t != NULL && t->amount >= 3) {
+        *turn = (Turn) {.turn_type = TICKET, .color = (BetColor) first};
+    }
+}
+
+// plays game to the end with one policy per seat, dice come from dice and the policies draw from choices.
+// Returns the number of turns played
+int play_bot_game_streams(Game* game, Policy policies[N_PLAYERS], Rng* dice, Rng* choices, GameHooks* hooks) {
+    Rng* saved_rng  = camels_game_rng;
+    camels_game_rng = dice;
+
+    int curr_player_id = 0;
+    int first, second;
+    Turn turn = {0};
+    while (!game->winner) {
+        while (game->dice.count != N_DICE && !game->winner) {
+            if (hooks != NULL && hooks->on_turn != NULL) {
+                hooks->on_turn(hooks->ctx, game, curr_player_id);
+            }
+            policies[curr_player_id](game, curr_player_id, choices, &turn);
+            if (!next_turn(game, &turn, curr_player_id)) {
+                turn.turn_type = ROLL;
+                next_turn(game, &turn, curr_player_id);
+            }
+            if (hooks != NULL && hooks->on_turn_done != NULL) {
+                hooks->on_turn_done(hooks->ctx, game, curr_player_id, &turn);
+            }
+            curr_player_id = (curr_player_id + 1) % N_PLAYERS;
+            game->turn++;
+        }
+        score_round(game, &first, &second);
+        if (hooks != NULL && hooks->on_leg != NULL) {
+            hooks->on_leg(hooks->ctx, game, first, second);
+        }
+        end_round(game);
+    }
+
+    camels_game_rng = saved_rng;
+    return game->turn;
+}
+
+// play_bot_game_streams with one stream for the dice and the policies
+int camels_play_bot_game(Game* game, Policy policies[N_PLAYERS], Rng* rng, GameHooks* hooks) {
+    return play_bot_game_streams(game, policies, rng, rng, hooks);
+}
+
+//////////////////////////////////// Self-play Dataset //////////////////////////////////////
+// Training positions from bot games, one fixed 64 byte Sample per position. A dataset file is a
+// DatasetHeader followed by chunks of up to DATASET_CHUNK_RECORDS samples, each chunk a ChunkHeader and
+// either raw samples (mmap friendly) or samples XORed with the previous one and zero-run encoded
+
+#define DATASET_MAGIC         "CMLSDATA"
+#define DATASET_VERSION       1
+#define DATASET_CHUNK_RECORDS 4096
+#define CHUNK_MAGIC           0x4b4e4843u // "CHNK"
+#define CHUNK_COMPRESSED      1u
+#define LABEL_UNKNOWN         0xff
+#define MAX_GAME_SAMPLES      512
+#define SELF_PLAY_WINDOW      64 // finished games held back waiting for an earlier one
+
+typedef struct {
+    uint8_t camel_tile[N_CAMELS];
+    uint8_t camel_height[N_CAMELS];
+    int8_t spec[BOARD_SIZE - 1]; // +1, -1 or 0
+    uint8_t dice_left;           // bit per DiceColor
+    uint8_t ticket_top[N_BETS_COLORS];
+    uint8_t hands[N_PLAYERS]; // bit per BetColor
+    int16_t points[N_PLAYERS];
+    uint8_t to_move;
+    uint8_t round;
+    uint8_t winner_bets;
+    uint8_t loser_bets;
+    // labels
+    uint8_t leg_first;
+    uint8_t leg_second;
+    uint8_t race_first;
+    uint8_t race_last;
+    uint8_t reserved[2];
+} Sample;
+
+_Static_assert(sizeof(Sample) == 64, "Sample must stay a fixed 64 byte record");
+
+typedef struct {
+    char magic[8];
+    uint32_t version;
+    uint32_t record_size;
+} DatasetHeader;
+
+typedef struct {
+    uint32_t magic;
+    uint32_t n_records;
+    uint32_t flags;
+    uint32_t payload_bytes;
+} ChunkHeader;
+
+void encode_sample(Game* game, int to_move, Sample* sample) {
+    memset(sample, 0, sizeof(Sample));
+    for (int b = 0; b < BOARD_SIZE; b++) {
+        CamelStack* stack = &game->board[b].camel_stack;
+        for (size_t j = 0; j < stack_count(stack); j++) {
+            sample->camel_tile[stack->items[j].color]   = (uint8_t) b;
+            sample->camel_height[stack->items[j].color] = (uint8_t) j;
+        }
+        if (b < BOARD_SIZE - 1 && game->board[b].has_spec) {
+            sample->spec[b] = game->board[b].spec.orientation == FORWARD ? 1 : -1;
+        }
+    }
+    DiceColor left[N_DICE + 1];
+    int n = remaining_dice(game, left);
+    for (int i = 0; i < n; i++) {
+        sample->dice_left |= (uint8_t) (1u << left[i]);
+    }
+    for (int c = 0; c < N_BETS_COLORS; c++) {
+        Ticket* t = top_ticket(&game->tickets[c]);
+        if (t != NULL) {
+            sample->ticket_top[c] = (uint8_t) t->amount;
+        }
+    }
+    for (int p = 0; p < N_PLAYERS; p++) {
+        sample->points[p] = game->players[p].points;
+        sample->hands[p]  = game->players[p].hand;
+    }
+    sample->to_move     = (uint8_t) to_move;
+    sample->round       = (uint8_t) game->round;
+    sample->winner_bets = (uint8_t) game->winner_bets.count;
+    sample->loser_bets  = (uint8_t) game->loser_bets.count;
+    sample->leg_first   = LABEL_UNKNOWN;
+    sample->leg_second  = LABEL_UNKNOWN;
+    sample->race_first  = LABEL_UNKNOWN;
+    sample->race_last   = LABEL_UNKNOWN;
+}
+
+// XOR against the previous record then run-length encode zero bytes as (0, run). dst needs 2 * n * 64 bytes
+size_t compress_samples(const Sample* samples, size_t n, uint8_t* dst) {
+    const uint8_t* src = (const uint8_t*) samples;
+    size_t len = n * sizeof(Sample), out = 0;
+    size_t i = 0;
+    while (i < len) {
+        uint8_t b = (uint8_t) (src[i] ^ (i >= sizeof(Sample) ? src[i - sizeof(Sample)] : 0));
+        if (b != 0) {
+            dst[out++] = b;
+            i++;
+            continue;
+        }
+        size_t run = 0;
+        while (i < len && run < 255 && (src[i] ^ (i >= sizeof(Sample) ? src[i - sizeof(Sample)] : 0)) == 0) {
+            run++;
+            i++;
+        }
+        dst[out++] = 0;
+        dst[out++] = (uint8_t) run;
+    }
+    return out;
+}
+
+// false if the payload does not decode to exactly n samples
+bool decompress_samples(const uint8_t* src, size_t src_len, Sample* samples, size_t n) {
+    uint8_t* dst = (uint8_t*) samples;
+    size_t len = n * sizeof(Sample), out = 0;
+    for (size_t i = 0; i < src_len; i++) {
+        if (src[i] != 0) {
+            if (out >= len) {
+                return false;
+            }
+            dst[out++] = src[i];
+            continue;
+        }
+        if (++i >= src_len || out + src[i] > len) {
+            return false;
+        }
+        memset(dst + out, 0, src[i]);
+        out += src[i];
+    }
+    if (out != len) {
+        return false;
+    }
+    for (size_t j = sizeof(Sample); j < len; j++) {
+        dst[j] ^= dst[j - sizeof(Sample)];
+    }
+    return true;
+}
+
+typedef struct {
+    FILE* file;
+    bool compress;
+    pthread_mutex_t lock;
+    uint64_t records;
+    uint64_t bytes;
+} DatasetWriter;
+
+bool dataset_create(DatasetWriter* writer, const char* path, bool compress) {
+    writer->file = fopen(path, "wb");
+    if (writer->file == NULL) {
+        return false;
+    }
+    DatasetHeader header = {.version = DATASET_VERSION, .record_size = sizeof(Sample)};
+    memcpy(header.magic, DATASET_MAGIC, sizeof(header.magic));
+    writer->compress = compress;
+    writer->records  = 0;
+    writer->bytes    = sizeof(header);
+    pthread_mutex_init(&writer->lock, NULL);
+    return fwrite(&header, sizeof(header), 1, writer->file) == 1;
+}
+
+// appends one chunk, safe to call from several threads
+bool dataset_write_chunk(DatasetWriter* writer, const Sample* samples, size_t n) {
+    static _Thread_local uint8_t packed[2 * DATASET_CHUNK_RECORDS * sizeof(Sample)];
+    assert(n <= DATASET_CHUNK_RECORDS && "Chunk too large");
+
+    ChunkHeader header  = {.magic = CHUNK_MAGIC, .n_records = (uint32_t) n};
+    const void* payload = samples;
+    size_t payload_len  = n * sizeof(Sample);
+    if (writer->compress) {
+        size_t packed_len = compress_samples(samples, n, packed);
+        if (packed_len < payload_len) {
+            header.flags = CHUNK_COMPRESSED;
+            payload      = packed;
+            payload_len  = packed_len;
+        }
+    }
+    header.payload_bytes = (uint32_t) payload_len;
+
+    pthread_mutex_lock(&writer->lock);
+    bool ok = fwrite(&header, sizeof(header), 1, writer->file) == 1 &&
+              fwrite(payload, 1, payload_len, writer->file) == payload_len;
+    writer->records += n;
+    writer->bytes += sizeof(header) + payload_len;
+    pthread_mutex_unlock(&writer->lock);
+    return ok;
+}
+
+bool dataset_close(DatasetWriter* writer) {
+    pthread_mutex_destroy(&writer->lock);
+    return fclose(writer->file) == 0;
+}
+
+// sequential reader over a FILE
+typedef struct {
+    FILE* file;
+    Sample chunk[DATASET_CHUNK_RECORDS];
+    size_t count;
+    size_t next;
+} DatasetReader;
+
+bool check_dataset_header(const DatasetHeader* header) {
+    return memcmp(header->magic, DATASET_MAGIC, sizeof(header->magic)) == 0 && header->version == DATASET_VERSION &&
+           header->record_size == sizeof(Sample);
+}
+
+bool dataset_open(DatasetReader* reader, const char* path) {
+    DatasetHeader header;
+    reader->file  = fopen(path, "rb");
+    reader->count = 0;
+    reader->next  = 0;
+    if (reader->file == NULL) {
+        return false;
+    }
+    if (fread(&header, sizeof(header), 1, reader->file) != 1 || !check_dataset_header(&header)) {
+        fclose(reader->file);
+        return false;
+    }
+    return true;
+}
+
+// false at end of file or on a corrupt chunk
+bool dataset_next(DatasetReader* reader, Sample* sample) {
+    static _Thread_local uint8_t packed[2 * DATASET_CHUNK_RECORDS * sizeof(Sample)];
+    while (reader->next == reader->count) {
+        ChunkHeader header;
+        if (fread(&header, sizeof(header), 1, reader->file) != 1 || header.magic != CHUNK_MAGIC ||
+            header.n_records > DATASET_CHUNK_RECORDS || header.payload_bytes > sizeof(packed)) {
+            return false;
+        }
+        if (fread(packed, 1, header.payload_bytes, reader->file) != header.payload_bytes) {
+            return false;
+        }
+        if (header.flags & CHUNK_COMPRESSED) {
+            if (!decompress_samples(packed, header.payload_bytes, reader->chunk, header.n_records)) {
+                return false;
+            }
+        } else if (header.payload_bytes == header.n_records * sizeof(Sample)) {
+            memcpy(reader->chunk, packed, header.payload_bytes);
+        } else {
+            return false;
+        }
+        reader->count = header.n_records;
+        reader->next  = 0;
+    }
+    *sample = reader->chunk[reader->next++];
+    return true;
+}
+
+void dataset_close_reader(DatasetReader* reader) { fclose(reader->file); }
+
+// whole file mapped read-only, chunks walked in place
+typedef struct {
+    const uint8_t* data;
+    size_t size;
+    size_t offset;
+} DatasetMap;
+
+bool dataset_map(DatasetMap* map, const char* path) {
+    struct stat st;
+    FILE* f = fopen(path, "rb");
+    if (f == NULL) {
+        return false;
+    }
+    bool ok = fstat(fileno(f), &st) == 0 && (size_t) st.st_size >= sizeof(DatasetHeader);
+    if (ok) {
+        map->size = (size_t) st.st_size;
+        void* mem = mmap(NULL, map->size, PROT_READ, MAP_PRIVATE, fileno(f), 0);
+        ok        = mem != MAP_FAILED;
+        map->data = mem;
+    }
+    fclose(f);
+    if (ok && !check_dataset_header((const DatasetHeader*) map->data)) {
+        munmap((void*) map->data, map->size);
+        ok = false;
+    }
+    map->offset = sizeof(DatasetHeader);
+    return ok;
+}
+
+// next chunk's samples, pointing into the mapping for raw chunks and decoded into scratch for compressed ones.
+// NULL at the end or on a corrupt chunk
+const Sample* dataset_map_chunk(DatasetMap* map, Sample scratch[DATASET_CHUNK_RECORDS], size_t* n) {
+    ChunkHeader header;
+    if (map->offset + sizeof(header) > map->size) {
+        return NULL;
+    }
+    memcpy(&header, map->data + map->offset, sizeof(header));
+    const uint8_t* payload = map->data + map->offset + sizeof(header);
+    if (header.magic != CHUNK_MAGIC || header.n_records > DATASET_CHUNK_RECORDS ||
+        map->offset + sizeof(header) + header.payload_bytes > map->size) {
+        return NULL;
+    }
+    map->offset += sizeof(header) + header.payload_bytes;
+    *n = header.n_records;
+    if (header.flags & CHUNK_COMPRESSED) {
+        return decompress_samples(payload, header.payload_bytes, scratch, header.n_records) ? scratch : NULL;
+    }
+    return header.payload_bytes == header.n_records * sizeof(Sample) ? (const Sample*) payload : NULL;
+}
+
+void dataset_unmap(DatasetMap* map) { munmap((void*) map->data, map->size); }
+
+// games finish out of order across threads, so each one's samples wait here until every earlier game is
+// written. The file then holds the games in index order and its bytes do not depend on the thread count
+typedef struct {
+    pthread_mutex_t lock;
+    pthread_cond_t advanced;
+    DatasetWriter* writer;
+    long next;     // oldest game not yet written
+    Sample* slots; // SELF_PLAY_WINDOW games of MAX_GAME_SAMPLES, by game index modulo the window
+    size_t counts[SELF_PLAY_WINDOW];
+    bool ready[SELF_PLAY_WINDOW];
+    Sample chunk[DATASET_CHUNK_RECORDS];
+    size_t n_chunk;
+    bool ok;
+} SelfPlayOrder;
+
+typedef struct {
+    SelfPlayConfig* config;
+    SelfPlayOrder* order;
+    atomic_long* next_game;
+    int index; // for placement_enter
+    bool ok;
+    Rng rng;
+    Sample game_samples[MAX_GAME_SAMPLES];
+    size_t n_game, leg_start;
+} SelfPlayWorker;
+
+// appends samples to the pending chunk, writing it out when full. Caller holds order->lock
+void self_play_append(SelfPlayOrder* order, const Sample* samples, size_t n) {
+    for (size_t i = 0; i < n; i++) {
+        order->chunk[order->n_chunk++] = samples[i];
+        if (order->n_chunk == DATASET_CHUNK_RECORDS) {
+            order->ok      = dataset_write_chunk(order->writer, order->chunk, order->n_chunk) && order->ok;
+            order->n_chunk = 0;
+        }
+    }
+}
+
+// hands game g's samples over, then writes every finished game that is next in line.
+// Blocks while g is a whole window ahead of the oldest unwritten game, which is always being played
+void self_play_emit(SelfPlayOrder* order, long g, const Sample* samples, size_t n) {
+    pthread_mutex_lock(&order->lock);
+    while (g - order->next >= SELF_PLAY_WINDOW) {
+        pthread_cond_wait(&order->advanced, &order->lock);
+    }
+    size_t slot = (size_t) (g % SELF_PLAY_WINDOW);
+    memcpy(order->slots + slot * MAX_GAME_SAMPLES, samples, n * sizeof(Sample));
+    order->counts[slot] = n;
+    order->ready[slot]  = true;
+
+    bool advanced = false;
+    while (order->ready[slot = (size_t) (order->next % SELF_PLAY_WINDOW)]) {
+        self_play_append(order, order->slots + slot * MAX_GAME_SAMPLES, order->counts[slot]);
+        order->ready[slot] = false;
+        order->next++;
+        advanced = true;
+    }
+    if (advanced) {
+        pthread_cond_broadcast(&order->advanced);
+    }
+    pthread_mutex_unlock(&order->lock);
+}
+
+void self_play_on_turn(void* ctx, Game* game, int player_id) {
+    SelfPlayWorker* w = ctx;
+    if (w->n_game < MAX_GAME_SAMPLES && (double) (rng_next(&w->rng) >> 11) * 0x1.0p-53 < w->config->sample_rate) {
+        encode_sample(game, player_id, &w->game_samples[w->n_game++]);
+    }
+}
+
+void self_play_on_leg(void* ctx, Game* game, int first, int second) {
+    (void) game;
+    SelfPlayWorker* w = ctx;
+    for (size_t i = w->leg_start; i < w->n_game; i++) {
+        w->game_samples[i].leg_first  = (uint8_t) first;
+        w->game_samples[i].leg_second = (uint8_t) second;
+    }
+    w->leg_start = w->n_game;
+}
+
+void* self_play_worker(void* arg) {
+    SelfPlayWorker* w  = arg;
+    Policy pool[2]     = {camels_bot_random, camels_bot_greedy};
+    GameHooks hooks    = {.on_turn = self_play_on_turn, .on_leg = self_play_on_leg, .ctx = w};
+    WorkerBlock* block = worker_block_get(placement_enter(w->index));
+    if (block == NULL) {
+        w->ok = false;
+        return NULL;
+    }
+    Game* game = &block->game;
+
+    w->ok = true;
+    long g;
+    while ((g = atomic_fetch_add(w->next_game, 1)) < w->config->games) {
+        // every game gets its own stream and is written in index order, so the dataset does not depend on
+        // the thread count
+        Rng rng        = {.state = w->config->seed ^ ((uint64_t) g * 0xD1B54A32D192ED03ULL)};
+        w->rng.state   = rng_next(&rng);
+        Policy seats[N_PLAYERS];
+        for (int p = 0; p < N_PLAYERS; p++) {
+            seats[p] = pool[rng_range(&rng, 0, 1)];
+        }
+        memset(game, 0, sizeof(Game));
+        camels_game_rng = &rng;
+        camels_init_game(game);
+        camels_game_rng = NULL;
+
+        w->n_game = w->leg_start = 0;
+        camels_play_bot_game(game, seats, &rng, &hooks);
+
+        int first, second;
+        get_top_camels(game, &first, &second);
+        int last = get_last_camel(game);
+        for (size_t i = 0; i < w->n_game; i++) {
+            w->game_samples[i].race_first = (uint8_t) first;
+            w->game_samples[i].race_last  = (uint8_t) last;
+        }
+        self_play_emit(w->order, g, w->game_samples, w->n_game);
+    }
+    worker_block_put(block);
+    return NULL;
+}
+
+// plays config->games bot games across threads and streams sampled positions to path
+bool camels_self_play(SelfPlayConfig* config, const char* path, SelfPlayResult* result) {
+    DatasetWriter writer;
+    if (!dataset_create(&writer, path, config->compress)) {
+        return false;
+    }
+    int threads = config->threads > 0 ? config->threads : (int) sysconf(_SC_NPROCESSORS_ONLN);
+    threads     = threads > 0 ? threads : 1;
+
+    bool saved_log     = camels_log_enabled;
+    camels_log_enabled = false;
+    atomic_long next_game;
+    atomic_init(&next_game, 0);
+    SelfPlayOrder* order    = calloc(1, sizeof(SelfPlayOrder));
+    SelfPlayWorker* workers = calloc((size_t) threads, sizeof(SelfPlayWorker));
+    pthread_t* ids          = calloc((size_t) threads, sizeof(pthread_t));
+    assert(order != NULL && workers != NULL && ids != NULL && "Out of memory");
+    order->slots = malloc(SELF_PLAY_WINDOW * MAX_GAME_SAMPLES * sizeof(Sample));
+    assert(order->slots != NULL && "Out of memory");
+    order->writer = &writer;
+    order->ok     = true;
+    pthread_mutex_init(&order->lock, NULL);
+    pthread_cond_init(&order->advanced, NULL);
+
+    uint64_t start = now_ns();
+    for (int t = 0; t < threads; t++) {
+        workers[t] = (SelfPlayWorker) {.config = config, .order = order, .next_game = &next_game, .index = t};
+        pthread_create(&ids[t], NULL, self_play_worker, &workers[t]);
+    }
+    bool ok = true;
+    for (int t = 0; t < threads; t++) {
+        pthread_join(ids[t], NULL);
+        ok = ok && workers[t].ok;
+    }
+    if (order->n_chunk > 0) {
+        order->ok = dataset_write_chunk(&writer, order->chunk, order->n_chunk) && order->ok;
+    }
+    ok = ok && order->ok && order->next == config->games;
+    result->seconds   = (double) (now_ns() - start) / 1e9;
+    result->games     = config->games;
+    result->positions = writer.records;
+    result->bytes     = writer.bytes;
+
+    pthread_cond_destroy(&order->advanced);
+    pthread_mutex_destroy(&order->lock);
+    free(order->slots);
+    free(order);
+    free(workers);
+    free(ids);
+    camels_log_enabled = saved_log;
+    return dataset_close(&writer) && ok;
+}
+
+//////////////////////////////////// Columnar Export //////////////////////////////////////
+// Two tables from a batch of bot games: one row per game (seed, winner and how many turn rows it owns) and
+// one row per turn, the turn rows of a game following each other in game order. Each table is stored column
+// by column in row groups of COLUMN_GROUP_ROWS. Each column chunk picks the smallest of plain RLE, RLE over
+// deltas, RLE over deltas modulo the value range (seats cycling round the table become one run per game), a
+// bit-packed dictionary or a Huffman-coded dictionary, and its header carries its byte length so a reader
+// can skip the chunks of every column it does not want
+
+#define COLUMN_MAGIC      "CMLSCOL2"
+#define COLUMN_GROUP_ROWS 65536
+#define MAX_GAME_TURNS    1024
+#define HUFFMAN_MAX_BITS  32
+
+typedef enum {
+    // per game
+    COL_SEED,
+    COL_GAME,
+    COL_WINNER,
+    COL_TURNS,
+    // per turn
+    COL_SEAT,
+    COL_TURN_TYPE,
+    COL_COLOR,
+    COL_POINTS_DELTA,
+    COL_ROUND,
+    N_COLUMNS
+} Column;
+typedef enum { TABLE_GAMES, TABLE_TURNS, N_TABLES } ColumnTable;
+typedef enum { CTYPE_U8, CTYPE_I8, CTYPE_U16, CTYPE_U32, CTYPE_U64 } ColumnType;
+typedef enum { ENC_RLE, ENC_DELTA_RLE, ENC_MOD_DELTA_RLE, ENC_DICT, ENC_HUFFMAN, N_ENCODINGS } ColumnEncoding;
+
+const ColumnTable column_tables[N_COLUMNS] = {TABLE_GAMES, TABLE_GAMES, TABLE_GAMES, TABLE_GAMES, TABLE_TURNS,
+                                              TABLE_TURNS, TABLE_TURNS, TABLE_TURNS, TABLE_TURNS};
+const ColumnType column_types[N_COLUMNS]   = {CTYPE_U64, CTYPE_U32, CTYPE_U8, CTYPE_U16, CTYPE_U8,
+                                              CTYPE_U8,  CTYPE_I8,  CTYPE_I8, CTYPE_U8};
+const char* column_names[N_COLUMNS]        = {"seed",      "game",  "winner",       "turns", "seat",
+                                              "turn_type", "color", "points_delta", "round"};
+
+typedef struct {
+    uint8_t column;
+    uint8_t type;
+    uint8_t encoding;
+    uint8_t reserved;
+    uint32_t rows;
+    uint32_t bytes;
+} ColumnChunkHeader;
+
+size_t put_varint(uint8_t* dst, uint64_t v) {
+    size_t n = 0;
+    while (v >= 0x80) {
+        dst[n++] = (uint8_t) (v | 0x80);
+        v >>= 7;
+    }
+    dst[n++] = (uint8_t) v;
+    return n;
+}
+
+// false on a truncated varint
+bool get_varint(const uint8_t* src, size_t len, size_t* pos, uint64_t* v) {
+    *v = 0;
+    for (int shift = 0; *pos < len && shift < 64; shift += 7) {
+        uint8_t b = src[(*pos)++];
+        *v |= (uint64_t) (b & 0x7f) << shift;
+        if (!(b & 0x80)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+uint64_t zigzag(int64_t v) { return ((uint64_t) v << 1) ^ (uint64_t) (v >> 63); }
+int64_t unzigzag(uint64_t v) { return (int64_t) (v >> 1) ^ -(int64_t) (v & 1); }
+
+size_t encode_rle(const int64_t* values, size_t n, bool delta, uint8_t* dst) {
+    size_t out = 0;
+    int64_t prev = 0;
+    for (size_t i = 0; i < n;) {
+        int64_t v  = delta ? values[i] - prev : values[i];
+        size_t run = 1;
+        while (i + run < n && (delta ? values[i + run] - values[i + run - 1] : values[i + run]) == v) {
+            run++;
+        }
+        out += put_varint(dst + out, zigzag(v));
+        out += put_varint(dst + out, run);
+        prev = values[i + run - 1];
+        i += run;
+    }
+    return out;
+}
+
+// min and span of the chunk's values then RLE of (value - previous) mod span
+size_t encode_mod_delta(const int64_t* values, size_t n, uint8_t* dst) {
+    int64_t min = values[0], max = values[0];
+    for (size_t i = 1; i < n; i++) {
+        min = values[i] < min ? values[i] : min;
+        max = values[i] > max ? values[i] : max;
+    }
+    uint64_t span = (uint64_t) (max - min) + 1;
+    size_t out    = put_varint(dst, zigzag(min));
+    out += put_varint(dst + out, span);
+    uint64_t prev = 0;
+    for (size_t i = 0; i < n;) {
+        uint64_t d  = ((uint64_t) (values[i] - min) + span - prev) % span;
+        size_t run = 1;
+        while (i + run < n && ((uint64_t) (values[i + run] - values[i + run - 1]) + span) % span == d) {
+            run++;
+        }
+        out += put_varint(dst + out, d);
+        out += put_varint(dst + out, run);
+        prev = (uint64_t) (values[i + run - 1] - min);
+        i += run;
+    }
+    return out;
+}
+
+// 0 if the chunk has more than 256 distinct values
+size_t encode_dict(const int64_t* values, size_t n, uint8_t* dst) {
+    int64_t dict[256];
+    int n_dict = 0;
+    for (size_t i = 0; i < n; i++) {
+        int d = 0;
+        while (d < n_dict && dict[d] != values[i]) {
+            d++;
+        }
+        if (d == n_dict) {
+            if (n_dict == 256) {
+                return 0;
+            }
+            dict[n_dict++] = values[i];
+        }
+    }
+    int width = 0;
+    while ((1 << width) < n_dict) {
+        width++;
+    }
+    size_t out = put_varint(dst, (uint64_t) n_dict);
+    for (int d = 0; d < n_dict; d++) {
+        out += put_varint(dst + out, zigzag(dict[d]));
+    }
+    dst[out++] = (uint8_t) width;
+    size_t packed = (n * (size_t) width + 7) / 8;
+    memset(dst + out, 0, packed);
+    for (size_t i = 0; i < n && width > 0; i++) {
+        int d = 0;
+        while (dict[d] != values[i]) {
+            d++;
+        }
+        for (int b = 0; b < width; b++) {
+            if (d & (1 << b)) {
+                size_t bit = i * (size_t) width + (size_t) b;
+                dst[out + bit / 8] |= (uint8_t) (1u << (bit % 8));
+            }
+        }
+    }
+    return out + packed;
+}
+
+// distinct values of a chunk with their counts, false past 256 of them
+bool column_dict(const int64_t* values, size_t n, int64_t dict[256], uint32_t counts[256], int* n_dict) {
+    *n_dict = 0;
+    for (size_t i = 0; i < n; i++) {
+        int d = 0;
+        while (d < *n_dict && dict[d] != values[i]) {
+            d++;
+        }
+        if (d == *n_dict) {
+            if (d == 256) {
+                return false;
+            }
+            dict[(*n_dict)++] = values[i];
+            counts[d]         = 0;
+        }
+        counts[d]++;
+    }
+    return true;
+}
+
+// Huffman code lengths of n_dict symbols, one pair of lightest subtrees merged at a time
+void huffman_lengths(const uint32_t counts[256], int n_dict, uint8_t lengths[256]) {
+    uint64_t weight[511];
+    int parent[511];
+    bool merged[511] = {false};
+    for (int d = 0; d < n_dict; d++) {
+        weight[d] = counts[d];
+    }
+    int nodes = n_dict;
+    for (int left = n_dict; left > 1; left--) {
+        int a = -1, b = -1;
+        for (int i = 0; i < nodes; i++) {
+            if (merged[i]) {
+                continue;
+            }
+            if (a < 0 || weight[i] < weight[a]) {
+                b = a;
+                a = i;
+            } else if (b < 0 || weight[i] < weight[b]) {
+                b = i;
+            }
+        }
+        weight[nodes] = weight[a] + weight[b];
+        parent[a] = parent[b] = nodes;
+        merged[a] = merged[b] = true;
+        nodes++;
+    }
+    for (int d = 0; d < n_dict; d++) {
+        int depth = 0;
+        for (int i = d; i != nodes - 1; i = parent[i]) {
+            depth++;
+        }
+        lengths[d] = (uint8_t) depth;
+    }
+}
+
+// symbols ordered by code length then index, the order canonical codes are handed out in
+int huffman_order(const uint8_t lengths[256], int n_dict, uint8_t order[256]) {
+    int n = 0;
+    for (int len = 1; len <= HUFFMAN_MAX_BITS; len++) {
+        for (int d = 0; d < n_dict; d++) {
+            if (lengths[d] == len) {
+                order[n++] = (uint8_t) d;
+            }
+        }
+    }
+    return n;
+}
+
+// dictionary with a code length per entry, then each value's canonical Huffman code. A lone value takes
+// no bits at all. 0 if the chunk has more than 256 distinct values
+size_t encode_huffman(const int64_t* values, size_t n, uint8_t* dst) {
+    int64_t dict[256];
+    uint32_t counts[256], codes[256];
+    uint8_t lengths[256], order[256];
+    int n_dict;
+    if (!column_dict(values, n, dict, counts, &n_dict)) {
+        return 0;
+    }
+    huffman_lengths(counts, n_dict, lengths);
+    size_t out = put_varint(dst, (uint64_t) n_dict);
+    for (int d = 0; d < n_dict; d++) {
+        out += put_varint(dst + out, zigzag(dict[d]));
+        dst[out++] = lengths[d];
+    }
+    int n_coded   = huffman_order(lengths, n_dict, order);
+    uint32_t code = 0;
+    for (int i = 0; i < n_coded; i++) {
+        code <<= i > 0 ? lengths[order[i]] - lengths[order[i - 1]] : lengths[order[i]];
+        codes[order[i]] = code++;
+    }
+
+    size_t bit = 0;
+    for (size_t i = 0; i < n; i++) {
+        int d = 0;
+        while (dict[d] != values[i]) {
+            d++;
+        }
+        for (int b = lengths[d] - 1; b >= 0; b--, bit++) {
+            if (bit % 8 == 0) {
+                dst[out + bit / 8] = 0;
+            }
+            dst[out + bit / 8] |= (uint8_t) (((codes[d] >> b) & 1) << (bit % 8));
+        }
+    }
+    return out + (bit + 7) / 8;
+}
+
+bool decode_column(ColumnEncoding encoding, const uint8_t* src, size_t len, int64_t* values, size_t n) {
+    size_t pos = 0;
+    uint64_t v, run;
+    switch (encoding) {
+        case ENC_RLE:
+        case ENC_DELTA_RLE: {
+            int64_t prev = 0;
+            for (size_t i = 0; i < n;) {
+                if (!get_varint(src, len, &pos, &v) || !get_varint(src, len, &pos, &run) || run > n - i) {
+                    return false;
+                }
+                for (uint64_t r = 0; r < run; r++, i++) {
+                    prev      = encoding == ENC_DELTA_RLE ? prev + unzigzag(v) : unzigzag(v);
+                    values[i] = prev;
+                }
+            }
+            return pos == len;
+        }
+        case ENC_MOD_DELTA_RLE: {
+            uint64_t min, span, prev = 0;
+            if (!get_varint(src, len, &pos, &min) || !get_varint(src, len, &pos, &span) || span == 0) {
+                return false;
+            }
+            for (size_t i = 0; i < n;) {
+                if (!get_varint(src, len, &pos, &v) || !get_varint(src, len, &pos, &run) || run > n - i) {
+                    return false;
+                }
+                for (uint64_t r = 0; r < run; r++, i++) {
+                    prev      = (prev + v) % span;
+                    values[i] = unzigzag(min) + (int64_t) prev;
+                }
+            }
+            return pos == len;
+        }
+        case ENC_DICT: {
+            int64_t dict[256];
+            uint64_t n_dict;
+            if (!get_varint(src, len, &pos, &n_dict) || n_dict > 256) {
+                return false;
+            }
+            for (uint64_t d = 0; d < n_dict; d++) {
+                if (!get_varint(src, len, &pos, &v)) {
+                    return false;
+                }
+                dict[d] = unzigzag(v);
+            }
+            if (pos >= len) {
+                return false;
+            }
+            int width = src[pos++];
+            if (width > 8 || pos + (n * (size_t) width + 7) / 8 != len) {
+                return false;
+            }
+            for (size_t i = 0; i < n; i++) {
+                uint64_t d = 0;
+                for (int b = 0; b < width; b++) {
+                    size_t bit = i * (size_t) width + (size_t) b;
+                    d |= (uint64_t) ((src[pos + bit / 8] >> (bit % 8)) & 1) << b;
+                }
+                if (d >= n_dict) {
+                    return false;
+                }
+                values[i] = dict[d];
+            }
+            return true;
+        }
+        case ENC_HUFFMAN: {
+            int64_t dict[256];
+            uint8_t lengths[256], order[256];
+            uint64_t n_dict;
+            if (!get_varint(src, len, &pos, &n_dict) || n_dict == 0 || n_dict > 256) {
+                return false;
+            }
+            for (uint64_t d = 0; d < n_dict; d++) {
+                if (!get_varint(src, len, &pos, &v) || pos >= len || src[pos] > HUFFMAN_MAX_BITS) {
+                    return false;
+                }
+                dict[d]    = unzigzag(v);
+                lengths[d] = src[pos++];
+            }
+            // canonical decoding: the codes of one length are consecutive from first[len]
+            uint32_t first[HUFFMAN_MAX_BITS + 1], count[HUFFMAN_MAX_BITS + 1] = {0}, offset[HUFFMAN_MAX_BITS + 1];
+            int n_coded = huffman_order(lengths, (int) n_dict, order);
+            for (int i = 0; i < n_coded; i++) {
+                count[lengths[order[i]]]++;
+            }
+            uint32_t code = 0, seen = 0;
+            for (int l = 1; l <= HUFFMAN_MAX_BITS; l++) {
+                code      = (code + count[l - 1]) << 1;
+                first[l]  = code;
+                offset[l] = seen;
+                seen += count[l];
+            }
+            size_t bit = 0, bits = (len - pos) * 8;
+            for (size_t i = 0; i < n; i++) {
+                if (n_coded == 0) {
+                    values[i] = dict[0];
+                    continue;
+                }
+                code = 0;
+                int l = 0;
+                do {
+                    if (++l > HUFFMAN_MAX_BITS || bit == bits) {
+                        return false;
+                    }
+                    code = code << 1 | (uint32_t) ((src[pos + bit / 8] >> (bit % 8)) & 1);
+                    bit++;
+                } while (code - first[l] >= count[l]);
+                values[i] = dict[order[offset[l] + code - first[l]]];
+            }
+            return pos + (bit + 7) / 8 == len;
+        }
+        case N_ENCODINGS:
+        default:
+            return false;
+    }
+}
+
+typedef struct {
+    FILE* file;
+    int64_t* values[N_COLUMNS]; // current row group of the column's table
+    size_t rows[N_TABLES];
+    uint8_t* scratch[N_ENCODINGS]; // one encode buffer per encoding
+    uint64_t total_rows[N_TABLES];
+    uint64_t bytes;
+} ColumnWriter;
+
+bool columns_create(ColumnWriter* writer, const char* path) {
+    memset(writer, 0, sizeof(ColumnWriter));
+    writer->file = fopen(path, "wb");
+    if (writer->file == NULL) {
+        return false;
+    }
+    for (int c = 0; c < N_COLUMNS; c++) {
+        writer->values[c] = malloc(COLUMN_GROUP_ROWS * sizeof(int64_t));
+    }
+    for (int e = 0; e < N_ENCODINGS; e++) {
+        writer->scratch[e] = malloc(COLUMN_GROUP_ROWS * 20 + 16); // two 10 byte varints per row at worst
+    }
+    writer->bytes = strlen(COLUMN_MAGIC);
+    return fwrite(COLUMN_MAGIC, 1, strlen(COLUMN_MAGIC), writer->file) == strlen(COLUMN_MAGIC);
+}
+
+bool columns_flush(ColumnWriter* writer, ColumnTable table) {
+    bool ok     = true;
+    size_t rows = writer->rows[table];
+    for (int c = 0; c < N_COLUMNS && rows > 0; c++) {
+        if (column_tables[c] != table) {
+            continue;
+        }
+        size_t sizes[N_ENCODINGS];
+        int64_t* values          = writer->values[c];
+        sizes[ENC_RLE]           = encode_rle(values, rows, false, writer->scratch[ENC_RLE]);
+        sizes[ENC_DELTA_RLE]     = encode_rle(values, rows, true, writer->scratch[ENC_DELTA_RLE]);
+        sizes[ENC_MOD_DELTA_RLE] = encode_mod_delta(values, rows, writer->scratch[ENC_MOD_DELTA_RLE]);
+        sizes[ENC_DICT]          = encode_dict(values, rows, writer->scratch[ENC_DICT]);
+        sizes[ENC_HUFFMAN]       = encode_huffman(values, rows, writer->scratch[ENC_HUFFMAN]);
+        int best                 = ENC_RLE;
+        for (int e = ENC_DELTA_RLE; e < N_ENCODINGS; e++) {
+            if (sizes[e] > 0 && sizes[e] < sizes[best]) {
+                best = e;
+            }
+        }
+        ColumnChunkHeader header = {.column   = (uint8_t) c,
+                                    .type     = (uint8_t) column_types[c],
+                                    .encoding = (uint8_t) best,
+                                    .rows     = (uint32_t) rows,
+                                    .bytes    = (uint32_t) sizes[best]};
+        ok = ok && fwrite(&header, sizeof(header), 1, writer->file) == 1 &&
+             fwrite(writer->scratch[best], 1, sizes[best], writer->file) == sizes[best];
+        writer->bytes += sizeof(header) + sizes[best];
+    }
+    writer->rows[table] = 0;
+    return ok;
+}
+
+// appends a row to table, taking the values of that table's columns from row
+bool columns_append(ColumnWriter* writer, ColumnTable table, const int64_t row[N_COLUMNS]) {
+    for (int c = 0; c < N_COLUMNS; c++) {
+        if (column_tables[c] == table) {
+            writer->values[c][writer->rows[table]] = row[c];
+        }
+    }
+    writer->total_rows[table]++;
+    if (++writer->rows[table] == COLUMN_GROUP_ROWS) {
+        return columns_flush(writer, table);
+    }
+    return true;
+}
+
+bool columns_close(ColumnWriter* writer) {
+    bool ok = columns_flush(writer, TABLE_GAMES);
+    ok      = columns_flush(writer, TABLE_TURNS) && ok;
+    for (int c = 0; c < N_COLUMNS; c++) {
+        free(writer->values[c]);
+    }
+    for (int e = 0; e < N_ENCODINGS; e++) {
+        free(writer->scratch[e]);
+    }
+    return fclose(writer->file) == 0 && ok;
+}
+
+// scans one column, seeking past the chunks of every other column
+typedef struct {
+    FILE* file;
+    Column column;
+    uint8_t* buff;
+} ColumnReader;
+
+bool columns_open(ColumnReader* reader, const char* path, Column column) {
+    char magic[sizeof(COLUMN_MAGIC)] = {0};
+    reader->file                     = fopen(path, "rb");
+    reader->column                   = column;
+    reader->buff                     = NULL;
+    if (reader->file == NULL) {
+        return false;
+    }
+    if (fread(magic, 1, strlen(COLUMN_MAGIC), reader->file) != strlen(COLUMN_MAGIC) ||
+        strcmp(magic, COLUMN_MAGIC) != 0) {
+        fclose(reader->file);
+        return false;
+    }
+    reader->buff = malloc(COLUMN_GROUP_ROWS * 20 + 16);
+    return true;
+}
+
+// decodes the next row group of the column into values (COLUMN_GROUP_ROWS long), 0 at the end or on a corrupt file
+size_t columns_next(ColumnReader* reader, int64_t* values) {
+    ColumnChunkHeader header;
+    while (fread(&header, sizeof(header), 1, reader->file) == 1) {
+        if (header.rows > COLUMN_GROUP_ROWS || header.bytes > COLUMN_GROUP_ROWS * 20 + 16) {
+            return 0;
+        }
+        if (header.column != reader->column) {
+            if (fseek(reader->file, (long) header.bytes, SEEK_CUR) != 0) {
+                return 0;
+            }
+            continue;
+        }
+        if (fread(reader->buff, 1, header.bytes, reader->file) != header.bytes ||
+            !decode_column((ColumnEncoding) header.encoding, reader->buff, header.bytes, values, header.rows)) {
+            return 0;
+        }
+        return header.rows;
+    }
+    return 0;
+}
+
+void columns_close_reader(ColumnReader* reader) {
+    free(reader->buff);
+    fclose(reader->file);
+}
+
+typedef struct {
+    uint64_t seed;
+    int points_before;
+    int64_t turns[MAX_GAME_TURNS][N_COLUMNS];
+    size_t n_turns;
+} ExportGame;
+
+void export_on_turn(void* ctx, Game* game, int player_id) {
+    ExportGame* e    = ctx;
+    e->points_before = game->players[player_id].points;
+}
+
+void export_on_turn_done(void* ctx, Game* game, int player_id, Turn* turn) {
+    ExportGame* e = ctx;
+    if (e->n_turns == MAX_GAME_TURNS) {
+        return;
+    }
+    int64_t color = -1; // spectator
+    if (turn->turn_type == ROLL) {
+        color = (int64_t) stack_peak(&game->dice).color;
+    } else if (turn->turn_type == WAGER || turn->turn_type == TICKET) {
+        color = (int64_t) turn->color;
+    }
+    int64_t* row           = e->turns[e->n_turns++];
+    row[COL_SEAT]          = player_id;
+    row[COL_TURN_TYPE]     = (int64_t) turn->turn_type;
+    row[COL_COLOR]         = color;
+    row[COL_POINTS_DELTA]  = game->players[player_id].points - e->points_before;
+    row[COL_ROUND]         = game->round;
+}
+
+// plays n_games bot games from seed and writes a row per game and one per turn to path. rows counts the turn
+// rows. Returns false on an I/O error
+bool camels_export_games(const char* path, long n_games, uint64_t seed, uint64_t* rows, uint64_t* bytes) {
+    ColumnWriter writer;
+    if (!columns_create(&writer, path)) {
+        return false;
+    }
+    static ExportGame e;
+    static Game game;
+    Policy pool[2]     = {camels_bot_random, camels_bot_greedy};
+    GameHooks hooks    = {.on_turn = export_on_turn, .on_turn_done = export_on_turn_done, .ctx = &e};
+    bool saved_log     = camels_log_enabled;
+    camels_log_enabled = false;
+
+    bool ok = true;
+    for (long g = 0; g < n_games && ok; g++) {
+        Rng rng = {.state = seed + (uint64_t) g};
+        e       = (ExportGame) {.seed = seed + (uint64_t) g};
+        Policy seats[N_PLAYERS];
+        for (int p = 0; p < N_PLAYERS; p++) {
+            seats[p] = pool[rng_range(&rng, 0, 1)];
+        }
+        memset(&game, 0, sizeof(Game));
+        camels_game_rng = &rng;
+        camels_init_game(&game);
+        camels_game_rng = NULL;
+        camels_play_bot_game(&game, seats, &rng, &hooks);
+
+        int first, second;
+        get_top_camels(&game, &first, &second);
+        int64_t row[N_COLUMNS] = {[COL_SEED] = (int64_t) e.seed, [COL_GAME] = g, [COL_WINNER] = first,
+                                  [COL_TURNS] = (int64_t) e.n_turns};
+        ok = columns_append(&writer, TABLE_GAMES, row);
+        for (size_t t = 0; t < e.n_turns && ok; t++) {
+            ok = columns_append(&writer, TABLE_TURNS, e.turns[t]);
+        }
+    }
+    camels_log_enabled = saved_log;
+    *rows              = writer.total_rows[TABLE_TURNS];
+    ok                 = columns_close(&writer) && ok;
+    *bytes             = writer.bytes;
+    return ok;
+}
+
+//////////////////////////////////// Sessions //////////////////////////////////////
+// A Game as a resumable state machine so one thread can interleave many games. camels_start_game sets it
+// up, camels_poll_events resumes it until it needs a human, finishes a leg, or fills the caller's event
+// buffer, and camels_submit_turn hands in a human's turn. Nothing blocks, dice come from the session's own stream
+
+bool push_event(Session* session, Event event) {
+    if (session->event_count == SESSION_EVENTS) {
+        return false;
+    }
+    session->events[(session->event_head + session->event_count++) % SESSION_EVENTS] = event;
+    return true;
+}
+
+void camels_start_game(Session* session, Policy seats[N_PLAYERS], uint64_t seed) {
+    memset(session, 0, sizeof(Session));
+    session->rng.state = seed;
+    memcpy(session->seats, seats, sizeof(session->seats));
+
+    Rng* saved      = camels_game_rng;
+    camels_game_rng = &session->rng;
+    camels_init_game(&session->game);
+    camels_game_rng = saved;
+    session->state  = STATE_TURN;
+}
+
+void finish_turn(Session* session, Turn* turn) {
+    push_event(session, (Event) {.type = EV_TURN, .player = session->curr_player_id, .turn = *turn});
+    session->curr_player_id = (session->curr_player_id + 1) % N_PLAYERS;
+    session->game.turn++;
+    session->state = STATE_TURN;
+}
+
+// runs one state transition, false when the session has to wait for a human or the game is over
+bool step_session(Session* session) {
+    Game* game = &session->game;
+    switch (session->state) {
+        case STATE_TURN: {
+            if (game->dice.count == N_DICE || game->winner) {
+                session->state = STATE_SCORE;
+                return true;
+            }
+            Policy policy = session->seats[session->curr_player_id];
+            if (policy == NULL) {
+                session->state = STATE_WAIT_INPUT;
+                push_event(session, (Event) {.type = EV_AWAIT_TURN, .player = session->curr_player_id});
+                return false;
+            }
+            Turn turn;
+            policy(game, session->curr_player_id, &session->rng, &turn);
+            if (!next_turn(game, &turn, session->curr_player_id)) {
+                turn = (Turn) {.turn_type = ROLL};
+                next_turn(game, &turn, session->curr_player_id);
+            }
+            finish_turn(session, &turn);
+            return true;
+        }
+        case STATE_SCORE: {
+            Event event = {.type = EV_LEG_SCORED};
+            score_round(game, &event.first, &event.second);
+            push_event(session, event);
+            session->state = STATE_END_ROUND;
+            return true;
+        }
+        case STATE_END_ROUND: {
+            end_round(game);
+            push_event(session, (Event) {.type = EV_ROUND_ENDED});
+            session->state = game->winner ? STATE_GAME_OVER : STATE_TURN;
+            if (game->winner) {
+                push_event(session, (Event) {.type = EV_GAME_OVER});
+            }
+            return !game->winner;
+        }
+        case STATE_WAIT_INPUT:
+        case STATE_GAME_OVER:
+        default:
+            return false;
+    }
+}
+
+// false if it is not player_id's turn or next_turn rejects the turn, the session then asks again
+bool camels_submit_turn(Session* session, int player_id, Turn* turn) {
+    if (session->state != STATE_WAIT_INPUT || player_id != session->curr_player_id) {
+        return false;
+    }
+    Rng* saved      = camels_game_rng;
+    camels_game_rng = &session->rng;
+    bool valid      = next_turn(&session->game, turn, player_id);
+    camels_game_rng = saved;
+    if (!valid) {
+        push_event(session, (Event) {.type = EV_REJECTED, .player = player_id, .turn = *turn});
+        push_event(session, (Event) {.type = EV_AWAIT_TURN, .player = player_id});
+        return false;
+    }
+    finish_turn(session, turn);
+    return true;
+}
+
+// resumes the session and moves up to max pending events into out. Stops early after a leg is scored so
+// a frontend can show the standings before the next leg starts
+int camels_poll_events(Session* session, Event* out, int max) {
+    Rng* saved      = camels_game_rng;
+    camels_game_rng = &session->rng;
+    // keep room for the three events a single step can queue
+    while (session->event_count + 3 <= SESSION_EVENTS && session->event_count < (size_t) max) {
+        SessionState before = session->state;
+        if (!step_session(session) || before == STATE_SCORE) {
+            break;
+        }
+    }
+    camels_game_rng = saved;
+
+    int n = 0;
+    while (n < max && session->event_count > 0) {
+        out[n++]            = session->events[session->event_head];
+        session->event_head = (session->event_head + 1) % SESSION_EVENTS;
+        session->event_count--;
+    }
+    return n;
+}
+
+bool session_over(Session* session) { return session->state == STATE_GAME_OVER && session->event_count == 0; }
+
+//////////////////////////////////// Forks //////////////////////////////////////
+// Copy-on-write Game for what-if analysis. A fork shares the board, the tickets, the players and the
+// wagers with its parent and only copies a part the first time it writes to it. The board is copied as
+// tile pointers: a forked board borrows every tile from its parent board (holding one reference to it)
+// until it writes that tile, so a fork plus one roll copies 17 pointers and the two tiles involved
+// instead of a whole Game. Reference counts are plain ints: a fork family belongs to one thread
+
+typedef struct {
+    int refs; // first member of every shared part
+} CowHeader;
+
+typedef struct SharedBoard {
+    int refs;
+    uint32_t owned;             // bit i: tiles[i] was copied by this board and is freed with it
+    struct SharedBoard* parent; // keeps the tiles this board borrows alive
+    Tile* tiles[BOARD_SIZE];
+} SharedBoard;
+
+typedef struct {
+    int refs;
+    TicketStack tickets[N_BETS_COLORS];
+} SharedTickets;
+
+typedef struct {
+    int refs;
+    Player players[N_PLAYERS];
+} SharedPlayers;
+
+typedef struct {
+    int refs;
+    WagerStack winner_bets;
+    WagerStack loser_bets;
+} SharedWagers;
+
+typedef struct {
+    bool winner;
+    uint16_t turn;
+    uint8_t round;
+    Dice dice;
+    SharedBoard* board;
+    SharedTickets* tickets;
+    SharedPlayers* players;
+    SharedWagers* wagers;
+} GameFork;
+
+// freed parts are kept on a per-size free list, forks churn through the same few sizes
+#define POOL_SIZE_CLASSES 8
+
+typedef struct {
+    size_t size;
+    void* head; // next pointer lives where the part's data was
+} PoolFreeList;
+
+_Thread_local PoolFreeList pool_free_lists[POOL_SIZE_CLASSES];
+
+PoolFreeList* pool_list(size_t size) {
+    for (int i = 0; i < POOL_SIZE_CLASSES; i++) {
+        if (pool_free_lists[i].size == size || pool_free_lists[i].size == 0) {
+            pool_free_lists[i].size = size;
+            return &pool_free_lists[i];
+        }
+    }
+    return NULL;
+}
+
+void* pool_alloc(size_t size) {
+    PoolFreeList* list = pool_list(size);
+    void* p;
+    if (list != NULL && list->head != NULL) {
+        p          = list->head;
+        list->head = *(void**) p;
+    } else {
+        p = malloc(size);
+    }
+    assert(p != NULL && "Out of memory");
+    return p;
+}
+
+void pool_free(void* p, size_t size) {
+    PoolFreeList* list = pool_list(size);
+    if (list == NULL) {
+        free(p);
+        return;
+    }
+    *(void**) p = list->head;
+    list->head  = p;
+}
+
+void* cow_new(const void* src, size_t size) {
+    CowHeader* part = pool_alloc(size);
+    memcpy(part, src, size);
+    part->refs = 1;
+    return part;
+}
+
+void* cow_share(void* part) {
+    ((CowHeader*) part)->refs++;
+    return part;
+}
+
+// the part itself if this fork is its only owner, otherwise a private copy
+void* cow_own(void* part, size_t size) {
+    CowHeader* header = part;
+    if (header->refs == 1) {
+        return part;
+    }
+    header->refs--;
+    return cow_new(part, size);
+}
+
+void cow_release(void* part, size_t size) {
+    if (--((CowHeader*) part)->refs == 0) {
+        pool_free(part, size);
+    }
+}
+
+void board_release(SharedBoard* board) {
+    while (board != NULL && --board->refs == 0) {
+        for (int i = 0; i < BOARD_SIZE; i++) {
+            if (board->owned & (1u << i)) {
+                pool_free(board->tiles[i], sizeof(Tile));
+            }
+        }
+        SharedBoard* parent = board->parent;
+        pool_free(board, sizeof(SharedBoard));
+        board = parent;
+    }
+}
+
+void fork_from_game(GameFork* fork, Game* game) {
+    fork->winner = game->winner;
+    fork->turn   = game->turn;
+    fork->round  = game->round;
+    fork->dice   = game->dice;
+
+    fork->board         = pool_alloc(sizeof(SharedBoard));
+    fork->board->refs   = 1;
+    fork->board->owned  = (1u << BOARD_SIZE) - 1;
+    fork->board->parent = NULL;
+    for (int i = 0; i < BOARD_SIZE; i++) {
+        fork->board->tiles[i]  = pool_alloc(sizeof(Tile));
+        *fork->board->tiles[i] = game->board[i];
+    }
+
+    SharedTickets tickets = {0};
+    memcpy(tickets.tickets, game->tickets, sizeof(tickets.tickets));
+    fork->tickets = cow_new(&tickets, sizeof(SharedTickets));
+
+    SharedPlayers players = {0};
+    memcpy(players.players, game->players, sizeof(players.players));
+    fork->players = cow_new(&players, sizeof(SharedPlayers));
+
+    SharedWagers wagers = {.winner_bets = game->winner_bets, .loser_bets = game->loser_bets};
+    fork->wagers        = cow_new(&wagers, sizeof(SharedWagers));
+}
+
+void fork_game(GameFork* parent, GameFork* child) {
+    *child = *parent;
+    child->board->refs++;
+    child->tickets = cow_share(parent->tickets);
+    child->players = cow_share(parent->players);
+    child->wagers  = cow_share(parent->wagers);
+}
+
+void fork_release(GameFork* fork) {
+    board_release(fork->board);
+    cow_release(fork->tickets, sizeof(SharedTickets));
+    cow_release(fork->players, sizeof(SharedPlayers));
+    cow_release(fork->wagers, sizeof(SharedWagers));
+}
+
+void fork_to_game(GameFork* fork, Game* game) {
+    game->winner = fork->winner;
+    game->turn   = fork->turn;
+    game->round  = fork->round;
+    game->dice   = fork->dice;
+    for (int i = 0; i < BOARD_SIZE; i++) {
+        game->board[i] = *fork->board->tiles[i];
+    }
+    memcpy(game->tickets, fork->tickets->tickets, sizeof(game->tickets));
+    memcpy(game->players, fork->players->players, sizeof(game->players));
+    game->winner_bets = fork->wagers->winner_bets;
+    game->loser_bets  = fork->wagers->loser_bets;
+}
+
+const Tile* fork_tile(GameFork* fork, int i) { return fork->board->tiles[i]; }
+
+// writable tile i, giving the fork its own board (borrowing from the shared one) and then its own tile
+Tile* fork_own_tile(GameFork* fork, int i) {
+    SharedBoard* board = fork->board;
+    if (board->refs > 1) {
+        SharedBoard* mine = pool_alloc(sizeof(SharedBoard));
+        memcpy(mine->tiles, board->tiles, sizeof(mine->tiles));
+        mine->refs   = 1;
+        mine->owned  = 0;
+        mine->parent = board; // takes over this fork's reference
+        fork->board  = board = mine;
+    }
+    if (!(board->owned & (1u << i))) {
+        Tile* tile      = pool_alloc(sizeof(Tile));
+        *tile           = *board->tiles[i];
+        board->tiles[i] = tile;
+        board->owned |= 1u << i;
+    }
+    return board->tiles[i];
+}
+
+Player* fork_own_players(GameFork* fork) {
+    fork->players = cow_own(fork->players, sizeof(SharedPlayers));
+    return fork->players->players;
+}
+
+TicketStack* fork_own_tickets(GameFork* fork) {
+    fork->tickets = cow_own(fork->tickets, sizeof(SharedTickets));
+    return fork->tickets->tickets;
+}
+
+SharedWagers* fork_own_wagers(GameFork* fork) {
+    fork->wagers = cow_own(fork->wagers, sizeof(SharedWagers));
+    return fork->wagers;
+}
+
+// move_camel on a fork, copying only the tiles it writes (and the players if a spectator pays out)
+void fork_move_camel(GameFork* fork, CamelColor color, int spaces) {
+    const Camel* camel = NULL;
+    for (int i = 0; i < BOARD_SIZE && camel == NULL; i++) {
+        const CamelStack* stack = &fork_tile(fork, i)->camel_stack;
+        for (size_t j = 0; j < stack_count(stack); j++) {
+            if (stack->items[j].color == color) {
+                camel = &stack->items[j];
+                break;
+            }
+        }
+    }
+    assert(camel != NULL && "Could not find your camel");
+    int curr_space               = camel->space;
+    Orientation move_orientation = camel->orientation;
+
+    int landing = curr_space + spaces;
+    if (landing >= 0 && landing < BOARD_SIZE - 1 && fork_tile(fork, landing)->has_spec) {
+        Spectator spec   = fork_tile(fork, landing)->spec;
+        move_orientation = spec.orientation;
+        fork_own_players(fork)[spec.player].points++;
+        spaces = spectator_spaces(spec, camel->orientation, spaces);
+    }
+    int dest = curr_space + spaces;
+    if (dest < 0)
+        dest = 0;
+    if (dest >= BOARD_SIZE - 1) {
+        fork->winner = true;
+        dest         = BOARD_SIZE - 1;
+    }
+
+    CamelStack* stack = &fork_own_tile(fork, curr_space)->camel_stack;
+    move_stack_block(stack, &fork_own_tile(fork, dest)->camel_stack, color, dest, move_orientation);
+}
+
+// what-if: the leg continues with this die
+void fork_roll(GameFork* fork, Roll die) {
+    stack_push(&fork->dice, die);
+    fork_move_camel(fork, die.color, die.value);
+}
+
+int fork_take_ticket(GameFork* fork, BetColor color, int player_id) {
+    return take_ticket(&fork_own_tickets(fork)[color], player_id);
+}
+
+bool fork_wager(GameFork* fork, int player_id, BetColor color, Orientation orientation) {
+    if (!has_card_in_hand(&fork->players->players[player_id], color)) {
+        return false;
+    }
+    remove_card_from_hand(&fork_own_players(fork)[player_id], color);
+    SharedWagers* wagers = fork_own_wagers(fork);
+    Wager w              = {.color = (uint8_t) color, .player = (uint8_t) player_id};
+    return stack_push(orientation == FORWARD ? &wagers->winner_bets : &wagers->loser_bets, w);
+}
+
+//////////////////////////////////// Leg Odds //////////////////////////////////////
+// Exact odds of every racing camel finishing the current leg first, second or last, by walking every
+// order and face of the dice left in the pyramid. The five racing camels only differ by label, so positions
+// that are relabelings of each other share one cache entry: the key names camels by where they stand
+// (rearmost lowest first) instead of by color, black and white the same way, and results are stored under
+// those canonical labels and mapped back to colors on the way out
+
+void leg_odds_walk(Game* game, double weight, LegOdds* odds) {
+    if (game->winner || game->dice.count == N_DICE) {
+        int first, second;
+        get_top_camels(game, &first, &second);
+        odds->first[first] += weight;
+        odds->second[second] += weight;
+        odds->last[get_last_camel(game)] += weight;
+        return;
+    }
+    DiceColor left[N_DICE + 1];
+    int n = remaining_dice(game, left);
+    for (int d = 0; d < n; d++) {
+        int faces = left[d] == DGREY ? 2 : 1; // black or white
+        for (int crazy = 0; crazy < faces; crazy++) {
+            for (int value = 1; value <= 3; value++) {
+                Game next = *game;
+                Roll die  = die_face(left[d], crazy, value);
+                stack_push(&next.dice, die);
+                move_camel(&next, (CamelColor) die.color, die.value);
+                leg_odds_walk(&next, weight / (n * faces * 3), odds);
+            }
+        }
+    }
+}
+
+void leg_odds(Game* game, LegOdds* odds) {
+    memset(odds, 0, sizeof(LegOdds));
+    leg_odds_walk(game, 1.0, odds);
+}
+
+// fills key and perm (color -> canonical label), with canonical false the labels are the colors
+void leg_key(Game* game, bool canonical, LegKey* key, uint8_t perm[N_BETS_COLORS]) {
+    memset(key, 0, sizeof(LegKey));
+    int racing = 0;
+    int crazy  = N_BETS_COLORS;
+    for (int b = 0; b < BOARD_SIZE; b++) {
+        CamelStack* stack = &game->board[b].camel_stack;
+        for (int j = 0; j < stack->count; j++) {
+            int color = stack->items[j].color;
+            int label;
+            if (!canonical) {
+                label = color;
+            } else if (color < N_BETS_COLORS) {
+                label = racing++;
+            } else {
+                label = crazy++;
+            }
+            if (color < N_BETS_COLORS) {
+                perm[color] = (uint8_t) label;
+            }
+            key->camels[label] = (uint8_t) (b * N_CAMELS + j);
+        }
+        if (game->board[b].has_spec) {
+            key->specs |= (game->board[b].spec.orientation == REVERSE ? 3u : 1u) << (2 * b);
+        }
+    }
+    for (int i = 0; i < game->dice.count; i++) {
+        int color = game->dice.items[i].color;
+        key->rolled |= (uint8_t) (1u << (color < N_BETS_COLORS ? perm[color] : N_BETS_COLORS));
+    }
+}
+
+bool leg_cache_init(LegCache* cache, int log2_entries, bool canonical) {
+    size_t n         = (size_t) 1 << log2_entries;
+    cache->entries   = huge_alloc(&cache->table, n * sizeof(LegCacheEntry)) ? cache->table.base : NULL;
+    cache->mask      = n - 1;
+    cache->canonical = canonical;
+    cache->hits      = 0;
+    cache->misses    = 0;
+    return cache->entries != NULL;
+}
+
+void leg_cache_free(LegCache* cache) {
+    huge_free(&cache->table);
+    cache->entries = NULL;
+}
+
+uint64_t leg_key_hash(const LegKey* key) {
+    uint64_t lo;
+    uint32_t hi;
+    memcpy(&lo, key, sizeof(lo));
+    memcpy(&hi, (const uint8_t*) key + sizeof(lo), sizeof(hi));
+    Rng mix = {.state = lo ^ ((uint64_t) hi << 29)};
+    return rng_next(&mix);
+}
+
+// leg_odds, memoized at every position of the walk: orders of the dice that meet in the same position
+// and positions that are relabelings of one already walked are looked up instead of walked again
+void cached_leg_odds(LegCache* cache, Game* game, LegOdds* odds) {
+    if (game->winner || game->dice.count == N_DICE) {
+        leg_odds(game, odds);
+        return;
+    }
+    LegKey key;
+    uint8_t perm[N_BETS_COLORS];
+    leg_key(game, cache->canonical, &key, perm);
+
+    LegCacheEntry* entry = &cache->entries[leg_key_hash(&key) & cache->mask];
+    if (entry->used && memcmp(&entry->key, &key, sizeof(LegKey)) == 0) {
+        cache->hits++;
+        for (int c = 0; c < N_BETS_COLORS; c++) {
+            odds->first[c]  = entry->odds.first[perm[c]];
+            odds->second[c] = entry->odds.second[perm[c]];
+            odds->last[c]   = entry->odds.last[perm[c]];
+        }
+        return;
+    }
+    cache->misses++;
+
+    memset(odds, 0, sizeof(LegOdds));
+    DiceColor left[N_DICE + 1];
+    int n = remaining_dice(game, left);
+    for (int d = 0; d < n; d++) {
+        int faces = left[d] == DGREY ? 2 : 1;
+        for (int crazy = 0; crazy < faces; crazy++) {
+            for (int value = 1; value <= 3; value++) {
+                Game next = *game;
+                Roll die  = die_face(left[d], crazy, value);
+                stack_push(&next.dice, die);
+                move_camel(&next, (CamelColor) die.color, die.value);
+                LegOdds child;
+                cached_leg_odds(cache, &next, &child);
+                double weight = 1.0 / (n * faces * 3);
+                for (int c = 0; c < N_BETS_COLORS; c++) {
+                    odds->first[c] += weight * child.first[c];
+                    odds->second[c] += weight * child.second[c];
+                    odds->last[c] += weight * child.last[c];
+                }
+            }
+        }
+    }
+
+    // the walk below may have reused the slot
+    entry->key  = key;
+    entry->used = true;
+    for (int c = 0; c < N_BETS_COLORS; c++) {
+        entry->odds.first[perm[c]]  = odds->first[c];
+        entry->odds.second[perm[c]] = odds->second[c];
+        entry->odds.last[perm[c]]   = odds->last[c];
+    }
+}
+
+bool camels_leg_tracker_init(LegTracker* tracker, int log2_entries) {
+    tracker->has_root  = false;
+    tracker->root_hits = 0;
+    return leg_cache_init(&tracker->cache, log2_entries, true);
+}
+
+void camels_leg_tracker_free(LegTracker* tracker) { leg_cache_free(&tracker->cache); }
+
+void camels_leg_tracker_odds(LegTracker* tracker, Game* game, LegOdds* odds) {
+    LegKey key;
+    uint8_t perm[N_BETS_COLORS];
+    leg_key(game, false, &key, perm);
+    bool over = game->winner || game->dice.count == N_DICE;
+    if (!over && tracker->has_root && memcmp(&key, &tracker->root, sizeof(LegKey)) == 0) {
+        tracker->root_hits++;
+        *odds = tracker->odds;
+        return;
+    }
+    cached_leg_odds(&tracker->cache, game, odds);
+    tracker->has_root = !over;
+    tracker->root     = key;
+    tracker->odds     = *odds;
+}
+
+//////////////////////////////////// Approximate Leg Odds //////////////////////////////////////
+// Sub-microsecond leg odds for UI hints. Each racing camel gets a distribution of tiles moved this leg from
+// its own die and the racing camels under it that can still carry it (carry_table). Camels are ranked as if
+// they moved independently, except two camels that share a stack: for those pair_table gives the chance one
+// ends ahead of the other given how far it moved, which keeps a carried camel on top of its carrier. Both
+// tables are solved once by walking an isolated stack. A camel that ends where it started keeps its height,
+// one that moved lands on top and other ties split evenly. Spectators shift the landing tile. Crazy camels only
+// matter through the chance the grey die carries a racing camel back off their tile
+
+#define CARRY_MAX   15               // own move plus four carriers
+#define APPROX_BINS (BOARD_SIZE * 8) // final tile * 8 + height, height 7 for camels that moved
+
+// [own die left][carriers left][dice left][tiles moved]
+float carry_table[2][N_BETS_COLORS][N_DICE + 2][CARRY_MAX + 1];
+int carry_reach[2][N_BETS_COLORS][N_DICE + 2]; // furthest move with a chance
+// [lower's die left][upper's die left][carriers left under lower][carriers left between][dice left]
+// [0: lower ahead given upper's move, 1: upper ahead given lower's move][tiles moved]
+float pair_table[2][2][N_BETS_COLORS - 1][N_BETS_COLORS - 1][N_DICE + 2][2][CARRY_MAX + 1];
+pthread_once_t approx_once = PTHREAD_ONCE_INIT;
+
+typedef struct {
+    int lower; // -1 when only the upper camel is followed
+    int upper;
+    double moved[2][CARRY_MAX + 1]; // [lower, upper][tiles]
+    double ahead[2][CARRY_MAX + 1]; // as pair_table, unnormalized
+} StackWalk;
+
+int camel_height(Game* game, int color) {
+    CamelStack* stack = &game->board[get_camel(game, (CamelColor) color)->space].camel_stack;
+    for (int j = 0; j < stack->count; j++) {
+        if (stack->items[j].color == color) {
+            return j;
+        }
+    }
+    return -1;
+}
+
+// every way the rest of the leg can move a lone stack starting on tile 0. mask holds the stack's dice still
+// in the pyramid, blanks counts the other dice left
+void stack_walk(Game* game, int mask, int blanks, int rolls, double weight, StackWalk* out) {
+    if (rolls == 0) {
+        int up = get_camel(game, (CamelColor) out->upper)->space;
+        out->moved[1][up] += weight;
+        if (out->lower >= 0) {
+            int low          = get_camel(game, (CamelColor) out->lower)->space;
+            bool lower_ahead = low > up || (low == up && camel_height(game, out->lower) > camel_height(game, out->upper));
+            out->moved[0][low] += weight;
+            out->ahead[0][up] += lower_ahead ? weight : 0.0;
+            out->ahead[1][low] += lower_ahead ? 0.0 : weight;
+        }
+        return;
+    }
+    int n = __builtin_popcount((unsigned) mask) + blanks;
+    if (blanks > 0) {
+        stack_walk(game, mask, blanks - 1, rolls - 1, weight * blanks / n, out);
+    }
+    for (int d = 0; d < N_BETS_COLORS; d++) {
+        if (mask & (1 << d)) {
+            for (int value = 1; value <= 3; value++) {
+                Game next = *game;
+                move_camel(&next, (CamelColor) d, value);
+                stack_walk(&next, mask & ~(1 << d), blanks, rolls - 1, weight / (3 * n), out);
+            }
+        }
+    }
+}
+
+// lone stack on tile 0 of colors 0..count-1 bottom to top
+void lone_stack(Game* game, int count) {
+    memset(game, 0, sizeof(Game));
+    for (int b = 0; b < BOARD_SIZE; b++) {
+        game->board[b].camel_stack.capacity = N_CAMELS;
+    }
+    for (int c = 0; c < count; c++) {
+        Camel camel = {.color = (uint8_t) c, .orientation = FORWARD, .space = 0};
+        stack_push(&game->board[0].camel_stack, camel);
+    }
+}
+
+void init_approx_tables(void) {
+    static Game game;
+    for (int n = 1; n <= N_DICE + 1; n++) {
+        for (int own = 0; own <= 1; own++) {
+            for (int k = 0; k < N_BETS_COLORS && k + own <= n; k++) {
+                // k carriers with their dice left and the camel on top
+                StackWalk walk = {.lower = -1, .upper = k};
+                lone_stack(&game, k + 1);
+                stack_walk(&game, ((1 << k) - 1) | (own << k), n - k - own, n - 1, 1.0, &walk);
+                for (int d = 0; d <= CARRY_MAX; d++) {
+                    carry_table[own][k][n][d] = (float) walk.moved[1][d];
+                    carry_reach[own][k][n]    = walk.moved[1][d] > 0.0 ? d : carry_reach[own][k][n];
+                }
+            }
+        }
+        for (int own_lo = 0; own_lo <= 1; own_lo++) {
+            for (int own_up = 0; own_up <= 1; own_up++) {
+                for (int below = 0; below < N_BETS_COLORS - 1; below++) {
+                    for (int between = 0; below + between < N_BETS_COLORS - 1; between++) {
+                        int dice = below + between + own_lo + own_up;
+                        if (dice > n) {
+                            continue;
+                        }
+                        // carriers, lower, the camels between, upper
+                        StackWalk walk = {.lower = below, .upper = below + between + 1};
+                        int mask       = ((1 << below) - 1) | (own_lo << below) |
+                                   (((1 << between) - 1) << (below + 1)) | (own_up << walk.upper);
+                        lone_stack(&game, walk.upper + 1);
+                        stack_walk(&game, mask, n - dice, n - 1, 1.0, &walk);
+                        for (int d = 0; d <= CARRY_MAX; d++) {
+                            for (int side = 0; side < 2; side++) {
+                                double moved = walk.moved[1 - side][d];
+                                pair_table[own_lo][own_up][below][between][n][side][d] =
+                                    moved > 0.0 ? (float) (walk.ahead[side][d] / moved) : 0.0f;
+                            }
+                        }
+                    }
+                }
+            }
+        }
+    }
+}
+
+typedef struct {
+    float w;
+    int16_t bin;
+    int16_t moved; // tiles moved before any crazy camel carried it back, indexes pair_table
+} ApproxOutcome;
+
+#define APPROX_OUTCOMES ((CARRY_MAX + 1) * 4) // each move can end with a crazy camel carrying it 1-3 back
+#define APPROX_LANES    8                     // racing camels padded to a vector width
+
+_Static_assert(N_BETS_COLORS == 5, "approx_leg_odds ranks each camel against exactly four others");
+
+void camels_approx_leg_odds(Game* game, LegOdds* odds) {
+    if (game->winner || game->dice.count == N_DICE) {
+        leg_odds(game, odds);
+        return;
+    }
+    pthread_once(&approx_once, init_approx_tables);
+
+    int unrolled   = (1 << N_BETS_COLORS) - 1;
+    bool grey_left = true;
+    for (int i = 0; i < game->dice.count; i++) {
+        int color = game->dice.items[i].color;
+        unrolled &= ~(1 << color);
+        grey_left &= color < N_BETS_COLORS;
+    }
+    int n = N_DICE + 1 - game->dice.count;
+
+    // land[t]: tile a camel moving onto t ends on. risk[t]: chance a camel ending on t rides a crazy camel back,
+    // which needs the grey die (still to come, after the camel lands half the time) to pick that crazy camel.
+    // One pass over the board also places the racing camels
+    float grey = grey_left ? (float) (n - 1) / (float) (4 * n) : 0.0f;
+    int land[BOARD_SIZE + CARRY_MAX];
+    float risk[BOARD_SIZE + CARRY_MAX] = {0};
+    // filled for crazy camels too, which keeps branches out of the board pass
+    int tile_of[N_CAMELS], height_of[N_CAMELS], carriers_of[N_CAMELS];
+    float risk_under[N_CAMELS]; // sitting on a crazy camel from the start
+    // mate[c][o]: pair_table row ranking stack mate o against c by c's move, NULL for camels on other tiles
+    const float* mate[N_BETS_COLORS][N_BETS_COLORS] = {{NULL}};
+    uint32_t occupied = 0;
+    for (int t = 0; t < BOARD_SIZE + CARRY_MAX; t++) {
+        land[t] = t >= BOARD_SIZE - 1 ? BOARD_SIZE - 1 : t;
+    }
+    for (int b = 0; b < BOARD_SIZE - 1; b++) {
+        Tile* tile = &game->board[b];
+        land[b] += tile->has_spec ? (tile->spec.orientation == FORWARD ? 1 : -1) : 0;
+        occupied |= (uint32_t) (tile->camel_stack.count != 0) << b;
+    }
+    occupied |= (uint32_t) (game->board[BOARD_SIZE - 1].camel_stack.count != 0) << (BOARD_SIZE - 1);
+    for (; occupied != 0; occupied &= occupied - 1) {
+        int b             = __builtin_ctz(occupied);
+        CamelStack* stack = &game->board[b].camel_stack;
+        int carriers = 0, n_racing = 0;
+        float under  = 0.0f;
+        int racing[N_BETS_COLORS];
+        for (int j = 0; j < stack->count; j++) {
+            int c          = stack->items[j].color;
+            bool crazy     = c >= N_BETS_COLORS;
+            int own_up     = (unrolled >> c) & 1; // 0 for crazy camels
+            tile_of[c]     = b;
+            height_of[c]   = j;
+            carriers_of[c] = carriers;
+            risk_under[c]  = under;
+            under += crazy ? 2.0f * grey : 0.0f;
+            risk[b] += crazy && b < BOARD_SIZE - 1 ? grey : 0.0f;
+            for (int k = 0; k < n_racing && !crazy; k++) {
+                int lower   = racing[k];
+                int own_lo  = (unrolled >> lower) & 1;
+                int between = carriers - carriers_of[lower] - own_lo;
+                mate[c][lower] = pair_table[own_lo][own_up][carriers_of[lower]][between][n][0];
+                mate[lower][c] = pair_table[own_lo][own_up][carriers_of[lower]][between][n][1];
+            }
+            racing[n_racing] = c;
+            n_racing += !crazy;
+            carriers += own_up;
+        }
+    }
+
+    // every way each camel can end the leg. Only a few of the tile * 8 + height bins are ever reached, so the
+    // reached ones are numbered densely afterwards
+    ApproxOutcome outcomes[N_BETS_COLORS][APPROX_OUTCOMES];
+    int n_outcomes[N_BETS_COLORS];
+    uint64_t reached[(APPROX_BINS + 63) / 64] = {0};
+    for (int c = 0; c < N_BETS_COLORS; c++) {
+        int b              = tile_of[c];
+        int own            = (unrolled >> c) & 1;
+        const float* dist  = carry_table[own][carriers_of[c]][n];
+        ApproxOutcome* out = outcomes[c];
+        for (int d = 0; d <= carry_reach[own][carriers_of[c]][n]; d++) {
+            int dest   = d == 0 ? b : land[b + d];
+            float back = d == 0 ? risk_under[c] : risk[dest];
+            int bin    = d == 0 ? b * 8 + height_of[c] : dest * 8 + 7;
+            *out++     = (ApproxOutcome) {.w = dist[d] * (1.0f - back), .bin = (int16_t) bin, .moved = (int16_t) d};
+            reached[bin / 64] |= 1ull << (bin % 64);
+            for (int v = 1; v <= 3 && back > 0.0f; v++) { // carried back, under whatever is there
+                bin    = (dest - v < 0 ? 0 : dest - v) * 8;
+                *out++ = (ApproxOutcome) {.w = dist[d] * back / 3.0f, .bin = (int16_t) bin, .moved = (int16_t) d};
+                reached[bin / 64] |= 1ull << (bin % 64);
+            }
+        }
+        n_outcomes[c] = (int) (out - outcomes[c]);
+    }
+    uint8_t dense[APPROX_BINS];
+    int n_bins = 0;
+    for (int w = 0; w < (APPROX_BINS + 63) / 64; w++) {
+        for (uint64_t m = reached[w]; m != 0; m &= m - 1) {
+            dense[w * 64 + __builtin_ctzll(m)] = (uint8_t) n_bins++;
+        }
+    }
+
+    // behind[bin][c]: chance c ends behind that bin, counting half of a tie
+    float p[APPROX_BINS][APPROX_LANES], behind[APPROX_BINS][APPROX_LANES];
+    memset(p, 0, (size_t) n_bins * sizeof(p[0]));
+    for (int c = 0; c < N_BETS_COLORS; c++) {
+        for (int i = 0; i < n_outcomes[c]; i++) {
+            outcomes[c][i].bin = dense[outcomes[c][i].bin];
+            p[outcomes[c][i].bin][c] += outcomes[c][i].w;
+        }
+    }
+    float sum[APPROX_LANES] = {0};
+    for (int bin = 0; bin < n_bins; bin++) {
+        for (int c = 0; c < APPROX_LANES; c++) {
+            behind[bin][c] = sum[c] + 0.5f * p[bin][c];
+            sum[c] += p[bin][c];
+        }
+    }
+
+    // each camel against the other four: g is the chance the other camel ends behind, read from behind[bin] for
+    // camels on other tiles and as 1 - mate row[moved] for stack mates. Camels without stack mates, most of
+    // them, skip the mate rows altogether
+    float total[3] = {0};
+    float result[3][N_BETS_COLORS];
+    for (int c = 0; c < N_BETS_COLORS; c++) {
+        int others[N_BETS_COLORS - 1];
+        bool has_mate = false;
+        for (int o = 0, k = 0; o < N_BETS_COLORS; o++) {
+            if (o != c) {
+                others[k++] = o;
+                has_mate |= mate[c][o] != NULL;
+            }
+        }
+        const float* row[N_BETS_COLORS - 1];
+        for (int k = 0; k < N_BETS_COLORS - 1; k++) {
+            row[k] = mate[c][others[k]];
+        }
+
+        float first = 0.0f, second = 0.0f, last = 0.0f;
+        for (int i = 0; i < n_outcomes[c]; i++) {
+            ApproxOutcome out = outcomes[c][i];
+            const float* at   = behind[out.bin];
+            float g0 = at[others[0]], g1 = at[others[1]], g2 = at[others[2]], g3 = at[others[3]];
+            if (has_mate) {
+                g0 = row[0] != NULL ? 1.0f - row[0][out.moved] : g0;
+                g1 = row[1] != NULL ? 1.0f - row[1][out.moved] : g1;
+                g2 = row[2] != NULL ? 1.0f - row[2][out.moved] : g2;
+                g3 = row[3] != NULL ? 1.0f - row[3][out.moved] : g3;
+            }
+            // combined two camels at a time to keep the dependency chains short
+            float behind01 = g0 * g1, behind23 = g2 * g3;
+            float ahead01 = (1.0f - g0) * (1.0f - g1), ahead23 = (1.0f - g2) * (1.0f - g3);
+            float one01 = g0 + g1 - 2.0f * behind01, one23 = g2 + g3 - 2.0f * behind23;
+            first += out.w * behind01 * behind23;
+            second += out.w * (one01 * behind23 + behind01 * one23);
+            last += out.w * ahead01 * ahead23;
+        }
+        result[0][c] = first;
+        result[1][c] = second;
+        result[2][c] = last;
+        total[0] += first;
+        total[1] += second;
+        total[2] += last;
+    }
+    for (int c = 0; c < N_BETS_COLORS; c++) {
+        odds->first[c]  = result[0][c] / total[0];
+        odds->second[c] = result[1][c] / total[1];
+        odds->last[c]   = result[2][c] / total[2];
+    }
+}
+
+//////////////////////////////////// Sweeps //////////////////////////////////////
+// Playouts of one position over a range of samples, counted into a histogram. Sample i always plays from its
+// own stream seeded by (seed, i) and histograms are plain counts, so ranges can be played anywhere and merged
+// in any order: the frontend's distributed sweeps hand them to worker processes
+
+// plays samples [begin, begin + count) of job into hist
+void camels_sweep_range(const SweepJob* job, uint64_t begin, uint64_t count, SweepHistogram* hist) {
+    static _Thread_local Game game;
+    Policy pool[2]     = {camels_bot_random, camels_bot_greedy};
+    bool saved_log     = camels_log_enabled;
+    camels_log_enabled = false;
+    for (uint64_t i = begin; i < begin + count; i++) {
+        Rng rng = {.state = job->seed ^ (i * 0xD1B54A32D192ED03ULL)};
+        rng_next(&rng);
+        if (job->mode == SWEEP_GAMES) {
+            Policy seats[N_PLAYERS];
+            for (int p = 0; p < N_PLAYERS; p++) {
+                seats[p] = pool[rng_range(&rng, 0, 1)];
+            }
+            memset(&game, 0, sizeof(Game));
+            camels_game_rng = &rng;
+            camels_init_game(&game);
+            camels_game_rng = NULL;
+            camels_play_bot_game(&game, seats, &rng, NULL);
+            int best = 0;
+            for (int p = 1; p < N_PLAYERS; p++) {
+                best = game.players[p].points > game.players[best].points ? p : best;
+            }
+            hist->seat[best]++;
+        } else {
+            game = job->position;
+            play_out_race(&game, &rng);
+        }
+        int first, second;
+        get_top_camels(&game, &first, &second);
+        hist->first[first]++;
+        hist->last[get_last_camel(&game)]++;
+        hist->samples++;
+    }
+    camels_log_enabled = saved_log;
+}
+
+void camels_sweep_merge(SweepHistogram* into, const SweepHistogram* from) {
+    into->samples += from->samples;
+    for (int c = 0; c < N_BETS_COLORS; c++) {
+        into->first[c] += from->first[c];
+        into->last[c] += from->last[c];
+    }
+    for (int p = 0; p < N_PLAYERS; p++) {
+        into->seat[p] += from->seat[p];
+    }
+}
+
+//////////////////////////////////// Pondering //////////////////////////////////////
+// Analysis of the position in front of a human while they think. One long-lived thread per Ponder sleeps
+// until camels_ponder_start, then works from cheap to dear: approximate leg odds, exact leg odds with ticket
+// EVs, then wager values and a hint. Each result is published as it lands and handed to the redraw callback
+// when one is set. camels_ponder_stop only bumps the generation, so input never waits on analysis: stale work
+// is dropped at the next phase boundary. Redraws hold the draw lock, which camels_ponder_stop takes too, so
+// once it returns no stale redraw is running or left to come
+
+double ticket_ev(int amount, double p_first, double p_second) {
+    return amount * p_first + p_second - (1.0 - p_first - p_second);
+}
+
+// ticket EVs and, once wager values are in, the hint
+void camels_ponder_moves(Game* game, PonderResult* r) {
+    r->hint    = (Turn) {.turn_type = ROLL};
+    r->hint_ev = 1.0; // a roll pays its pyramid ticket
+    for (int c = 0; c < N_BETS_COLORS; c++) {
+        Ticket* t        = top_ticket(&game->tickets[c]);
+        r->has_ticket[c] = t != NULL;
+        r->ticket_ev[c]  = t != NULL ? ticket_ev(t->amount, r->odds.first[c], r->odds.second[c]) : 0.0;
+        if (t != NULL && r->ticket_ev[c] > r->hint_ev) {
+            r->hint    = (Turn) {.turn_type = TICKET, .color = (BetColor) c};
+            r->hint_ev = r->ticket_ev[c];
+        }
+        if (r->depth == PONDER_DONE && r->wagers[c].available) {
+            double win = r->wagers[c].winner_now, lose = r->wagers[c].loser_now;
+            if (win > r->hint_ev || lose > r->hint_ev) {
+                r->hint    = (Turn) {.turn_type   = WAGER,
+                                     .orientation = win >= lose ? FORWARD : REVERSE,
+                                     .color       = (BetColor) c};
+                r->hint_ev = win >= lose ? win : lose;
+            }
+        }
+    }
+}
+
+// stores r if gen is still current and redraws. False once the position is stale
+bool ponder_publish(Ponder* p, uint64_t gen, const PonderResult* r, Game* game) {
+    pthread_mutex_lock(&p->lock);
+    bool current = p->generation == gen;
+    if (current) {
+        p->result = *r;
+    }
+    pthread_mutex_unlock(&p->lock);
+    if (current && p->redraw != NULL) {
+        pthread_mutex_lock(&p->draw);
+        pthread_mutex_lock(&p->lock);
+        current = p->generation == gen;
+        pthread_mutex_unlock(&p->lock);
+        if (current) {
+            p->redraw(p->ctx, game);
+        }
+        pthread_mutex_unlock(&p->draw);
+    }
+    return current;
+}
+
+void* ponder_main(void* arg) {
+    Ponder* p = arg;
+    static _Thread_local Game game;
+    pthread_mutex_lock(&p->lock);
+    while (!p->quit) {
+        if (!p->pending) {
+            pthread_cond_wait(&p->wake, &p->lock);
+            continue;
+        }
+        uint64_t gen   = p->generation;
+        double budget  = p->wager_ms;
+        game           = p->game;
+        PonderResult r = {.turn = game.turn, .round = game.round, .player_id = p->player_id};
+        pthread_mutex_unlock(&p->lock);
+
+        r.depth = PONDER_APPROX;
+        camels_approx_leg_odds(&game, &r.odds);
+        camels_ponder_moves(&game, &r);
+        bool current = ponder_publish(p, gen, &r, &game);
+        if (current) {
+            r.depth = PONDER_EXACT;
+            camels_leg_tracker_odds(&p->legs, &game, &r.odds);
+            camels_ponder_moves(&game, &r);
+            current = ponder_publish(p, gen, &r, &game);
+        }
+        if (current) {
+            r.depth = PONDER_DONE;
+            value_wagers(&game, r.player_id, &p->rng, budget, r.wagers);
+            camels_ponder_moves(&game, &r);
+            ponder_publish(p, gen, &r, &game);
+        }
+
+        pthread_mutex_lock(&p->lock);
+        p->pending = p->generation == gen ? false : p->pending;
+    }
+    pthread_mutex_unlock(&p->lock);
+    return NULL;
+}
+
+// starts the pondering thread. redraw, when set, is called from it with every new result
+bool camels_ponder_init(Ponder* p, void (*redraw)(void* ctx, Game* game), void* ctx) {
+    memset(p, 0, sizeof(*p));
+    p->redraw    = redraw;
+    p->ctx       = ctx;
+    p->wager_ms  = PONDER_WAGER_MS;
+    p->rng.state = (uint64_t) time(NULL);
+    if (!camels_leg_tracker_init(&p->legs, 16)) {
+        return false;
+    }
+    pthread_mutex_init(&p->lock, NULL);
+    pthread_mutex_init(&p->draw, NULL);
+    pthread_cond_init(&p->wake, NULL);
+    if (pthread_create(&p->thread, NULL, ponder_main, p) != 0) {
+        camels_leg_tracker_free(&p->legs);
+        return false;
+    }
+    return true;
+}
+
+void camels_ponder_free(Ponder* p) {
+    pthread_mutex_lock(&p->lock);
+    p->quit = true;
+    p->generation++;
+    pthread_cond_signal(&p->wake);
+    pthread_mutex_unlock(&p->lock);
+    pthread_join(p->thread, NULL);
+    pthread_cond_destroy(&p->wake);
+    pthread_mutex_destroy(&p->draw);
+    pthread_mutex_destroy(&p->lock);
+    camels_leg_tracker_free(&p->legs);
+}
+
+// analyse game for player_id from now on, the game is copied
+void camels_ponder_start(Ponder* p, Game* game, int player_id) {
+    pthread_mutex_lock(&p->lock);
+    p->generation++;
+    p->game         = *game;
+    p->player_id    = player_id;
+    p->pending      = true;
+    p->result.depth = PONDER_NONE;
+    pthread_cond_signal(&p->wake);
+    pthread_mutex_unlock(&p->lock);
+}
+
+// drops the current analysis, the thread stays for the next camels_ponder_start
+void camels_ponder_stop(Ponder* p) {
+    pthread_mutex_lock(&p->draw);
+    pthread_mutex_lock(&p->lock);
+    p->generation++;
+    p->pending      = false;
+    p->result.depth = PONDER_NONE;
+    pthread_mutex_unlock(&p->lock);
+    pthread_mutex_unlock(&p->draw);
+}
+
+// copy of the latest result, false while there is none
+bool camels_ponder_result(Ponder* p, PonderResult* out) {
+    pthread_mutex_lock(&p->lock);
+    *out = p->result;
+    pthread_mutex_unlock(&p->lock);
+    return out->depth != PONDER_NONE;
+}
+
+//////////////////////////////////// Batch Evaluation //////////////////////////////////////
+// Leg odds and ticket EVs for many positions per call, for a backend that holds one position per live
+// table. Positions come in and results go out as structure-of-arrays: one array per field with a row per
+// position, so a batch is a handful of flat allocations and the per-row passes (decoding, ticket EVs) are
+// straight loops the compiler can vectorize. Rows are handed out in chunks to a persistent pool; the
+// calling thread works alongside it and every thread keeps its own leg cache between batches
+
+#define BATCH_CHUNK 16 // rows claimed at a time
+
+typedef struct {
+    int count;
+    int capacity;
+    int8_t* space[N_CAMELS];        // tile of each camel by CamelColor
+    uint8_t* height[N_CAMELS];      // 0 at the bottom of its stack
+    uint8_t* rolled;                // bit per DiceColor already out of the pyramid
+    uint32_t* specs;                // two bits per tile as in LegKey: has spec, spec is REVERSE
+    uint8_t* ticket[N_BETS_COLORS]; // top ticket left of each color, 0 when none
+} PositionBatch;
+
+typedef struct {
+    float* first[N_BETS_COLORS];
+    float* second[N_BETS_COLORS];
+    float* last[N_BETS_COLORS];
+    float* ticket_ev[N_BETS_COLORS]; // 0 where no ticket is left
+} BatchOdds;
+
+typedef struct {
+    pthread_t* threads;
+    int n_threads; // helpers, the caller makes one more
+    pthread_mutex_t lock;
+    pthread_cond_t work;
+    pthread_cond_t done;
+    uint64_t generation;
+    bool quit;
+    int busy; // helpers still on the current batch
+    const PositionBatch* in;
+    BatchOdds* out;
+    bool exact;          // camels_approx_leg_odds when false
+    atomic_int next_row;
+    LegCache* caches; // one per thread, the caller's first
+    int n_caches;
+} EvalPool;
+
+typedef struct {
+    EvalPool* pool;
+    int index;
+} EvalPoolThread;
+
+// one block for every column, capacity rows
+bool position_batch_alloc(PositionBatch* batch, int capacity) {
+    size_t n      = (size_t) capacity;
+    size_t bytes  = N_CAMELS * 2 * n + n + n * sizeof(uint32_t) + N_BETS_COLORS * n;
+    uint8_t* base = malloc(bytes);
+    memset(batch, 0, sizeof(*batch));
+    if (base == NULL) {
+        return false;
+    }
+    batch->capacity = capacity;
+    batch->specs    = (uint32_t*) base; // first, keeps it aligned
+    uint8_t* p      = base + n * sizeof(uint32_t);
+    for (int c = 0; c < N_CAMELS; c++) {
+        batch->space[c]  = (int8_t*) p;
+        batch->height[c] = p + n;
+        p += 2 * n;
+    }
+    batch->rolled = p;
+    p += n;
+    for (int c = 0; c < N_BETS_COLORS; c++) {
+        batch->ticket[c] = p;
+        p += n;
+    }
+    return true;
+}
+
+void position_batch_free(PositionBatch* batch) { free(batch->specs); }
+
+bool batch_odds_alloc(BatchOdds* odds, int capacity) {
+    float* base = calloc((size_t) capacity * 4 * N_BETS_COLORS, sizeof(float));
+    if (base == NULL) {
+        return false;
+    }
+    for (int c = 0; c < N_BETS_COLORS; c++) {
+        odds->first[c]     = base + (size_t) capacity * (size_t) (0 * N_BETS_COLORS + c);
+        odds->second[c]    = base + (size_t) capacity * (size_t) (1 * N_BETS_COLORS + c);
+        odds->last[c]      = base + (size_t) capacity * (size_t) (2 * N_BETS_COLORS + c);
+        odds->ticket_ev[c] = base + (size_t) capacity * (size_t) (3 * N_BETS_COLORS + c);
+    }
+    return true;
+}
+
+void batch_odds_free(BatchOdds* odds) { free(odds->first[0]); }
+
+// appends the race state of game, false when the batch is full
+bool position_batch_push(PositionBatch* batch, Game* game) {
+    if (batch->count == batch->capacity) {
+        return false;
+    }
+    int i           = batch->count++;
+    batch->specs[i] = 0;
+    for (int b = 0; b < BOARD_SIZE; b++) {
+        CamelStack* stack = &game->board[b].camel_stack;
+        for (int j = 0; j < stack->count; j++) {
+            batch->space[stack->items[j].color][i]  = (int8_t) b;
+            batch->height[stack->items[j].color][i] = (uint8_t) j;
+        }
+        if (game->board[b].has_spec) {
+            batch->specs[i] |= (game->board[b].spec.orientation == REVERSE ? 3u : 1u) << (2 * b);
+        }
+    }
+    batch->rolled[i] = 0;
+    for (int d = 0; d < game->dice.count; d++) {
+        int color = game->dice.items[d].color;
+        batch->rolled[i] |= (uint8_t) (1u << (color < N_BETS_COLORS ? color : DGREY));
+    }
+    for (int c = 0; c < N_BETS_COLORS; c++) {
+        Ticket* t           = top_ticket(&game->tickets[c]);
+        batch->ticket[c][i] = t != NULL ? (uint8_t) t->amount : 0;
+    }
+    return true;
+}
+
+// rebuilds row i as a Game with only the race filled in: camels, dice out of the pyramid and spectators
+void position_batch_game(const PositionBatch* batch, int i, Game* game) {
+    memset(game, 0, sizeof(Game));
+    reset_dice(game);
+    int8_t at[BOARD_SIZE][N_CAMELS];
+    memset(at, -1, sizeof(at));
+    for (int c = 0; c < N_CAMELS; c++) {
+        at[batch->space[c][i]][batch->height[c][i]] = (int8_t) c;
+    }
+    for (int b = 0; b < BOARD_SIZE; b++) {
+        CamelStack* stack = &game->board[b].camel_stack;
+        stack->capacity   = N_CAMELS;
+        for (int h = 0; h < N_CAMELS && at[b][h] >= 0; h++) {
+            bool crazy  = at[b][h] >= N_BETS_COLORS;
+            Camel camel = {.color = (uint8_t) at[b][h], .orientation = crazy ? REVERSE : FORWARD, .space = (int8_t) b};
+            stack_push(stack, camel);
+            game->winner |= !crazy && b == BOARD_SIZE - 1;
+        }
+        uint32_t spec = (batch->specs[i] >> (2 * b)) & 3u;
+        if (spec != 0) {
+            game->board[b].has_spec         = true;
+            game->board[b].spec.orientation = spec == 3u ? REVERSE : FORWARD;
+        }
+    }
+    for (int d = 0; d <= DGREY; d++) {
+        if (batch->rolled[i] & (1u << d)) {
+            Roll roll = {.color = (uint8_t) (d == DGREY ? CBLACK : d), .value = 1}; // only which dice are out matters
+            stack_push(&game->dice, roll);
+        }
+    }
+}
+
+// leg odds for rows [begin, end)
+void eval_rows(const PositionBatch* in, BatchOdds* out, bool exact, LegCache* cache, int begin, int end) {
+    static _Thread_local Game game;
+    for (int i = begin; i < end; i++) {
+        LegOdds odds;
+        position_batch_game(in, i, &game);
+        if (exact) {
+            cached_leg_odds(cache, &game, &odds);
+        } else {
+            camels_approx_leg_odds(&game, &odds);
+        }
+        for (int c = 0; c < N_BETS_COLORS; c++) {
+            out->first[c][i]  = (float) odds.first[c];
+            out->second[c][i] = (float) odds.second[c];
+            out->last[c][i]   = (float) odds.last[c];
+        }
+    }
+}
+
+// claims chunks of the current batch until none are left
+void eval_pool_drain(EvalPool* pool, int index) {
+    int n = pool->in->count;
+    int begin;
+    while ((begin = atomic_fetch_add(&pool->next_row, BATCH_CHUNK)) < n) {
+        int end = begin + BATCH_CHUNK < n ? begin + BATCH_CHUNK : n;
+        eval_rows(pool->in, pool->out, pool->exact, &pool->caches[index], begin, end);
+    }
+}
+
+void* eval_pool_main(void* arg) {
+    EvalPoolThread* self = arg;
+    EvalPool* pool       = self->pool;
+    uint64_t seen        = 0;
+    placement_enter(self->index);
+    pthread_mutex_lock(&pool->lock);
+    while (true) {
+        while (!pool->quit && pool->generation == seen) {
+            pthread_cond_wait(&pool->work, &pool->lock);
+        }
+        if (pool->quit) {
+            break;
+        }
+        seen = pool->generation;
+        pthread_mutex_unlock(&pool->lock);
+        eval_pool_drain(pool, self->index);
+        pthread_mutex_lock(&pool->lock);
+        if (--pool->busy == 0) {
+            pthread_cond_signal(&pool->done);
+        }
+    }
+    pthread_mutex_unlock(&pool->lock);
+    free(self);
+    return NULL;
+}
+
+// threads in all, the caller of eval_pool_run counts as one. 0 for one per online core
+bool eval_pool_init(EvalPool* pool, int threads) {
+    threads = threads > 0 ? threads : (int) sysconf(_SC_NPROCESSORS_ONLN);
+    threads = threads > 0 ? threads : 1;
+    memset(pool, 0, sizeof(*pool));
+    pool->caches  = calloc((size_t) threads, sizeof(LegCache));
+    pool->threads = calloc((size_t) threads, sizeof(pthread_t));
+    if (pool->caches == NULL || pool->threads == NULL) {
+        free(pool->caches);
+        free(pool->threads);
+        return false;
+    }
+    for (int t = 0; t < threads; t++) {
+        if (!leg_cache_init(&pool->caches[t], 16, true)) {
+            while (--t >= 0) {
+                leg_cache_free(&pool->caches[t]);
+            }
+            free(pool->caches);
+            free(pool->threads);
+            return false;
+        }
+    }
+    pool->n_caches = threads;
+    pthread_mutex_init(&pool->lock, NULL);
+    pthread_cond_init(&pool->work, NULL);
+    pthread_cond_init(&pool->done, NULL);
+    for (int t = 0; t < threads - 1; t++) {
+        EvalPoolThread* self = malloc(sizeof(EvalPoolThread));
+        assert(self != NULL && "Out of memory");
+        *self = (EvalPoolThread) {.pool = pool, .index = t + 1};
+        if (pthread_create(&pool->threads[t], NULL, eval_pool_main, self) != 0) {
+            free(self);
+            break;
+        }
+        pool->n_threads++;
+    }
+    return true;
+}
+
+void eval_pool_free(EvalPool* pool) {
+    pthread_mutex_lock(&pool->lock);
+    pool->quit = true;
+    pthread_cond_broadcast(&pool->work);
+    pthread_mutex_unlock(&pool->lock);
+    for (int t = 0; t < pool->n_threads; t++) {
+        pthread_join(pool->threads[t], NULL);
+    }
+    for (int t = 0; t < pool->n_caches; t++) {
+        leg_cache_free(&pool->caches[t]);
+    }
+    pthread_cond_destroy(&pool->work);
+    pthread_cond_destroy(&pool->done);
+    pthread_mutex_destroy(&pool->lock);
+    free(pool->caches);
+    free(pool->threads);
+}
+
+// leg odds and ticket EVs of every row of in, exact or approximate. Returns the latency of the batch in ns
+uint64_t eval_pool_run(EvalPool* pool, const PositionBatch* in, BatchOdds* out, bool exact) {
+    uint64_t start = now_ns();
+    if (in->count <= BATCH_CHUNK || pool->n_threads == 0) {
+        eval_rows(in, out, exact, &pool->caches[0], 0, in->count); // waking helpers would cost more
+    } else {
+        pthread_mutex_lock(&pool->lock);
+        pool->in    = in;
+        pool->out   = out;
+        pool->exact = exact;
+        atomic_store(&pool->next_row, 0);
+        pool->busy = pool->n_threads;
+        pool->generation++;
+        pthread_cond_broadcast(&pool->work);
+        pthread_mutex_unlock(&pool->lock);
+
+        eval_pool_drain(pool, 0);
+        pthread_mutex_lock(&pool->lock);
+        while (pool->busy > 0) {
+            pthread_cond_wait(&pool->done, &pool->lock);
+        }
+        pthread_mutex_unlock(&pool->lock);
+    }
+
+    // a top ticket of a pays a on first, 1 on second and -1 otherwise
+    for (int c = 0; c < N_BETS_COLORS; c++) {
+        const uint8_t* amount = in->ticket[c];
+        const float* first    = out->first[c];
+        const float* second   = out->second[c];
+        float* ev             = out->ticket_ev[c];
+        for (int i = 0; i < in->count; i++) {
+            float a = (float) amount[i];
+            ev[i]   = a > 0.0f ? a * first[i] + second[i] - (1.0f - first[i] - second[i]) : 0.0f;
+        }
+    }
+    return now_ns() - start;
+}
+
+//////////////////////////////////// Expectimax Search //////////////////////////////////////
+// Exact play over a short horizon. Decision nodes are the seat to move picking one of its turns, chance nodes
+// the pyramid's roll: each die left, then each face, equally likely. Depth counts decisions only and the
+// horizon is the end of the leg, which is scored on the spot; other leaves are valued by search_equity.
+// Max-n backs up every seat's equity and each seat maximizes its own. Paranoid has every opponent minimize
+// the root seat's margin over the average opponent. That value is zero-sum, so decision nodes use alpha-beta
+// and chance nodes Star1 (each child searched in the window its siblings' bounds leave open) and Star2 (a
+// probe of each child's first move before that). Both need bounded leaves, so paranoid leaves are clamped to
+// SEARCH_BOUND around the root's margin. Max-n values have no constant sum and nothing is pruned there.
+// Moves are tried best first: the table's move, then by what each is worth on the spot. Iterative deepening
+// runs until the budget is spent and drops an iteration cut short; it stops early once an iteration reached
+// the end of the leg everywhere. The table lives for one search: the next iteration takes its move order
+// from it and rolls met again in another order are looked up
+
+#define SEARCH_MAX_DEPTH    32
+#define SEARCH_BOUND        20.0 // paranoid leaves are clamped to the root's margin +- this
+#define SEARCH_TT_LOG2      16
+#define SEARCH_CHECK_NODES  1024 // nodes between clock reads
+#define SEARCH_MAX_OUTCOMES (3 * N_BETS_COLORS + 6)
+#define SEARCH_NO_MOVE      0xFF
+
+typedef struct {
+    Roll die;
+    double p;
+} Outcome;
+
+_Thread_local Searcher* camels_searcher = NULL; // camels_bot_expectimax searches with it, rolls while unset
+
+bool camels_searcher_init(Searcher* s, SearchConfig config) {
+    memset(s, 0, sizeof(*s));
+    s->config = config;
+    size_t n  = (size_t) 1 << SEARCH_TT_LOG2;
+    s->table  = huge_alloc(&s->region, n * sizeof(SearchEntry)) ? s->region.base : NULL;
+    s->mask   = n - 1;
+    return s->table != NULL;
+}
+
+void camels_searcher_free(Searcher* s) {
+    huge_free(&s->region);
+    s->table = NULL;
+}
+
+// approximate leg odds of game. Most leaves differ from the last one only in tickets and wagers, so the
+// odds are kept while the camels, the dice left and the spectator tiles stay the same
+const LegOdds* search_odds(Searcher* s, Game* game) {
+    uint64_t rank  = race_rank(game, true);
+    uint32_t specs = 0;
+    for (int b = 0; b < BOARD_SIZE - 1; b++) {
+        if (game->board[b].has_spec) {
+            specs |= (game->board[b].spec.orientation == REVERSE ? 3u : 1u) << (2 * b);
+        }
+    }
+    if (!s->has_odds || rank != s->odds_rank || specs != s->odds_specs) {
+        camels_approx_leg_odds(game, &s->odds);
+        s->has_odds   = true;
+        s->odds_rank  = rank;
+        s->odds_specs = specs;
+    }
+    return &s->odds;
+}
+
+// each seat's position in points: its points, the tickets it holds under the leg odds and its wagers under a
+// race proxy that moves from even odds to the leg's as the leader nears the finish. odds is unused once the
+// race is over
+void search_equity(Game* game, const LegOdds* odds, double equity[N_PLAYERS]) {
+    for (int p = 0; p < N_PLAYERS; p++) {
+        equity[p] = game->players[p].points;
+    }
+    if (game->winner) {
+        return; // scored
+    }
+    for (int c = 0; c < N_BETS_COLORS; c++) {
+        for (int j = 0; j < game->tickets[c].top; j++) {
+            Ticket t = game->tickets[c].items[j];
+            equity[t.player_id] += ticket_ev(t.amount, odds->first[c], odds->second[c]);
+        }
+    }
+    double rate             = opponent_wager_rate(game);
+    WagerStack* bets[2]     = {&game->winner_bets, &game->loser_bets};
+    const double* chance[2] = {odds->first, odds->last};
+    for (int k = 0; k < 2; k++) {
+        int ahead[N_BETS_COLORS] = {0};
+        for (int i = 0; i < bets[k]->count; i++) {
+            Wager w  = bets[k]->items[i];
+            double q = rate * chance[k][w.color] + (1.0 - rate) / N_BETS_COLORS;
+            equity[w.player] += q * wager_payout(ahead[w.color]++) - (1.0 - q);
+        }
+    }
+}
+
+// the table's key: rolled dice count as a set, two rolls in either order meet in one entry
+uint64_t search_key(const Game* game, int player) {
+    uint64_t words[(sizeof(Game) + 7) / 8] = {0};
+    memcpy(words, game, sizeof(Game));
+    memset((uint8_t*) words + offsetof(Game, dice.items), 0, sizeof(game->dice.items));
+    uint64_t h = (uint64_t) player << 8 | (uint64_t) race_dice_left(game);
+    for (size_t i = 0; i < sizeof(words) / sizeof(words[0]); i++) {
+        h = (h ^ words[i]) * 0x100000001B3ULL;
+        h ^= h >> 29;
+    }
+    Rng mix = {.state = h};
+    return rng_next(&mix);
+}
+
+// a turn other than a roll, apply_turn without its log. False when it is not allowed
+bool search_turn(Game* game, const Turn* turn, int player) {
+    bool ok = false;
+    switch (turn->turn_type) {
+        case WAGER: {
+            Wager w = {.color = (uint8_t) turn->color, .player = (uint8_t) player};
+            ok      = remove_card_from_hand(&game->players[player], turn->color) &&
+                 stack_push(turn->orientation == FORWARD ? &game->winner_bets : &game->loser_bets, w);
+            break;
+        }
+        case TICKET:
+            ok = assign_ticket(game, turn->color, player) != -1;
+            break;
+        case SPECTATOR: {
+            Spectator spec = {.orientation = (uint8_t) turn->orientation, .player = (uint8_t) player};
+            ok             = place_spec_tile(game, player, turn->position, spec);
+            break;
+        }
+        case ROLL:
+        default:
+            break;
+    }
+    game->turn++;
+    return ok;
+}
+
+// player rolls die. True when that ends the leg, which is then scored and, unless the race is over, set up again
+bool search_roll(Game* game, Roll die, int player) {
+    stack_push(&game->dice, die);
+    move_camel(game, (CamelColor) die.color, die.value);
+    game->players[player].points++;
+    game->turn++;
+    if (!game->winner && game->dice.count != N_DICE) {
+        return false;
+    }
+    int first, second;
+    score_round(game, &first, &second);
+    if (!game->winner) {
+        end_round(game);
+    }
+    return true;
+}
+
+// every roll the pyramid can give and its chance
+int roll_outcomes(Game* game, Outcome out[SEARCH_MAX_OUTCOMES]) {
+    DiceColor left[N_DICE + 1];
+    int n = remaining_dice(game, left);
+    int k = 0;
+    for (int d = 0; d < n; d++) {
+        int crazies = left[d] == DGREY ? 2 : 1;
+        for (int crazy = 0; crazy < crazies; crazy++) {
+            for (int value = 1; value <= 3; value++) {
+                out[k++] = (Outcome) {.die = die_face(left[d], crazy, value), .p = 1.0 / (n * crazies * 3)};
+            }
+        }
+    }
+    return k;
+}
+
+// leaf values: every seat's equity for max-n, for paranoid value[0] is the root's clamped margin
+void search_leaf(Searcher* s, Game* game, double value[N_PLAYERS]) {
+    search_equity(game, game->winner ? NULL : search_odds(s, game), value);
+    if (s->config.mode == SEARCH_PARANOID) {
+        double others = 0.0;
+        for (int p = 0; p < N_PLAYERS; p++) {
+            others += p != s->root ? value[p] : 0.0;
+        }
+        double margin = value[s->root] - others / (N_PLAYERS - 1);
+        value[0]      = margin < s->lower ? s->lower : margin > s->upper ? s->upper : margin;
+    }
+}
+
+// counts a node, false once the budget is spent and the search is unwinding
+bool search_tick(Searcher* s) {
+    if (++s->stats.nodes % SEARCH_CHECK_NODES == 0 && s->can_stop && now_ns() > s->deadline_ns) {
+        s->stopped = true;
+    }
+    return !s->stopped;
+}
+
+// legal turns of player, order lists their indices best first: tt_best, then by what each is worth on the spot
+int search_order(Searcher* s, Game* game, int player, int tt_best, Turn turns[MAX_TURN_OPTIONS],
+                 uint8_t order[MAX_TURN_OPTIONS]) {
+    int n               = legal_turns(game, player, turns);
+    const LegOdds* odds = search_odds(s, game);
+    double rate         = opponent_wager_rate(game);
+    double score[MAX_TURN_OPTIONS];
+    for (int i = 0; i < n; i++) {
+        Turn* t = &turns[i];
+        switch (t->turn_type) {
+            case ROLL:
+                score[i] = 1.0;
+                break;
+            case TICKET: {
+                Ticket* ticket = top_ticket(&game->tickets[t->color]);
+                score[i]       = ticket_ev(ticket->amount, odds->first[t->color], odds->second[t->color]);
+                break;
+            }
+            case WAGER: {
+                bool win = t->orientation == FORWARD;
+                double q = rate * (win ? odds->first : odds->last)[t->color] + (1.0 - rate) / N_BETS_COLORS;
+                int ahead = correct_bets_on(win ? &game->winner_bets : &game->loser_bets, t->color);
+                score[i]  = q * wager_payout(ahead) - (1.0 - q);
+                break;
+            }
+            case SPECTATOR:
+            default:
+                score[i] = 0.0;
+                break;
+        }
+        score[i] = i == tt_best ? HUGE_VAL : score[i];
+    }
+    for (int i = 0; i < n; i++) { // insertion sort, equal scores keep legal_turns order
+        int j = i;
+        for (; j > 0 && score[order[j - 1]] < score[i]; j--) {
+            order[j] = order[j - 1];
+        }
+        order[j] = (uint8_t) i;
+    }
+    return n;
+}
+
+SearchEntry* search_probe(Searcher* s, uint64_t key) {
+    if (s->config.exhaustive) {
+        return NULL;
+    }
+    SearchEntry* e = &s->table[key & s->mask];
+    return e->key == key && e->generation == s->generation ? e : NULL;
+}
+
+void search_store(Searcher* s, uint64_t key, int depth, TtBound bound, int best, const double value[N_PLAYERS]) {
+    if (s->config.exhaustive || s->stopped) {
+        return; // a search cut short leaves guesses behind
+    }
+    SearchEntry* e = &s->table[key & s->mask];
+    e->key         = key;
+    e->generation  = s->generation;
+    e->depth       = (int8_t) depth;
+    e->bound       = (uint8_t) bound;
+    e->best        = best < 0 ? SEARCH_NO_MOVE : (uint8_t) best;
+    memcpy(e->value, value, sizeof(e->value));
+}
+
+void maxn_chance(Searcher* s, Game* game, int player, int depth, double value[N_PLAYERS]);
+
+// max-n values of a decision node with player to move, best is set to the index in legal_turns of its turn
+void maxn_decision(Searcher* s, Game* game, int player, int depth, double value[N_PLAYERS], int* best) {
+    *best = -1;
+    if (!search_tick(s) || depth == 0) {
+        s->horizon |= depth == 0;
+        search_leaf(s, game, value);
+        return;
+    }
+    uint64_t key   = search_key(game, player);
+    SearchEntry* e = search_probe(s, key);
+    int tt_best    = e != NULL && e->best != SEARCH_NO_MOVE ? e->best : -1;
+    if (e != NULL && e->depth >= depth) {
+        s->stats.tt_hits++;
+        memcpy(value, e->value, sizeof(e->value));
+        *best = tt_best;
+        return;
+    }
+
+    Turn turns[MAX_TURN_OPTIONS];
+    uint8_t order[MAX_TURN_OPTIONS];
+    int n    = search_order(s, game, player, tt_best, turns, order);
+    int next = (player + 1) % N_PLAYERS;
+    double child[N_PLAYERS];
+    for (int k = 0; k < n; k++) {
+        int i = order[k];
+        if (turns[i].turn_type == ROLL) {
+            maxn_chance(s, game, player, depth - 1, child);
+        } else {
+            Game g = *game;
+            int unused;
+            search_turn(&g, &turns[i], player);
+            maxn_decision(s, &g, next, depth - 1, child, &unused);
+        }
+        if (*best < 0 || child[player] > value[player]) {
+            memcpy(value, child, sizeof(child));
+            *best = i;
+        }
+    }
+    search_store(s, key, depth, TT_EXACT, *best, value);
+}
+
+// max-n values of player's roll, the decisions after it searched to depth
+void maxn_chance(Searcher* s, Game* game, int player, int depth, double value[N_PLAYERS]) {
+    Outcome out[SEARCH_MAX_OUTCOMES];
+    int n    = roll_outcomes(game, out);
+    int next = (player + 1) % N_PLAYERS;
+    double child[N_PLAYERS];
+    memset(value, 0, N_PLAYERS * sizeof(double));
+    search_tick(s);
+    for (int i = 0; i < n; i++) {
+        Game g = *game;
+        if (search_roll(&g, out[i].die, player)) {
+            search_tick(s);
+            search_leaf(s, &g, child);
+        } else {
+            int unused;
+            maxn_decision(s, &g, next, depth, child, &unused);
+        }
+        for (int p = 0; p < N_PLAYERS; p++) {
+            value[p] += out[i].p * child[p];
+        }
+    }
+}
+
+double paranoid_chance(Searcher* s, Game* game, int player, int depth, double alpha, double beta);
+
+// paranoid value of a decision node: the root seat maximizes, everyone else minimizes. Fails soft: a value
+// <= alpha is an upper bound, >= beta a lower one. With probe only the first turn is searched, which bounds
+// the node from below at the root's nodes and from above at the others
+double paranoid_decision(Searcher* s, Game* game, int player, int depth, double alpha, double beta, bool probe,
+                         int* best) {
+    *best = -1;
+    if (!search_tick(s) || depth == 0) {
+        double value[N_PLAYERS];
+        s->horizon |= depth == 0;
+        search_leaf(s, game, value);
+        return value[0];
+    }
+    if (s->config.exhaustive) {
+        alpha = -HUGE_VAL;
+        beta  = HUGE_VAL;
+    }
+    uint64_t key   = search_key(game, player);
+    SearchEntry* e = search_probe(s, key);
+    int tt_best    = e != NULL && e->best != SEARCH_NO_MOVE ? e->best : -1;
+    if (e != NULL && !probe && e->depth >= depth) {
+        double v = e->value[0];
+        if (e->bound == TT_EXACT || (e->bound == TT_LOWER && v >= beta) || (e->bound == TT_UPPER && v <= alpha)) {
+            s->stats.tt_hits++;
+            *best = tt_best;
+            return v;
+        }
+    }
+
+    Turn turns[MAX_TURN_OPTIONS];
+    uint8_t order[MAX_TURN_OPTIONS];
+    int n           = search_order(s, game, player, tt_best, turns, order);
+    int next        = (player + 1) % N_PLAYERS;
+    bool maximizing = player == s->root;
+    double a = alpha, b = beta;
+    double value = maximizing ? -HUGE_VAL : HUGE_VAL;
+    for (int k = 0; k < (probe ? 1 : n); k++) {
+        int i = order[k];
+        double v;
+        if (turns[i].turn_type == ROLL) {
+            v = paranoid_chance(s, game, player, depth - 1, a, b);
+        } else {
+            Game g = *game;
+            int unused;
+            search_turn(&g, &turns[i], player);
+            v = paranoid_decision(s, &g, next, depth - 1, a, b, false, &unused);
+        }
+        if (maximizing ? v > value : v < value) {
+            value = v;
+            *best = i;
+        }
+        a = maximizing && v > a ? v : a;
+        b = !maximizing && v < b ? v : b;
+        if (a >= b) {
+            s->stats.cutoffs++;
+            break;
+        }
+    }
+    if (!probe) {
+        double stored[N_PLAYERS] = {value};
+        TtBound bound            = value <= alpha ? TT_UPPER : value >= beta ? TT_LOWER : TT_EXACT;
+        search_store(s, key, depth, bound, *best, stored);
+    }
+    return value;
+}
+
+// expected paranoid value of player's roll, the decisions after it searched to depth. Star2 first probes the
+// first turn of every child for a bound, then Star1 searches each child in the window the bounds of its
+// siblings leave open. Fails soft as paranoid_decision does
+double paranoid_chance(Searcher* s, Game* game, int player, int depth, double alpha, double beta) {
+    if (s->config.exhaustive) {
+        alpha = -HUGE_VAL;
+        beta  = HUGE_VAL;
+    }
+    Outcome out[SEARCH_MAX_OUTCOMES];
+    double lo[SEARCH_MAX_OUTCOMES], hi[SEARCH_MAX_OUTCOMES];
+    bool exact[SEARCH_MAX_OUTCOMES];
+    int n         = roll_outcomes(game, out);
+    int next      = (player + 1) % N_PLAYERS;
+    double sum_lo = 0.0, sum_hi = 0.0; // expected value with every child at its lower / upper bound
+    search_tick(s);
+    for (int i = 0; i < n; i++) {
+        Game g    = *game;
+        bool ends = search_roll(&g, out[i].die, player);
+        exact[i]  = ends || depth == 0;
+        lo[i]     = s->lower;
+        hi[i]     = s->upper;
+        if (exact[i]) {
+            double value[N_PLAYERS];
+            s->horizon |= !ends;
+            search_tick(s);
+            search_leaf(s, &g, value);
+            lo[i] = hi[i] = value[0];
+        }
+        sum_lo += out[i].p * lo[i];
+        sum_hi += out[i].p * hi[i];
+    }
+
+    for (int pass = s->config.exhaustive ? 1 : 0; pass < 2; pass++) { // 0: Star2 probes, 1: Star1
+        for (int i = 0; i < n; i++) {
+            if (sum_hi <= alpha || sum_lo >= beta) {
+                if (pass == 0) {
+                    s->stats.probe_cutoffs++;
+                } else {
+                    s->stats.cutoffs++;
+                }
+                return sum_hi <= alpha ? sum_hi : sum_lo;
+            }
+            if (exact[i]) {
+                continue;
+            }
+            double p       = out[i].p;
+            double rest_lo = sum_lo - p * lo[i], rest_hi = sum_hi - p * hi[i];
+            double fail_lo = (alpha - rest_hi) / p; // at or below, the whole roll is worth alpha or less
+            double fail_hi = (beta - rest_lo) / p;
+            Game g         = *game;
+            int unused;
+            search_roll(&g, out[i].die, player);
+            double v = paranoid_decision(s, &g, next, depth, fail_lo > lo[i] ? fail_lo : lo[i],
+                                         fail_hi < hi[i] ? fail_hi : hi[i], pass == 0, &unused);
+            if (pass == 0) {
+                if (next == s->root && v > fail_lo && v > lo[i]) {
+                    lo[i] = v; // one of the root's turns, the child is worth at least that
+                } else if (next != s->root && v < fail_hi && v < hi[i]) {
+                    hi[i] = v;
+                }
+            } else {
+                v        = v < lo[i] ? lo[i] : v > hi[i] ? hi[i] : v;
+                lo[i]    = v;
+                hi[i]    = v;
+                exact[i] = v > fail_lo && v < fail_hi;
+                if (!exact[i]) {
+                    s->stats.cutoffs++;
+                    return v <= fail_lo ? rest_hi + p * v : rest_lo + p * v;
+                }
+            }
+            sum_lo = rest_lo + p * lo[i];
+            sum_hi = rest_hi + p * hi[i];
+        }
+    }
+    return sum_lo;
+}
+
+// the best turn for player within the searcher's budget, s->stats says how deep and how fast it looked
+void search_best(Searcher* s, Game* game, int player, Turn* best) {
+    uint64_t start = now_ns();
+    s->generation  = (uint16_t) (s->generation % UINT16_MAX + 1); // 0 is what a fresh table holds
+    s->root        = player;
+    s->stats       = (SearchStats) {0};
+    s->stopped     = false;
+    s->deadline_ns = start + (uint64_t) (s->config.budget_ms * 1e6);
+
+    double now[N_PLAYERS];
+    s->lower = -HUGE_VAL;
+    s->upper = HUGE_VAL;
+    search_leaf(s, game, now); // unclamped, for paranoid now[0] is the root's margin
+    s->lower = now[0] - SEARCH_BOUND;
+    s->upper = now[0] + SEARCH_BOUND;
+
+    Turn turns[MAX_TURN_OPTIONS];
+    legal_turns(game, player, turns);
+    *best         = (Turn) {.turn_type = ROLL};
+    int max_depth = s->config.max_depth > 0 && s->config.max_depth < SEARCH_MAX_DEPTH ? s->config.max_depth
+                                                                                     : SEARCH_MAX_DEPTH;
+    for (int depth = 1; depth <= max_depth; depth++) {
+        s->can_stop = depth > 1;
+        s->horizon  = false;
+        int index;
+        double value;
+        if (s->config.mode == SEARCH_PARANOID) {
+            value = paranoid_decision(s, game, player, depth, -HUGE_VAL, HUGE_VAL, false, &index);
+        } else {
+            double values[N_PLAYERS];
+            maxn_decision(s, game, player, depth, values, &index);
+            value = values[player];
+        }
+        if (s->stopped) {
+            break;
+        }
+        *best          = turns[index];
+        s->stats.depth = depth;
+        s->stats.value = value;
+        if (!s->horizon) {
+            break; // every line reached the end of the leg, a deeper search sees nothing new
+        }
+    }
+    s->stats.seconds          = (double) (now_ns() - start) / 1e9;
+    s->stats.nodes_per_second = (double) s->stats.nodes / (s->stats.seconds > 0.0 ? s->stats.seconds : 1e-9);
+}
+
+// the thread's searcher's best turn, a roll while it has none
+void camels_bot_expectimax(Game* game, int player_id, Rng* rng, Turn* turn) {
+    (void) rng;
+    if (camels_searcher == NULL) {
+        *turn = (Turn) {.turn_type = ROLL};
+        return;
+    }
+    search_best(camels_searcher, game, player_id, turn);
+}
+
+//////////////////////////////////// Tournament //////////////////////////////////////
+// Round-robin between bot policies. Every pair of entrants plays every deal in all 20 ways of seating three
+// of each at the table. The seatings come in complementary pairs, so both sides sit in every seat equally
+// often. All of a deal's games share its dice stream and its policy stream (common random numbers), so
+// luck cancels between the two sides instead of adding noise. A game scores the share of head-to-head
+// seat pairs the first side won on points, ties counting half.
+// Ratings are a Bradley-Terry (Elo scale) fit to the mean scores, centred on 0. Their 95% intervals come
+// from refitting TOURNAMENT_BATCHES disjoint batches of deals, so the correlation CRN adds inside a deal
+// stays inside a batch. With fewer deals than batches the t quantile follows the batches actually played
+
+#define TOURNAMENT_SEATINGS     20 // C(6, 3)
+
+// two sided 95% Student t quantile for df degrees of freedom, df from 1 to TOURNAMENT_BATCHES - 1
+double student_t95(int df) {
+    static const double t95[] = {12.706, 4.303, 3.182, 2.776, 2.571, 2.447, 2.365, 2.306,
+                                 2.262,  2.228, 2.201, 2.179, 2.160, 2.145, 2.131};
+    _Static_assert(sizeof(t95) / sizeof(t95[0]) == TOURNAMENT_BATCHES - 1, "one quantile per batch count");
+    return t95[df - 1];
+}
+
+typedef struct {
+    double score[TOURNAMENT_BATCHES][TOURNAMENT_MAX_ENTRANTS][TOURNAMENT_MAX_ENTRANTS]; // summed, i against j
+    long games[TOURNAMENT_BATCHES][TOURNAMENT_MAX_ENTRANTS][TOURNAMENT_MAX_ENTRANTS];
+} TournamentTally;
+
+typedef struct {
+    TournamentConfig* config;
+    atomic_long* next_job;
+    int index; // for placement_enter
+    TournamentTally tally;
+} TournamentWorker;
+
+// takes the ticket worth the most expected coins by camels_approx_leg_odds when that beats a roll's sure coin
+void camels_bot_odds(Game* game, int player_id, Rng* rng, Turn* turn) {
+    (void) player_id;
+    (void) rng;
+    LegOdds odds;
+    camels_approx_leg_odds(game, &odds);
+    *turn       = (Turn) {.turn_type = ROLL};
+    double best = 1.0;
+    for (int c = 0; c < N_BETS_COLORS; c++) {
+        Ticket* t = top_ticket(&game->tickets[c]);
+        if (t != NULL && ticket_ev(t->amount, odds.first[c], odds.second[c]) > best) {
+            best  = ticket_ev(t->amount, odds.first[c], odds.second[c]);
+            *turn = (Turn) {.turn_type = TICKET, .color = (BetColor) c};
+        }
+    }
+}
+
+const Entrant camels_builtin_entrants[N_BUILTIN_ENTRANTS] = {
+    {"random", camels_bot_random}, {"greedy", camels_bot_greedy}, {"odds", camels_bot_odds}};
+
+// seat masks with three bits set, a mask and its complement next to each other
+int tournament_seatings(uint8_t seatings[TOURNAMENT_SEATINGS]) {
+    int n = 0;
+    for (unsigned mask = 0; mask < (1u << N_PLAYERS); mask++) {
+        if (__builtin_popcount(mask) == N_PLAYERS / 2 && (mask & 1u)) {
+            seatings[n++] = (uint8_t) mask;
+            seatings[n++] = (uint8_t) (~mask & ((1u << N_PLAYERS) - 1));
+        }
+    }
+    return n;
+}
+
+// share of (a, b) seat pairs where the a seat, a bit set in mask, finished ahead
+double seating_score(Game* game, uint8_t mask) {
+    double won = 0.0;
+    for (int a = 0; a < N_PLAYERS; a++) {
+        for (int b = 0; b < N_PLAYERS; b++) {
+            if ((mask >> a & 1u) && !(mask >> b & 1u)) {
+                int diff = game->players[a].points - game->players[b].points;
+                won += diff > 0 ? 1.0 : diff == 0 ? 0.5 : 0.0;
+            }
+        }
+    }
+    return won / ((N_PLAYERS / 2) * (N_PLAYERS / 2));
+}
+
+void* tournament_worker(void* arg) {
+    TournamentWorker* w = arg;
+    TournamentConfig* c = w->config;
+    int n_pairs         = c->n_entrants * (c->n_entrants - 1) / 2;
+    uint8_t seatings[TOURNAMENT_SEATINGS];
+    tournament_seatings(seatings);
+    WorkerBlock* block = worker_block_get(placement_enter(w->index));
+    assert(block != NULL && "Out of memory");
+    Game* game = &block->game;
+
+    long job;
+    while ((job = atomic_fetch_add(w->next_job, 1)) < c->deals * n_pairs) {
+        long deal = job / n_pairs;
+        int pair  = (int) (job % n_pairs);
+        int i = 0, j = 1;
+        for (int k = 0; k < pair; k++) {
+            j = j + 1 < c->n_entrants ? j + 1 : ++i + 1;
+        }
+        uint64_t deal_seed = c->seed ^ ((uint64_t) deal * 0xD1B54A32D192ED03ULL);
+        int batch          = (int) (deal % TOURNAMENT_BATCHES);
+
+        for (int s = 0; s < TOURNAMENT_SEATINGS; s++) {
+            Policy seats[N_PLAYERS];
+            for (int p = 0; p < N_PLAYERS; p++) {
+                seats[p] = (seatings[s] >> p & 1u) ? c->entrants[i].policy : c->entrants[j].policy;
+            }
+            Rng dice    = {.state = deal_seed};
+            Rng choices = {.state = deal_seed ^ 0x9E3779B97F4A7C15ULL};
+            memset(game, 0, sizeof(Game));
+            camels_game_rng = &dice;
+            camels_init_game(game);
+            camels_game_rng = NULL;
+            play_bot_game_streams(game, seats, &dice, &choices, NULL);
+
+            double score = seating_score(game, seatings[s]);
+            w->tally.score[batch][i][j] += score;
+            w->tally.score[batch][j][i] += 1.0 - score;
+            w->tally.games[batch][i][j]++;
+            w->tally.games[batch][j][i]++;
+        }
+    }
+    worker_block_put(block);
+    return NULL;
+}
+
+// Bradley-Terry ratings on the Elo scale from summed scores and game counts, mean 0
+void fit_elo(int n, double score[TOURNAMENT_MAX_ENTRANTS][TOURNAMENT_MAX_ENTRANTS],
+             long games[TOURNAMENT_MAX_ENTRANTS][TOURNAMENT_MAX_ENTRANTS], double elo[TOURNAMENT_MAX_ENTRANTS]) {
+    const double scale = log(10.0) / 400.0;
+    for (int i = 0; i < n; i++) {
+        elo[i] = 0.0;
+    }
+    for (int iter = 0; iter < 200; iter++) {
+        for (int i = 0; i < n; i++) {
+            double gradient = 0.0, curvature = 0.0;
+            for (int j = 0; j < n; j++) {
+                if (j != i && games[i][j] > 0) {
+                    double expected = 1.0 / (1.0 + pow(10.0, (elo[j] - elo[i]) / 400.0));
+                    gradient += score[i][j] - (double) games[i][j] * expected;
+                    curvature += (double) games[i][j] * expected * (1.0 - expected) * scale;
+                }
+            }
+            // a clean sweep has no finite maximum, cap it instead of running away
+            elo[i] = curvature > 0.0 ? fmax(-2000.0, fmin(2000.0, elo[i] + gradient / curvature)) : elo[i];
+        }
+    }
+    double mean = 0.0;
+    for (int i = 0; i < n; i++) {
+        mean += elo[i] / n;
+    }
+    for (int i = 0; i < n; i++) {
+        elo[i] -= mean;
+    }
+}
+
+// plays the round-robin across threads. Results do not depend on the thread count
+bool camels_tournament(TournamentConfig* config, TournamentResult* result) {
+    int n = config->n_entrants;
+    if (n < 2 || n > TOURNAMENT_MAX_ENTRANTS || config->deals < 1) {
+        return false;
+    }
+    int threads = config->threads > 0 ? config->threads : (int) sysconf(_SC_NPROCESSORS_ONLN);
+    threads     = threads > 0 ? threads : 1;
+
+    bool saved_log     = camels_log_enabled;
+    camels_log_enabled = false;
+    atomic_long next_job;
+    atomic_init(&next_job, 0);
+    TournamentWorker* workers = calloc((size_t) threads, sizeof(TournamentWorker));
+    pthread_t* ids            = calloc((size_t) threads, sizeof(pthread_t));
+    TournamentTally* total    = calloc(1, sizeof(TournamentTally));
+    assert(workers != NULL && ids != NULL && total != NULL && "Out of memory");
+
+    uint64_t start = now_ns();
+    for (int t = 0; t < threads; t++) {
+        workers[t].config   = config;
+        workers[t].next_job = &next_job;
+        workers[t].index    = t;
+        pthread_create(&ids[t], NULL, tournament_worker, &workers[t]);
+    }
+    for (int t = 0; t < threads; t++) {
+        pthread_join(ids[t], NULL);
+        for (int b = 0; b < TOURNAMENT_BATCHES; b++) {
+            for (int i = 0; i < n; i++) {
+                for (int j = 0; j < n; j++) {
+                    total->score[b][i][j] += workers[t].tally.score[b][i][j];
+                    total->games[b][i][j] += workers[t].tally.games[b][i][j];
+                }
+            }
+        }
+    }
+    result->seconds    = (double) (now_ns() - start) / 1e9;
+    camels_log_enabled = saved_log;
+
+    // every deal together, then each batch on its own for the spread
+    double score[TOURNAMENT_MAX_ENTRANTS][TOURNAMENT_MAX_ENTRANTS] = {{0}};
+    long games[TOURNAMENT_MAX_ENTRANTS][TOURNAMENT_MAX_ENTRANTS]   = {{0}};
+    result->games                                                  = 0;
+    for (int b = 0; b < TOURNAMENT_BATCHES; b++) {
+        for (int i = 0; i < n; i++) {
+            for (int j = 0; j < n; j++) {
+                score[i][j] += total->score[b][i][j];
+                games[i][j] += total->games[b][i][j];
+                result->games += i < j ? total->games[b][i][j] : 0;
+            }
+        }
+    }
+    for (int i = 0; i < n; i++) {
+        for (int j = 0; j < n; j++) {
+            result->score[i][j] = games[i][j] > 0 ? score[i][j] / (double) games[i][j] : 0.5;
+        }
+    }
+    fit_elo(n, score, games, result->elo);
+
+    double sum_sq[TOURNAMENT_MAX_ENTRANTS] = {0};
+    int batches                            = 0;
+    for (int b = 0; b < TOURNAMENT_BATCHES; b++) {
+        if (total->games[b][0][1] == 0) {
+            continue; // fewer deals than batches
+        }
+        double elo[TOURNAMENT_MAX_ENTRANTS];
+        fit_elo(n, total->score[b], total->games[b], elo);
+        for (int i = 0; i < n; i++) {
+            sum_sq[i] += (elo[i] - result->elo[i]) * (elo[i] - result->elo[i]);
+        }
+        batches++;
+    }
+    for (int i = 0; i < n; i++) {
+        result->elo_ci[i] = batches > 1 ? student_t95(batches - 1) * sqrt(sum_sq[i] / (batches - 1) / batches) : INFINITY;
+    }
+
+    free(workers);
+    free(ids);
+    free(total);
+    return true;
+}
+
+//////////////////////////////////// Position Encoding //////////////////////////////////////
+// Positions as state strings, the form camels_state and camels_load use and the engine protocol of the
+// frontend reads. The fields are listed with that protocol in src/main.c
+
+int char2camel(char c) {
+    const char* letters = "RBYGPWK"; // CamelColor order
+    const char* at      = c != '\0' ? strchr(letters, c) : NULL;
+    return at != NULL ? (int) (at - letters) : -1;
+}
+
+// writes game as a state string, false when buf is too small
+bool camels_encode_game(Game* game, int to_move, char* buf, size_t size) {
+    size_t n = 0;
+#define EMIT(...)                                                                                                      \
+    do {                                                                                                               \
+        int w = snprintf(buf + n, n < size ? size - n : 0, __VA_ARGS__);                                               \
+        n += w > 0 ? (size_t) w : 0;                                                                                   \
+    } while (0)
+    for (int b = 0; b < BOARD_SIZE; b++) {
+        CamelStack* stack = &game->board[b].camel_stack;
+        for (int j = 0; j < stack->count; j++) {
+            EMIT("%s", enum2char((CamelColor) stack->items[j].color));
+        }
+        if (game->board[b].has_spec) {
+            EMIT("%s%d", orient2char((Orientation) game->board[b].spec.orientation), game->board[b].spec.player);
+        }
+        EMIT("%s", b < BOARD_SIZE - 1 ? "/" : " ");
+    }
+    for (int i = 0; i < game->dice.count; i++) {
+        EMIT("%s%s%d", i > 0 ? "," : "", enum2char((CamelColor) game->dice.items[i].color), game->dice.items[i].value);
+    }
+    EMIT("%s ", game->dice.count == 0 ? "-" : "");
+    for (int c = 0; c < N_BETS_COLORS; c++) {
+        for (int j = 0; j < game->tickets[c].top; j++) {
+            EMIT("%d", game->tickets[c].items[j].player_id);
+        }
+        EMIT("%s", c < N_BETS_COLORS - 1 ? "/" : " ");
+    }
+    for (int p = 0; p < N_PLAYERS; p++) {
+        Player* player = &game->players[p];
+        EMIT("%d:%x:%d%s", player->points, player->hand, player->used_spec, p < N_PLAYERS - 1 ? "/" : " ");
+    }
+    WagerStack* bets[2] = {&game->winner_bets, &game->loser_bets};
+    for (int k = 0; k < 2; k++) {
+        for (int i = 0; i < bets[k]->count; i++) {
+            EMIT("%d%s", bets[k]->items[i].player, enum2char((CamelColor) bets[k]->items[i].color));
+        }
+        EMIT("%s ", bets[k]->count == 0 ? "-" : "");
+    }
+    EMIT("%d %d %d", to_move, game->turn, game->round);
+#undef EMIT
+    return n < size;
+}
+
+// parses a state string into game. False, with game in an unspecified state, when s is not a valid state
+bool camels_decode_game(const char* s, Game* game, int* to_move) {
+    memset(game, 0, sizeof(Game));
+    camels_init_game(game); // capacities, ids and a full set of tickets, everything else is overwritten
+    for (int b = 0; b < BOARD_SIZE; b++) {
+        game->board[b].camel_stack.count = 0;
+    }
+
+    bool seen[N_CAMELS] = {false};
+    for (int b = 0; b < BOARD_SIZE; b++) {
+        for (; *s != '/' && *s != ' '; s++) {
+            int color = char2camel(*s);
+            if (color >= 0 && !seen[color]) {
+                Camel camel = {.color       = (uint8_t) color,
+                               .orientation = color >= N_BETS_COLORS ? REVERSE : FORWARD,
+                               .space       = (int8_t) b};
+                seen[color] = true;
+                stack_push(&game->board[b].camel_stack, camel);
+                game->winner |= color < N_BETS_COLORS && b == BOARD_SIZE - 1;
+            } else if ((*s == '+' || *s == '-') && s[1] >= '0' && s[1] < '0' + N_PLAYERS && !game->board[b].has_spec) {
+                game->board[b].has_spec = true;
+                game->board[b].spec     = (Spectator) {.player = (uint8_t) (s[1] - '0'), .orientation = *s == '+' ? FORWARD : REVERSE};
+                s++;
+            } else {
+                return false;
+            }
+        }
+        if (*s++ != (b < BOARD_SIZE - 1 ? '/' : ' ')) {
+            return false;
+        }
+    }
+    for (int c = 0; c < N_CAMELS; c++) {
+        if (!seen[c]) {
+            return false;
+        }
+    }
+    // spectators where place_spec_tile would have put them: off the finish tile, off camels, not side by side
+    for (int b = 0; b < BOARD_SIZE; b++) {
+        if (game->board[b].has_spec && (b == BOARD_SIZE - 1 || game->board[b].camel_stack.count > 0 ||
+                                        (b > 0 && game->board[b - 1].has_spec))) {
+            return false;
+        }
+    }
+
+    if (*s == '-') {
+        s++;
+    }
+    bool rolled[N_DICE + 1] = {false}; // by DiceColor, both crazy camels roll the grey die
+    while (*s != ' ') {
+        int color = char2camel(*s);
+        char* end;
+        long value = color >= 0 ? strtol(s + 1, &end, 10) : 0;
+        int die    = color >= N_BETS_COLORS ? (int) DGREY : color;
+        if (color < 0 || (color < N_BETS_COLORS ? value < 1 || value > 3 : value < -3 || value > -1) ||
+            rolled[die] || game->dice.count == N_DICE) {
+            return false;
+        }
+        rolled[die] = true;
+        Roll roll = {.color = (uint8_t) color, .value = (int8_t) value};
+        stack_push(&game->dice, roll);
+        s = *end == ',' ? end + 1 : end;
+    }
+    s++;
+
+    for (int c = 0; c < N_BETS_COLORS; c++) {
+        for (; *s >= '0' && *s < '0' + N_PLAYERS; s++) {
+            if (take_ticket(&game->tickets[c], *s - '0') < 0) {
+                return false;
+            }
+        }
+        if (*s++ != (c < N_BETS_COLORS - 1 ? '/' : ' ')) {
+            return false;
+        }
+    }
+
+    for (int p = 0; p < N_PLAYERS; p++) {
+        int points, used, len = 0;
+        unsigned hand;
+        if (sscanf(s, "%d:%x:%d%n", &points, &hand, &used, &len) != 3 || hand > FULL_HAND) {
+            return false;
+        }
+        game->players[p].points    = (int16_t) points;
+        game->players[p].hand      = (uint8_t) hand;
+        game->players[p].used_spec = used != 0;
+        s += len;
+        if (*s++ != (p < N_PLAYERS - 1 ? '/' : ' ')) {
+            return false;
+        }
+    }
+
+    WagerStack* bets[2] = {&game->winner_bets, &game->loser_bets};
+    for (int k = 0; k < 2; k++) {
+        if (*s == '-') {
+            s++;
+        }
+        for (; *s != ' ' && *s != '\0'; s += 2) {
+            int color = char2camel(s[1]);
+            if (*s < '0' || *s >= '0' + N_PLAYERS || color < 0 || color >= N_BETS_COLORS || bets[k]->count == MAX_WAGERS) {
+                return false;
+            }
+            Wager w = {.player = (uint8_t) (*s - '0'), .color = (uint8_t) color};
+            stack_push(bets[k], w);
+        }
+        if (*s++ != ' ') {
+            return false;
+        }
+    }
+
+    int turn, round, len = 0;
+    if (sscanf(s, "%d %d %d%n", to_move, &turn, &round, &len) != 3 || *to_move < 0 || *to_move >= N_PLAYERS ||
+        turn < 0 || turn > UINT16_MAX || round < 0 || round > UINT8_MAX || (s[len] != '\0' && s[len] != '\n')) {
+        return false;
+    }
+    game->turn  = (uint16_t) turn;
+    game->round = (uint8_t) round;
+    return true;
+}
+
+//////////////////////////////////// Library API //////////////////////////////////////
+// The exported functions of include/camels.h. A CamelsGame is a Session, public enums mirror the internal
+// ones value for value so events and turns convert field by field
+
+_Static_assert(CAMELS_PLAYERS == N_PLAYERS && CAMELS_COLORS == N_BETS_COLORS && CAMELS_SPACES == BOARD_SIZE,
+               "camels.h sizes should match the engine");
+_Static_assert(CAMELS_MAX_TURNS == MAX_TURN_OPTIONS, "camels.h should fit every legal turn");
+_Static_assert((int) CAMELS_WAGER == WAGER && (int) CAMELS_ROLL == ROLL && (int) CAMELS_TICKET == TICKET &&
+                   (int) CAMELS_SPECTATOR == SPECTATOR,
+               "camels.h turn types should match TurnType");
+_Static_assert((int) CAMELS_AWAIT_TURN == EV_AWAIT_TURN && (int) CAMELS_GAME_OVER == EV_GAME_OVER,
+               "camels.h events should match EventType");
+
+struct CamelsGame {
+    Session session;
+};
+
+Turn turn_from_api(const CamelsTurn* in) {
+    Turn turn = {.turn_type = (TurnType) in->type, .color = (BetColor) in->color, .position = in->space};
+    if (in->type == CAMELS_WAGER) {
+        turn.orientation = in->winner ? FORWARD : REVERSE;
+    } else if (in->type == CAMELS_SPECTATOR) {
+        turn.orientation = in->forward ? FORWARD : REVERSE;
+    }
+    return turn;
+}
+
+CamelsTurn turn_to_api(const Turn* in) {
+    return (CamelsTurn) {.type    = (CamelsTurnType) in->turn_type,
+                         .winner  = in->turn_type == WAGER && in->orientation == FORWARD,
+                         .forward = in->turn_type == SPECTATOR && in->orientation == FORWARD,
+                         .color   = (int) in->color,
+                         .space   = in->position};
+}
+
+CAMELS_API int camels_abi_version(void) { return CAMELS_ABI_VERSION; }
+
+CAMELS_API CamelsGame* camels_new(uint64_t seed, const CamelsSeat seats[CAMELS_PLAYERS]) {
+    CamelsGame* game = malloc(sizeof(CamelsGame));
+    if (game == NULL) {
+        return NULL;
+    }
+    Policy policies[N_PLAYERS] = {NULL};
+    for (int i = 0; i < N_PLAYERS; i++) {
+        policies[i] = seats[i] == CAMELS_RANDOM_BOT   ? camels_bot_random
+                      : seats[i] == CAMELS_GREEDY_BOT ? camels_bot_greedy
+                                                      : NULL;
+    }
+    camels_start_game(&game->session, policies, seed);
+    return game;
+}
+
+CAMELS_API CamelsGame* camels_load(const char* state) {
+    CamelsGame* game = calloc(1, sizeof(CamelsGame));
+    int to_move;
+    if (game == NULL || !camels_decode_game(state, &game->session.game, &to_move)) {
+        free(game);
+        return NULL;
+    }
+    game->session.curr_player_id = to_move;
+    game->session.state          = STATE_TURN;
+    game->session.rng.state      = (uint64_t) game->session.game.turn; // same state, same dice
+    return game;
+}
+
+CAMELS_API CamelsGame* camels_clone(const CamelsGame* game) {
+    CamelsGame* copy = malloc(sizeof(CamelsGame));
+    if (copy != NULL) {
+        *copy = *game;
+    }
+    return copy;
+}
+
+CAMELS_API void camels_free(CamelsGame* game) { free(game); }
+
+CAMELS_API int camels_poll(CamelsGame* game, CamelsEvent* out, int max) {
+    Event events[SESSION_EVENTS];
+    int n = camels_poll_events(&game->session, events, max < SESSION_EVENTS ? max : SESSION_EVENTS);
+    for (int i = 0; i < n; i++) {
+        out[i] = (CamelsEvent) {.type   = (CamelsEventType) events[i].type,
+                                .player = events[i].player,
+                                .turn   = turn_to_api(&events[i].turn),
+                                .first  = events[i].first,
+                                .second = events[i].second};
+    }
+    return n;
+}
+
+CAMELS_API bool camels_submit(CamelsGame* game, int player, const CamelsTurn* turn) {
+    Turn t = turn_from_api(turn);
+    return player >= 0 && player < N_PLAYERS && camels_submit_turn(&game->session, player, &t);
+}
+
+CAMELS_API int camels_legal_turns(const CamelsGame* game, int player, CamelsTurn out[CAMELS_MAX_TURNS]) {
+    if (player < 0 || player >= N_PLAYERS) {
+        return 0;
+    }
+    Game copy = game->session.game;
+    Turn turns[MAX_TURN_OPTIONS];
+    int n = legal_turns(&copy, player, turns);
+    for (int i = 0; i < n; i++) {
+        out[i] = turn_to_api(&turns[i]);
+    }
+    return n;
+}
+
+CAMELS_API int camels_to_move(const CamelsGame* game) {
+    return game->session.state == STATE_GAME_OVER ? -1 : game->session.curr_player_id;
+}
+
+CAMELS_API int camels_points(const CamelsGame* game, int player) {
+    return player >= 0 && player < N_PLAYERS ? game->session.game.players[player].points : -1;
+}
+
+CAMELS_API int camels_space(const CamelsGame* game, int color) {
+    if (color < 0 || color >= N_BETS_COLORS) {
+        return -1;
+    }
+    Game copy = game->session.game;
+    return get_camel(&copy, (CamelColor) color)->space;
+}
+
+CAMELS_API int camels_round(const CamelsGame* game) { return game->session.game.round; }
+
+CAMELS_API void camels_leg_odds(const CamelsGame* game, CamelsOdds* odds) {
+    Game copy = game->session.game;
+    LegOdds leg;
+    leg_odds(&copy, &leg);
+    for (int c = 0; c < N_BETS_COLORS; c++) {
+        odds->first[c]  = leg.first[c];
+        odds->second[c] = leg.second[c];
+        odds->last[c]   = leg.last[c];
+    }
+}
+
+CAMELS_API bool camels_state(const CamelsGame* game, char* buf, size_t size) {
+    Game copy = game->session.game;
+    return camels_encode_game(&copy, game->session.curr_player_id, buf, size);
+}
@@ -0,0 +1,595 @@
+// The engine behind libcamels as the camels frontend, the tests and the benches see it. include/camels.h is the
+// stable API for everyone else. The game types are here because the frontend draws the board from them, and
+// the functions are exported with a camels_ prefix but may change with any build. Everything engine.c does
+// not declare here stays inside the library: hidden in libcamels.so and made local in libcamels.a
+
+#ifndef CAMELS_ENGINE_H
+#define CAMELS_ENGINE_H
+
+#include <pthread.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <time.h>
+
+#include "camels.h"
+
+#define DEBUG(fmt, ...) fprintf(stderr, "DEBUG %s %d " fmt "\n", __FILE__, __LINE__, ##__VA_ARGS__)
+#define LOG(fmt, ...)                                                                                                  \
+    do {                                                                                                               \
+        if (camels_log_enabled)                                                                                        \
+            fprintf(stderr, "LOG %s %d " fmt "\n", __FILE__, __LINE__, ##__VA_ARGS__);                                 \
+    } while (0)
+
+CAMELS_API extern bool camels_log_enabled; // per-turn LOG lines, off unless the host turns them on
+
+//////////////////////////////////// Game State //////////////////////////////////////
+
+#define BOARD_SIZE    17 // 16 for real game 17th is for winning camels
+#define N_PLAYERS     6  // number of players
+#define N_DICE        5  // number of dice per round - one less than total dice
+#define N_BETS_COLORS 5  // 1 per regular camel color
+#define N_TICKETS     4  // 5,3,2,2
+#define N_CAMELS      7  // reg + 2 crazy
+#define MAX_WAGERS    N_PLAYERS* N_BETS_COLORS
+
+typedef enum { BRED, BBLUE, BYELLOW, BGREEN, BPURPLE } BetColor;
+typedef enum { CRED, CBLUE, CYELLOW, CGREEN, CPURPLE, CWHITE, CBLACK } CamelColor;
+typedef enum { DRED, DBLUE, DYELLOW, DGREEN, DPURPLE, DGREY } DiceColor;
+typedef enum { FORWARD, REVERSE } Orientation;
+typedef enum { WAGER, ROLL, TICKET, SPECTATOR } TurnType;
+
+static inline const char* orient2char(Orientation oreint) {
+    if (oreint == FORWARD) {
+        return "+";
+    }
+    return "-";
+}
+
+static inline const char* enum2char(CamelColor color) {
+    switch (color) {
+        case CRED:
+            return "R";
+        case CBLUE:
+            return "B";
+        case CYELLOW:
+            return "Y";
+        case CGREEN:
+            return "G";
+        case CPURPLE:
+            return "P";
+        case CBLACK:
+            return "K";
+        case CWHITE:
+            return "W";
+        default:
+            return NULL;
+    }
+}
+
+typedef struct {
+    size_t count;
+    size_t capacity;
+    int* items;
+} Locations;
+
+typedef struct {
+    TurnType turn_type;
+    Orientation orientation; // For Wager:  FORWARD == winner, REVERSE == LOOSER
+    BetColor color;          // for wafer and ticket
+    int position;            // Spectator position
+} Turn;
+
+// Everything below is stored in the smallest type that holds it so a Game stays a flat ~700 byte value
+// that copies, hashes and compares cheaply. Enum fields are kept as uint8_t and read back through casts
+
+typedef struct {
+    uint8_t color; // CamelColor
+    int8_t value;  // 1, 2, 3, negative for the crazy die
+} Roll;
+
+typedef struct {
+    uint8_t count;
+    uint8_t capacity;
+    Roll items[N_DICE];
+} Dice;
+
+typedef struct {
+    uint8_t player;
+    uint8_t color; // BetColor
+} Wager;
+
+typedef struct {
+    uint8_t count;
+    uint8_t capacity;
+    Wager items[MAX_WAGERS];
+} WagerStack;
+
+typedef struct {
+    int8_t amount;    // 5, 3, 2, 2
+    int8_t player_id; // -1 if available >=0 refers to player holding the ticket
+} Ticket;
+
+// tickets are dealt from the bottom up: items[top] is the best one left, everything below it is held
+typedef struct {
+    uint8_t count;
+    uint8_t capacity;
+    uint8_t top;
+    Ticket items[N_TICKETS];
+} TicketStack;
+
+typedef struct {
+    uint8_t color;       // CamelColor
+    uint8_t orientation; // Orientation
+    int8_t space;        // space the camel is on - NOT NEEDED
+} Camel;
+
+typedef struct {
+    uint8_t count;
+    uint8_t capacity;
+    Camel items[N_CAMELS];
+} CamelStack;
+
+typedef struct {
+    uint8_t player;      // who placed spec
+    uint8_t orientation; // +1 or -1
+} Spectator;
+
+typedef struct {
+    Spectator spec; // spec card on spot
+    bool has_spec;  // spec card on spot?
+    CamelStack camel_stack;
+} Tile;
+
+#define FULL_HAND ((uint8_t) ((1u << N_BETS_COLORS) - 1))
+
+typedef struct {
+    uint8_t id;
+    bool used_spec;
+    uint8_t hand; // bit per BetColor, set while the card can still be bet for winner or loser
+    int16_t points;
+} Player;
+
+typedef struct {
+    bool winner;
+    uint8_t round;
+    uint16_t turn;
+    Dice dice;
+    Tile board[BOARD_SIZE]; // array of tiles each tile can either be a stack of camels or a spec - add one for
+                            // winnner spot
+    Player players[N_PLAYERS];
+    TicketStack tickets[N_BETS_COLORS];
+    WagerStack winner_bets; // stacks
+    WagerStack loser_bets;  // stacks
+} Game;
+
+_Static_assert(sizeof(Camel) == 3, "Camel should pack into 3 bytes");
+_Static_assert(sizeof(Tile) == 26, "Tile should pack into 26 bytes");
+_Static_assert(sizeof(Player) == 6, "Player should pack into 6 bytes");
+_Static_assert(sizeof(Wager) == 2, "Wager should pack into 2 bytes");
+_Static_assert(sizeof(Game) <= 704, "Game should stay a compact flat value");
+
+static inline double elapsed_ms(clock_t start) { return 1000.0 * (double) (clock() - start) / CLOCKS_PER_SEC; }
+
+static inline uint64_t now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t) ts.tv_sec * 1000000000ULL + (uint64_t) ts.tv_nsec;
+}
+
+// splitmix64, kept separate from rand() so analysis never disturbs the dice of the live game
+typedef struct {
+    uint64_t state;
+} Rng;
+
+static inline uint64_t rng_next(Rng* rng) {
+    uint64_t z = (rng->state += 0x9E3779B97F4A7C15ULL);
+    z          = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    z          = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+    return z ^ (z >> 31);
+}
+
+static inline int rng_range(Rng* rng, int low, int high) {
+    return (int) (rng_next(rng) % (uint64_t) (high - low + 1)) + low;
+}
+
+// when set, the game's own draws (camel setup and dice) come from this thread's stream instead of rand()
+CAMELS_API extern _Thread_local Rng* camels_game_rng;
+
+CAMELS_API void camels_init_game(Game* game);
+
+//////////////////////////////////// Stack //////////////////////////////////////
+
+#define stack_push(s, i) (((s)->count < (s)->capacity) ? ((s)->items[(s)->count++] = (i), true) : false)
+#define stack_pop(s, i)  ((s)->count > 0 ? * i = (s)->items[--(s)->count], (true) : (false))
+#define stack_empty(s)   ((s)->count == 0 ? true : false)
+#define stack_peak(s)    ((s)->items[(s)->count - 1])
+#define stack_count(s)   ((s)->count)
+
+//////////////////////////////////// Stats //////////////////////////////////////
+
+#define STAT_LATENCY_BUCKETS 32 // log2(ns) buckets
+
+typedef struct {
+    uint64_t move_calls;
+    uint64_t move_carried;       // camels moved, summed over calls
+    uint64_t move_carried_max;   // tallest stack moved at once
+    uint64_t reverse_inserts;    // moves that slid under the destination stack
+    uint64_t spectator_hits;     // moves that landed on a spectator tile
+    uint64_t get_camel_calls;
+    uint64_t get_camel_scanned;  // camels looked at before a match
+    uint64_t score_round_calls;
+    uint64_t assign_points_calls;
+    uint64_t score_wagers_calls;
+    uint64_t turns;
+    uint64_t invalid_turns;      // turns next_turn rejected
+    uint64_t turn_ns;            // total time in next_turn
+    uint64_t turn_ns_max;
+    uint64_t turn_latency[STAT_LATENCY_BUCKETS];
+} Stats;
+
+CAMELS_API extern Stats camels_stats_total;
+
+CAMELS_API void camels_stats_merge(void);
+CAMELS_API void camels_stats_dump(FILE* out, Stats* s);
+
+//////////////////////////////////// Placement //////////////////////////////////////
+
+typedef enum { HUGE_EXPLICIT, HUGE_TRANSPARENT, HUGE_NONE } HugeKind;
+
+typedef struct {
+    void* base;
+    size_t size; // mapped bytes, 0 when base came from calloc
+    HugeKind kind;
+} HugeRegion;
+
+//////////////////////////////////// Tablebase //////////////////////////////////////
+
+#define TB_MAGIC       "CMLSTBAS"
+#define TB_VERSION     1
+#define TB_SPAN        (BOARD_SIZE - 1) // default: the whole track
+#define TB_DICE_STATES 64               // rolled racing dice by label, bit N_BETS_COLORS for grey
+#define TB_WALK_ROLLS  3                // mid-leg queries walk at most this many rolls to reach the table
+
+typedef struct {
+    char magic[8];
+    uint32_t version;
+    uint32_t span;
+    uint32_t entries;
+    uint32_t entry_size;
+} TablebaseHeader;
+
+typedef struct {
+    float first[N_BETS_COLORS]; // by label
+    float last[N_BETS_COLORS];
+} TablebaseEntry;
+
+typedef struct {
+    const uint8_t* data;
+    size_t size;
+    int span;
+    uint32_t entries;
+    const TablebaseEntry* table;
+} Tablebase;
+
+CAMELS_API extern const Tablebase* camels_tablebase; // when set, value_wagers reads exact odds from it before sampling
+
+CAMELS_API bool camels_tablebase_generate(const char* path, int span, uint32_t* entries);
+CAMELS_API bool camels_tablebase_open(Tablebase* tb, const char* path);
+CAMELS_API bool camels_tablebase_odds(const Tablebase* tb, Game* game, double p_first[N_BETS_COLORS],
+                                      double p_last[N_BETS_COLORS]);
+
+//////////////////////////////////// Wager Valuation //////////////////////////////////////
+
+typedef struct {
+    bool available;     // player still holds this color card
+    double p_first;     // whole-race win probability
+    double p_last;      // whole-race last place probability
+    double winner_now;  // EV of a winner wager placed this turn
+    double winner_wait; // EV of the same wager after every opponent has had one more turn
+    double loser_now;
+    double loser_wait;
+} WagerValue;
+
+//////////////////////////////////// Evaluation //////////////////////////////////////
+
+#define N_FEATURES_USED 77
+#define N_FEATURES      80 // multiple of 4 for SIMD
+#define N_EVAL_OUTPUTS  (3 * N_BETS_COLORS)
+#define EVAL_HIDDEN     32
+
+typedef enum { EVAL_LINEAR, EVAL_MLP } EvalKind;
+
+typedef struct {
+    EvalKind kind;
+    _Alignas(16) float w1[EVAL_HIDDEN][N_FEATURES];  // linear: first N_EVAL_OUTPUTS rows are the output layer
+    _Alignas(16) float b1[EVAL_HIDDEN];
+    _Alignas(16) float w2[N_EVAL_OUTPUTS][EVAL_HIDDEN]; // mlp only
+    _Alignas(16) float b2[N_EVAL_OUTPUTS];
+} Evaluator;
+
+CAMELS_API void camels_eval_game(const Evaluator* ev, Game* game, float out[N_EVAL_OUTPUTS]);
+CAMELS_API bool camels_eval_load(Evaluator* ev, const char* path);
+
+//////////////////////////////////// Bots //////////////////////////////////////
+
+#define MAX_TURN_OPTIONS (1 + N_BETS_COLORS + 2 * N_BETS_COLORS + 2 * (BOARD_SIZE - 1))
+
+typedef void (*Policy)(Game* game, int player_id, Rng* rng, Turn* turn);
+
+// observers of a bot game, any may be NULL
+typedef struct {
+    void (*on_turn)(void* ctx, Game* game, int player_id);                 // before player_id picks a turn
+    void (*on_turn_done)(void* ctx, Game* game, int player_id, Turn* turn); // after the turn was applied
+    void (*on_leg)(void* ctx, Game* game, int first, int second);          // after the leg is scored
+    void* ctx;
+} GameHooks;
+
+CAMELS_API void camels_bot_random(Game* game, int player_id, Rng* rng, Turn* turn);
+CAMELS_API void camels_bot_greedy(Game* game, int player_id, Rng* rng, Turn* turn);
+CAMELS_API void camels_bot_odds(Game* game, int player_id, Rng* rng, Turn* turn);
+CAMELS_API void camels_bot_expectimax(Game* game, int player_id, Rng* rng, Turn* turn);
+CAMELS_API int camels_play_bot_game(Game* game, Policy policies[N_PLAYERS], Rng* rng, GameHooks* hooks);
+
+//////////////////////////////////// Self-play Dataset //////////////////////////////////////
+
+typedef struct {
+    int threads;        // 0 for one per online core
+    long games;
+    double sample_rate; // chance each pre-turn position is recorded
+    uint64_t seed;
+    bool compress;
+} SelfPlayConfig;
+
+typedef struct {
+    long games;
+    uint64_t positions;
+    uint64_t bytes;
+    double seconds;
+} SelfPlayResult;
+
+CAMELS_API bool camels_self_play(SelfPlayConfig* config, const char* path, SelfPlayResult* result);
+
+//////////////////////////////////// Columnar Export //////////////////////////////////////
+
+CAMELS_API bool camels_export_games(const char* path, long n_games, uint64_t seed, uint64_t* rows, uint64_t* bytes);
+
+//////////////////////////////////// Sessions //////////////////////////////////////
+
+#define SESSION_EVENTS 64
+
+typedef enum { EV_AWAIT_TURN, EV_TURN, EV_REJECTED, EV_LEG_SCORED, EV_ROUND_ENDED, EV_GAME_OVER } EventType;
+typedef enum { STATE_TURN, STATE_WAIT_INPUT, STATE_SCORE, STATE_END_ROUND, STATE_GAME_OVER } SessionState;
+
+typedef struct {
+    EventType type;
+    int player; // AWAIT_TURN, TURN, REJECTED
+    Turn turn;  // TURN, REJECTED
+    int first;  // LEG_SCORED
+    int second;
+} Event;
+
+typedef struct {
+    Game game;
+    SessionState state;
+    int curr_player_id;
+    Policy seats[N_PLAYERS]; // NULL for a human seat
+    Rng rng;
+    Event events[SESSION_EVENTS]; // ring of events not yet polled
+    size_t event_head;
+    size_t event_count;
+} Session;
+
+CAMELS_API void camels_start_game(Session* session, Policy seats[N_PLAYERS], uint64_t seed);
+CAMELS_API bool camels_submit_turn(Session* session, int player_id, Turn* turn);
+CAMELS_API int camels_poll_events(Session* session, Event* out, int max);
+
+//////////////////////////////////// Leg Odds //////////////////////////////////////
+
+typedef struct {
+    double first[N_BETS_COLORS];
+    double second[N_BETS_COLORS];
+    double last[N_BETS_COLORS];
+} LegOdds;
+
+// everything the rest of the leg depends on, camels listed in canonical order
+typedef struct {
+    uint8_t camels[N_CAMELS]; // space * N_CAMELS + height, racing camels first
+    uint8_t rolled;           // bit per canonical racing die, bit N_BETS_COLORS for grey
+    uint32_t specs;           // two bits per tile: has spec, spec is REVERSE
+} LegKey;
+
+_Static_assert(sizeof(LegKey) == 12, "LegKey should pack into 12 bytes");
+
+typedef struct {
+    LegKey key;
+    bool used;
+    LegOdds odds; // by canonical label
+} LegCacheEntry;
+
+// direct-mapped, newest entry wins a slot. Not shared between threads
+typedef struct {
+    LegCacheEntry* entries;
+    HugeRegion table; // backs entries
+    size_t mask;
+    bool canonical; // false keys positions by color, for comparison
+    uint64_t hits;
+    uint64_t misses;
+} LegCache;
+
+// Leg odds that follow one game from turn to turn. The cache outlives each query, so after a roll the new
+// position is a node the previous walk already stored and only needs a lookup. Tickets, wagers and turns
+// that leave the race untouched give back the same key as the last answer, which is returned as is
+typedef struct {
+    LegCache cache;
+    bool has_root;
+    LegKey root; // color key of the last position answered
+    LegOdds odds;
+    uint64_t root_hits;
+} LegTracker;
+
+CAMELS_API bool camels_leg_tracker_init(LegTracker* tracker, int log2_entries);
+CAMELS_API void camels_leg_tracker_free(LegTracker* tracker);
+CAMELS_API void camels_leg_tracker_odds(LegTracker* tracker, Game* game, LegOdds* odds);
+CAMELS_API void camels_approx_leg_odds(Game* game, LegOdds* odds);
+
+//////////////////////////////////// Sweeps //////////////////////////////////////
+
+typedef enum { SWEEP_RACE, SWEEP_GAMES } SweepMode;
+
+typedef struct {
+    uint64_t seed;
+    uint64_t samples;
+    uint32_t mode;  // SweepMode
+    Game position;  // start of every SWEEP_RACE playout, SWEEP_GAMES deals a new game per sample
+} SweepJob;
+
+typedef struct {
+    uint64_t samples;
+    uint64_t first[N_BETS_COLORS];
+    uint64_t last[N_BETS_COLORS];
+    uint64_t seat[N_PLAYERS]; // SWEEP_GAMES: seat with the most points, lowest seat on a tie
+} SweepHistogram;
+
+CAMELS_API void camels_sweep_range(const SweepJob* job, uint64_t begin, uint64_t count, SweepHistogram* hist);
+CAMELS_API void camels_sweep_merge(SweepHistogram* into, const SweepHistogram* from);
+
+//////////////////////////////////// Pondering //////////////////////////////////////
+
+#define PONDER_WAGER_MS 50.0
+
+typedef enum { PONDER_NONE, PONDER_APPROX, PONDER_EXACT, PONDER_DONE } PonderDepth;
+
+typedef struct {
+    int depth; // PonderDepth reached so far
+    uint16_t turn;
+    uint8_t round;
+    int player_id;
+    LegOdds odds;
+    bool has_ticket[N_BETS_COLORS];
+    double ticket_ev[N_BETS_COLORS]; // taking the top ticket of the color now
+    WagerValue wagers[N_BETS_COLORS];
+    Turn hint; // best of roll, tickets and wagers placed now, spectator tiles are not weighed
+    double hint_ev;
+} PonderResult;
+
+typedef struct {
+    pthread_t thread;
+    pthread_mutex_t lock;
+    pthread_mutex_t draw; // held around redraw, so camels_ponder_stop waits out one in flight
+    pthread_cond_t wake;
+    uint64_t generation; // bumped by every start and stop, work for an older one is dropped
+    bool pending;        // a position is waiting or being analysed
+    bool quit;
+    Game game;           // position of the current generation
+    int player_id;
+    PonderResult result;
+    void (*redraw)(void* ctx, Game* game); // called from the pondering thread, may be NULL
+    void* ctx;
+    double wager_ms; // sampling budget of the wager phase, PONDER_WAGER_MS unless changed before a start
+    LegTracker legs; // kept across positions, later turns of a leg are lookups
+    Rng rng;
+} Ponder;
+
+CAMELS_API bool camels_ponder_init(Ponder* p, void (*redraw)(void* ctx, Game* game), void* ctx);
+CAMELS_API void camels_ponder_free(Ponder* p);
+CAMELS_API void camels_ponder_start(Ponder* p, Game* game, int player_id);
+CAMELS_API void camels_ponder_stop(Ponder* p);
+CAMELS_API bool camels_ponder_result(Ponder* p, PonderResult* out);
+CAMELS_API void camels_ponder_moves(Game* game, PonderResult* r);
+
+//////////////////////////////////// Expectimax Search //////////////////////////////////////
+
+typedef enum { SEARCH_MAXN, SEARCH_PARANOID } SearchMode;
+typedef enum { TT_EXACT, TT_LOWER, TT_UPPER } TtBound;
+
+typedef struct {
+    SearchMode mode;
+    double budget_ms;
+    int max_depth;   // 0 for SEARCH_MAX_DEPTH
+    bool exhaustive; // no table, alpha-beta or Star cuts, to check them against
+} SearchConfig;
+
+typedef struct {
+    int depth;      // deepest iteration finished
+    uint64_t nodes; // decision and chance nodes and leaves, the iteration cut short included
+    double seconds;
+    double nodes_per_second;
+    uint64_t tt_hits;
+    uint64_t cutoffs;       // alpha-beta and Star1
+    uint64_t probe_cutoffs; // Star2
+    double value;           // of the turn chosen for the root seat, its margin when paranoid
+} SearchStats;
+
+typedef struct {
+    uint64_t key;
+    uint16_t generation;
+    int8_t depth;
+    uint8_t bound;           // TtBound
+    uint8_t best;            // index into legal_turns, SEARCH_NO_MOVE when none
+    double value[N_PLAYERS]; // max-n: by seat, paranoid: value[0]
+} SearchEntry;
+
+typedef struct {
+    SearchConfig config;
+    HugeRegion region;
+    SearchEntry* table;
+    size_t mask;
+    uint16_t generation; // bumped per search, older entries are misses
+    int root;
+    double lower; // paranoid leaf clamp
+    double upper;
+    uint64_t deadline_ns;
+    bool can_stop; // false during the first iteration, which always finishes
+    bool stopped;
+    bool horizon; // a leaf of this iteration was cut off by depth rather than the end of the leg
+    SearchStats stats;
+    bool has_odds; // odds of the position keyed by odds_rank and odds_specs
+    uint64_t odds_rank;
+    uint32_t odds_specs;
+    LegOdds odds;
+} Searcher;
+
+CAMELS_API extern _Thread_local Searcher* camels_searcher; // camels_bot_expectimax searches with it, rolls while unset
+
+CAMELS_API bool camels_searcher_init(Searcher* s, SearchConfig config);
+CAMELS_API void camels_searcher_free(Searcher* s);
+
+//////////////////////////////////// Tournament //////////////////////////////////////
+
+#define TOURNAMENT_MAX_ENTRANTS 8
+#define TOURNAMENT_BATCHES      16
+#define N_BUILTIN_ENTRANTS      3
+
+typedef struct {
+    const char* name;
+    Policy policy;
+} Entrant;
+
+typedef struct {
+    int threads; // 0 for one per online core
+    long deals;  // dice seeds, each played by every pair in every seating
+    uint64_t seed;
+    int n_entrants;
+    Entrant entrants[TOURNAMENT_MAX_ENTRANTS];
+} TournamentConfig;
+
+typedef struct {
+    long games;
+    double seconds;
+    double score[TOURNAMENT_MAX_ENTRANTS][TOURNAMENT_MAX_ENTRANTS]; // mean score of i against j
+    double elo[TOURNAMENT_MAX_ENTRANTS];
+    double elo_ci[TOURNAMENT_MAX_ENTRANTS]; // half width of the 95% interval
+} TournamentResult;
+
+CAMELS_API extern const Entrant camels_builtin_entrants[N_BUILTIN_ENTRANTS];
+
+CAMELS_API bool camels_tournament(TournamentConfig* config, TournamentResult* result);
+
+//////////////////////////////////// Position Encoding //////////////////////////////////////
+
+CAMELS_API bool camels_encode_game(Game* game, int to_move, char* buf, size_t size);
+CAMELS_API bool camels_decode_game(const char* s, Game* game, int* to_move);
+
+#endif // CAMELS_ENGINE_H
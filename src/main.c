@@ -1,567 +1,39 @@
-// #define DYNAMIC_ARRAY_IMPLEMENTATION
-// #include "da.h"
+// The terminal frontend of libcamels: the interactive game, the batch commands, distributed sweeps, the
+// shared memory server and the engine protocol. Everything here talks to the engine through engine.h
 
 #include <assert.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <netdb.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <poll.h>
+#include <pthread.h>
+#include <sched.h>
+#include <semaphore.h>
+#include <signal.h>
+#include <stdarg.h>
+#include <stdatomic.h>
 #include <stdbool.h>
+#include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <sys/wait.h>
 #include <time.h>
+#include <unistd.h>
 
-/*
-TODO:
-- make tickets a stack as well (its literly a stack of cards)
-- convert Orientation to bool
-- break main and get_user_input into smaller functions
-*/
-
-#define DEBUG(fmt, ...) fprintf(stderr, "DEBUG %s %d " fmt "\n", __FILE__, __LINE__, ##__VA_ARGS__)
-#define LOG(fmt, ...)   fprintf(stderr, "LOG %s %d " fmt "\n", __FILE__, __LINE__, ##__VA_ARGS__)
-
-#define BOARD_SIZE    17 // 16 for real game 17th is for winning camels
-#define N_PLAYERS     6  // number of players
-#define N_DICE        5  // number of dice per round - one less than total dice
-#define N_BETS_COLORS 5  // 1 per regular camel color
-#define N_TICKETS     4  // 5,3,2,2
-#define N_CAMELS      7  // reg + 2 crazy
-#define MAX_WAGERS    N_PLAYERS* N_BETS_COLORS
-
-typedef enum { BRED, BBLUE, BYELLOW, BGREEN, BPURPLE } BetColor;
-typedef enum { CRED, CBLUE, CYELLOW, CGREEN, CPURPLE, CWHITE, CBLACK } CamelColor;
-typedef enum { DRED, DBLUE, DYELLOW, DGREEN, DPURPLE, DGREY } DiceColor;
-typedef enum { FORWARD, REVERSE } Orientation;
-typedef enum { WAGER, ROLL, TICKET, SPECTATOR } TurnType;
-
-const char* orient2char(Orientation oreint) {
-    if (oreint == FORWARD) {
-        return "+";
-    }
-    return "-";
-}
-
-const char* enum2char(CamelColor color) {
-    switch (color) {
-        case CRED:
-            return "R";
-        case CBLUE:
-            return "B";
-        case CYELLOW:
-            return "Y";
-        case CGREEN:
-            return "G";
-        case CPURPLE:
-            return "P";
-        case CBLACK:
-            return "K";
-        case CWHITE:
-            return "W";
-        default:
-            return NULL;
-    }
-}
-
-typedef struct {
-    size_t count;
-    size_t capacity;
-    int* items;
-} Locations;
-
-typedef struct {
-    TurnType turn_type;
-    Orientation orientation; // For Wager:  FORWARD == winner, REVERSE == LOOSER
-    BetColor color;          // for wafer and ticket
-    int position;            // Spectator position
-} Turn;
-
-typedef struct {
-    CamelColor color;
-    int value; // 1, 2, 3
-} Roll;
-
-typedef struct {
-    size_t count;
-    size_t capacity;
-    Roll items[N_DICE];
-} Dice;
-
-typedef struct {
-    int player;
-    BetColor color;
-} Wager;
-
-typedef struct {
-    size_t count;
-    size_t capacity;
-    Wager items[MAX_WAGERS];
-} WagerStack;
-
-typedef struct {
-    BetColor color;
-    int amount;    // 5, 3, 2, 2
-    int player_id; // -1 if available >=0 refers to player holding the ticket
-} Ticket;
-
-typedef struct {
-    size_t count;
-    size_t capacity;
-    Ticket items[N_TICKETS];
-} TicketStack;
-
-typedef struct {
-    CamelColor color;
-    Orientation orientation;
-    int space; // space the camel is on - NOT NEEDED
-} Camel;
-
-typedef struct {
-    size_t count;
-    size_t capacity;
-    Camel items[N_CAMELS];
-} CamelStack;
-
-typedef struct {
-    int player;              // who placed spec
-    Orientation orientation; // +1 or -1
-} Spectator;
-
-typedef struct {
-    Spectator spec; // spec card on spot
-    bool has_spec;  // spec card on spot?
-    CamelStack camel_stack;
-} Tile;
-
-typedef struct {
-    BetColor color;
-    bool used;
-} Hand;
-
-typedef struct {
-    int id;
-    int points;
-    bool used_spec;
-    Hand hand[N_BETS_COLORS]; // the color cards you have left to bet for dinner or loser
-} Player;
-
-typedef struct {
-    bool winner;
-    int turn;
-    int round;
-    Dice dice;
-    Tile board[BOARD_SIZE]; // array of tiles each tile can either be a stack of camels or a spec - add one for
-                            // winnner spot
-    Player players[N_PLAYERS];
-    TicketStack tickets[N_BETS_COLORS];
-    WagerStack winner_bets; // stacks
-    WagerStack loser_bets;  // stacks
-} Game;
-
-//////////////////////////////////// Stack //////////////////////////////////////
-#define stack_push(s, i) (((s)->count < (s)->capacity) ? ((s)->items[(s)->count++] = (i), true) : false)
-#define stack_pop(s, i)  ((s)->count > 0 ? * i = (s)->items[--(s)->count], (true) : (false))
-#define stack_empty(s)   ((s)->count == 0 ? true : false)
-#define stack_peak(s)    ((s)->items[(s)->count - 1])
-#define stack_count(s)   ((s)->count)
+#include "engine.h"
 
 int compare(const void* p1, const void* p2) {
     Player* e1 = (Player*) p1;
     Player* e2 = (Player*) p2;
     return e1->points - e2->points;
 }
-//////////////////////////////////// Game State //////////////////////////////////////
-
-int hand_size(Player* player) {
-    int c = 0;
-    for (size_t i = 0; i < N_BETS_COLORS; i++) {
-        if (player->hand[i].used == false) {
-            c++;
-        }
-    }
-    return c;
-}
-
-bool remove_card_from_hand(Player* player, BetColor color) {
-    for (size_t i = 0; i < N_BETS_COLORS; i++) {
-        if (player->hand[i].color == color) {
-            if (player->hand[i].used == true) {
-                return false;
-            }
-            player->hand[i].used = true;
-            return true;
-        }
-    }
-    return false;
-}
-
-void init_player_hand(Player* player) {
-    player->hand[0] = (Hand) {BRED, false};
-    player->hand[1] = (Hand) {BBLUE, false};
-    player->hand[2] = (Hand) {BYELLOW, false};
-    player->hand[3] = (Hand) {BGREEN, false};
-    player->hand[4] = (Hand) {BPURPLE, false};
-}
-
-bool has_card_in_hand(Player* player, BetColor color) {
-    for (size_t i = 0; i < N_BETS_COLORS; i++) {
-        if (player->hand[i].color == color) {
-            return !player->hand[i].used;
-        }
-    }
-    return false;
-}
-
-int rand_range(int low, int high) { return (rand() % (high - low + 1)) + low; }
-
-void reset_tickets(Game* game) {
-
-    for (int i = 0; i < N_BETS_COLORS; i++) {
-        BetColor color         = (BetColor) i;
-        game->tickets[i].count = 0; // ← Reset count
-        for (int j = 0; j < N_TICKETS; j++) {
-            int amount;
-            if (j == 0) {
-                amount = 5;
-            } else if (j == 1) {
-                amount = 3;
-            } else {
-                amount = 2;
-            }
-
-            Ticket t = {.amount = amount, .color = color, .player_id = -1};
-            stack_push(&game->tickets[i], t);
-        }
-    }
-}
-
-void reset_dice(Game* game) {
-    Dice dice     = {0};
-    dice.capacity = N_DICE;
-    game->dice    = dice;
-}
-
-void init_game(Game* game) {
-    game->turn = 0;
-    reset_dice(game);
-    game->winner = false;
-
-    ///// set up board /////////
-    for (int i = 0; i < BOARD_SIZE; i++) {
-        CamelStack cs              = {0};
-        cs.capacity                = N_CAMELS;
-        game->board[i].camel_stack = cs;
-        game->board[i].has_spec    = false;
-    }
-
-    ///// Place camels on board /////////
-    for (int c = 0; c < N_CAMELS; c++) {
-        int starting_tile = rand_range(0, 2);
-        Camel camel       = {0};
-        camel.color       = (CamelColor) c;
-        camel.orientation = FORWARD;
-
-        if ((CamelColor) c == CBLACK || (CamelColor) c == CWHITE) {
-            starting_tile     = BOARD_SIZE - starting_tile - 2;
-            camel.orientation = REVERSE;
-        }
-        camel.space   = starting_tile;
-        CamelStack* s = &game->board[starting_tile].camel_stack;
-        stack_push(s, camel);
-    }
-
-    ///// Players /////////
-    for (int i = 0; i < N_PLAYERS; i++) {
-        Player p         = {.id        = i,
-                            .points    = 0,
-                            .used_spec = false,
-                            .hand      = {{BRED, false}, {BBLUE, false}, {BYELLOW, false}, {BGREEN, false}, {BPURPLE, false}}};
-        game->players[i] = p;
-    }
-    for (int i = 0; i < N_BETS_COLORS; i++) {
-        game->tickets[i].capacity = N_TICKETS;
-        game->tickets[i].count    = 0;
-    }
-    reset_tickets(game);
-
-    ///// Wagers /////////
-    WagerStack losing_bets = {0};
-    losing_bets.capacity   = MAX_WAGERS;
-    game->loser_bets       = losing_bets;
-
-    WagerStack winning_bets = {0};
-    winning_bets.capacity   = MAX_WAGERS;
-    game->winner_bets       = winning_bets;
-}
-
-void score_wagers(Game* game, BetColor first, BetColor last) {
-    int scores[5] = {8, 5, 3, 2, 1}; // Points for 1st, 2nd, 3rd, 4th, 5th+ correct wagers
-                                     // Process Winner Bets FIFO
-    int winner_idx = 0;
-    for (size_t i = 0; i < game->winner_bets.count; i++) {
-        Wager w = game->winner_bets.items[i];
-        if (w.color == first) {
-            // Use the score corresponding to their order, floor at 1 point
-            int points = (winner_idx < 5) ? scores[winner_idx] : 1;
-            game->players[w.player].points += points;
-            winner_idx++;
-        } else {
-            game->players[w.player].points--;
-        }
-    }
-
-    // Process Loser Bets FIFO
-    int loser_idx = 0;
-    for (size_t i = 0; i < game->loser_bets.count; i++) {
-        Wager w = game->loser_bets.items[i];
-        if (w.color == last) {
-            int points = (loser_idx < 5) ? scores[loser_idx] : 1;
-            game->players[w.player].points += points;
-            loser_idx++;
-        } else {
-            game->players[w.player].points--;
-        }
-    }
-    // resset for testing
-    game->winner_bets.count = 0; //
-    game->loser_bets.count  = 0; //
-}
-
-void assign_points(Game* game, CamelColor top, CamelColor second) {
-
-    // assign points to anyone holding a winning color ticket
-    for (int i = 0; i < N_BETS_COLORS; i++) {
-        for (int j = 0; j < N_TICKETS; j++) {
-            Ticket t = game->tickets[i].items[j];
-            if (t.player_id != -1) {
-                if (i == (int) top) {
-                    game->players[t.player_id].points += t.amount; // give points to winner
-                } else if (i == (int) second) {
-                    game->players[t.player_id].points++; // give 1 point for second
-                } else {
-                    game->players[t.player_id].points--; // minus 1 point for 3rd or worse
-                }
-            }
-        }
-    }
-}
-
-int get_last_camel(Game* game) {
-    int last = -1;
-    for (int b = 0; b < BOARD_SIZE - 1; b++) {
-        CamelStack* stack = &game->board[b].camel_stack;
-        for (size_t j = 0; j < stack_count(stack); j++) {
-            CamelColor bottom = stack->items[j].color;
-            if (bottom != CBLACK && bottom != CWHITE) {
-                last = (int) j;
-            }
-        }
-    }
-    return last;
-}
-
-void get_top_camels(Game* game, int* first, int* second) {
-
-    // get top_camel and second place dont count black and white camel
-    *first  = -1;
-    *second = -1;
-
-    for (size_t b = BOARD_SIZE - 1; b > 0; b--) {
-        CamelStack* stack = &game->board[b].camel_stack;
-        for (size_t j = stack_count(stack); j > 0; j--) {
-            CamelColor top = stack->items[j - 1].color;
-            if (top != CBLACK && top != CWHITE) {
-                if (*first == -1) {
-                    *first = (int) top;
-                } else {
-                    *second = (int) top;
-                    return;
-                }
-            }
-        }
-    }
-}
-
-void score_round(Game* game, int* first, int* second) {
-    get_top_camels(game, first, second);
-    assign_points(game, (CamelColor) *first, (CamelColor) *second);
-
-    if (game->winner) {
-        int last = get_last_camel(game);
-        assert(last != -1 && "Could not get losing camel");
-        score_wagers(game, (BetColor) *first, (BetColor) last);
-    }
-}
-
-void end_round(Game* game) {
-    game->round++;
-    reset_dice(game);
-
-    // remove spec cards
-    for (int i = 0; i < N_PLAYERS; i++) {
-        game->players[i].used_spec = false;
-    }
-
-    for (int i = 0; i < BOARD_SIZE; i++) {
-        game->board[i].has_spec = false;
-    }
-    reset_tickets(game);
-}
-
-//////////////////////////////////// Turn //////////////////////////////////////
-
-// -1 if ticket is not available, else the amount
-int assign_ticket(Game* game, BetColor color, int player_id) {
-
-    TicketStack* tickets = &game->tickets[(int) color];
-
-    int available = -1;
-
-    for (int i = 0; i < N_TICKETS; i++) {
-        if (tickets->items[i].player_id == -1) {
-            available                   = tickets->items[i].amount;
-            tickets->items[i].player_id = player_id;
-            return available;
-        }
-    }
-    return available;
-}
-
-void get_available_tickets(Game* game, TicketStack* tickets) {
-    for (int i = 0; i < N_BETS_COLORS; i++) {
-        for (int j = 0; j < N_TICKETS; j++) {
-            if (game->tickets[i].items[j].player_id == -1) {
-                stack_push(tickets, game->tickets[i].items[i]);
-            }
-        }
-    }
-}
-
-void get_possible_spec_location(Game* game, Locations* buff) {
-    for (int i = 0; i < BOARD_SIZE - 1; i++) { // cant put peice on last spot
-        if (!(stack_count((&game->board[i].camel_stack)) > 0 || game->board[i].has_spec ||
-              (i != BOARD_SIZE && game->board[i + 1].has_spec) || (i != 0 && game->board[i - 1].has_spec))) {
-            stack_push(buff, i);
-        }
-    }
-}
-
-bool place_spec_tile(Game* game, int player_id, int space, Spectator spec) {
-
-    if (game->players[player_id].used_spec) {
-        return false;
-    }
-
-    // check if spec next to tile or on tile
-    if (stack_count((&game->board[space].camel_stack)) > 0 || game->board[space].has_spec ||
-        (space != BOARD_SIZE && game->board[space + 1].has_spec) || (space != 0 && game->board[space - 1].has_spec)) {
-        return false;
-    }
-    game->board[space].has_spec = true;
-    game->board[space].spec     = spec;
-    return true;
-}
-
-void roll_dice(Game* game) {
-    Roll die = {0};
-
-    int random_int = rand() % (N_DICE + 1);
-
-    // Cast the random integer to the enum type
-    DiceColor random_color = (DiceColor) random_int;
-    if (random_color == DGREY) {
-        // if Grey randomly select 0 or 1 for black or white
-        die.color = (CamelColor) ((rand() % 2) + N_BETS_COLORS);
-        die.value = rand_range(1, 3) * -1;
-
-    } else {
-        die.color = (CamelColor) random_color;
-        die.value = rand_range(1, 3);
-    }
-
-    stack_push(&game->dice, die);
-}
-
-Camel* get_camel(Game* game, CamelColor color) {
-
-    for (int i = 0; i < BOARD_SIZE; i++) {
-        CamelStack* stack = &game->board[i].camel_stack;
-        for (size_t j = 0; j < stack_count(stack); j++) {
-            if (stack->items[j].color == color) {
-                return &stack->items[j];
-            }
-        }
-    }
-    return NULL;
-}
-
-void move_camel(Game* game, CamelColor color, int spaces) {
-    int dest;
-    Camel* camel = get_camel(game, color);
-    assert(camel != NULL && "Could not find your camel");
-    int curr_space = camel->space;
-
-    Orientation move_orientation = camel->orientation;
-
-    if (game->board[curr_space + spaces].has_spec) {
-        Spectator spec = game->board[curr_space + spaces].spec;
-
-        move_orientation = spec.orientation;
-
-        game->players[spec.player].points++;          // Give point to player who placed spec
-        if (spec.orientation == camel->orientation) { // forward and +1 or reverse and -1
-            spaces++;
-        } else {
-            spaces--;
-        }
-    }
-    dest = curr_space + spaces;
-
-    if (dest < 0)
-        dest = 0;
-
-    if (dest >= BOARD_SIZE - 1) {
-        game->winner = true;
-        dest         = BOARD_SIZE - 1;
-    }
-
-    // move all camels in stack to dest
-    CamelStack tmp   = {0};
-    tmp.capacity     = N_CAMELS;
-    CamelStack tmp2  = {0}; // only used if going backwards
-    tmp2.capacity    = N_CAMELS;
-    Camel curr_camel = {0};
-
-    CamelStack* stack      = &game->board[curr_space].camel_stack;
-    CamelStack* dest_stack = &game->board[dest].camel_stack;
-
-    bool match_found = false;
-    while (!match_found && stack->count > 0) { // pop from start stack until we reach desired camel
-        stack_pop(stack, &curr_camel);
-        match_found = curr_camel.color == color ? true : false;
-        stack_push(&tmp, curr_camel);
-    }
-
-    // if camels are going in reverse, pop the dest stack into a tmp stack, then push start stack into dest and then
-    // push dest stack
-    if (move_orientation == REVERSE) {
-        while (!stack_empty(dest_stack)) {
-            stack_pop(dest_stack, &curr_camel);
-            stack_push(&tmp2, curr_camel);
-        }
-    }
-
-    while (!stack_empty(&tmp)) {
-        stack_pop(&tmp, &curr_camel);
-        // printf("pushed: %s ", enum2char(curr_camel.color));
-        curr_camel.space = dest;
-        stack_push(dest_stack, curr_camel);
-    }
-
-    if (move_orientation == REVERSE) {
-        while (!stack_empty(&tmp2)) {
-            stack_pop(&tmp2, &curr_camel);
-            curr_camel.space = dest;
-            stack_push(dest_stack, curr_camel);
-        }
-    }
-}
 
 //////////////////////////////////// I/O //////////////////////////////////////
 void clear_input_buffer(void) {
@@ -585,9 +57,23 @@ int read_int(void) {
     clear_input_buffer();
     return input;
 }
+// last prompt shown, a redraw from the pondering thread puts it back under the board
+char prompt_line[160];
+
+void prompt(const char* fmt, ...) {
+    va_list args;
+    va_start(args, fmt);
+    flockfile(stdout);
+    vsnprintf(prompt_line, sizeof(prompt_line), fmt, args);
+    fputs(prompt_line, stdout);
+    fflush(stdout);
+    funlockfile(stdout);
+    va_end(args);
+}
+
 // TODO break into smaller functions
 void get_user_input(Game* game, int player_id, Turn* turn) {
-    printf("Player %d turn: [R]oll, [W]ager, Take a [T]icket or Place [S]pectator\n", player_id);
+    prompt("Player %d turn: [R]oll, [W]ager, Take a [T]icket or Place [S]pectator\n", player_id);
     char input_char = read_char();
     switch (input_char) {
         case 'R': {
@@ -596,7 +82,7 @@ void get_user_input(Game* game, int player_id, Turn* turn) {
         };
         case 'W': {
             turn->turn_type = WAGER;
-            printf("[W]inner or [L]oser\n");
+            prompt("[W]inner or [L]oser\n");
             input_char = read_char();
             switch (input_char) {
                 case 'W': {
@@ -613,7 +99,7 @@ void get_user_input(Game* game, int player_id, Turn* turn) {
                 }
             }
 
-            printf("Select a Camel to wager on: [R]ED, [B]LUE, [Y]ELLOW, [G]REEN, [P]URPLE\n");
+            prompt("Select a Camel to wager on: [R]ED, [B]LUE, [Y]ELLOW, [G]REEN, [P]URPLE\n");
             input_char = read_char();
             switch (input_char) {
                 case 'R': {
@@ -645,7 +131,7 @@ void get_user_input(Game* game, int player_id, Turn* turn) {
 
         case 'T': {
             turn->turn_type = TICKET;
-            printf("Select ticket [R]ED, [B]LUE, [Y]ELLOW, [G]REEN, [P]URPLE\n");
+            prompt("Select ticket [R]ED, [B]LUE, [Y]ELLOW, [G]REEN, [P]URPLE\n");
             input_char = read_char();
             switch (input_char) {
                 case 'R': {
@@ -678,10 +164,10 @@ void get_user_input(Game* game, int player_id, Turn* turn) {
             turn->turn_type = SPECTATOR;
             // int* buff = NULL;
             // get_possible_spec_location(game, buff); // TODO check that this is a valid spot
-            printf("Pick a location to place the Spectator tile:\n");
+            prompt("Pick a location to place the Spectator tile:\n");
             int pos        = read_int();
             turn->position = pos;
-            printf("[+]1 or [-]1\n");
+            prompt("[+]1 or [-]1\n");
             input_char = read_char();
             switch (input_char) {
                 case '+': {
@@ -713,13 +199,15 @@ void clear_screen(void) {
     printf("\033[2J\033[1;1H");
 }
 
+void render_ponder(Game* game); // Pondering
+
 void render_horizontal(Game* game) {
     clear_screen();
     printf("Round: %d | Turn %d\n", game->round, game->turn);
     // render wagers
     printf("Wagers\n");
-    printf("W: [%zu] ", game->winner_bets.count);
-    printf("L: [%zu] ", game->loser_bets.count);
+    printf("W: [%d] ", game->winner_bets.count);
+    printf("L: [%d] ", game->loser_bets.count);
 
     // render tickets
     printf("\nTickets\n");
@@ -745,7 +233,7 @@ void render_horizontal(Game* game) {
         for (int j = 0; j < N_BETS_COLORS; j++) {
             for (size_t k = 0; k < stack_count(&game->tickets[j]); k++) {
                 if (game->tickets[j].items[k].player_id == i) {
-                    printf(" [%s:%d] ", enum2char((CamelColor) game->tickets[j].items[k].color),
+                    printf(" [%s:%d] ", enum2char((CamelColor) j),
                            game->tickets[j].items[k].amount);
                 }
             }
@@ -782,6 +270,7 @@ void render_horizontal(Game* game) {
         printf(" %2zu ", j);
     }
     printf("\n");
+    render_ponder(game);
     if (game->winner) {
         printf("\nGame Over!:\n");
         printf("Pos\tPlayer\tScore\n");
@@ -791,107 +280,1172 @@ void render_horizontal(Game* game) {
     }
 }
 
-bool next_turn(Game* game, Turn* turn, int curr_player_id) {
 
-    // get next players input
-    switch (turn->turn_type) {
-        case WAGER: {
-            LOG("Turn %d: %d made wagered %s to %s \n", game->turn, curr_player_id, enum2char((CamelColor) turn->color),
-                orient2char(turn->orientation));
+void render_tablebase(const Tablebase* tb, Game* game) {
+    double p[2][N_BETS_COLORS];
+    if (!camels_tablebase_odds(tb, game, p[0], p[1])) {
+        return;
+    }
+    const char* groups[2] = {"Race", "Last"};
+    for (int g = 0; g < 2; g++) {
+        printf("%-4s ", groups[g]);
+        for (int c = 0; c < N_BETS_COLORS; c++) {
+            printf(" %s:%3.0f%% ", enum2char((CamelColor) c), 100.0 * p[g][c]);
+        }
+        printf("\n");
+    }
+}
+
+
+void render_eval(const Evaluator* ev, Game* game) {
+    float out[N_EVAL_OUTPUTS];
+    camels_eval_game(ev, game, out);
+    const char* groups[3] = {"Leg", "Race", "Last"};
+    for (int g = 0; g < 3; g++) {
+        printf("%-4s ", groups[g]);
+        for (int c = 0; c < N_BETS_COLORS; c++) {
+            printf(" %s:%3.0f%% ", enum2char((CamelColor) c), 100.0 * (double) out[g * N_BETS_COLORS + c]);
+        }
+        printf("\n");
+    }
+}
+
+
+Ponder* ponder = NULL; // render_horizontal shows its results when set
+
+void render_ponder(Game* game) {
+    PonderResult r;
+    if (ponder == NULL || !camels_ponder_result(ponder, &r) || r.turn != game->turn || r.round != game->round) {
+        return;
+    }
+    printf("\nLeg odds (%s):", r.depth == PONDER_APPROX ? "approx" : "exact");
+    for (int c = 0; c < N_BETS_COLORS; c++) {
+        printf(" %s %3.0f%%", enum2char((CamelColor) c), 100.0 * r.odds.first[c]);
+    }
+    printf("\nTicket EV:");
+    for (int c = 0; c < N_BETS_COLORS; c++) {
+        if (r.has_ticket[c]) {
+            printf(" %s %+.2f", enum2char((CamelColor) c), r.ticket_ev[c]);
+        }
+    }
+    printf("\nHint for player %d: ", r.player_id);
+    switch (r.hint.turn_type) {
+        case TICKET:
+            printf("take the %s ticket", enum2char((CamelColor) r.hint.color));
+            break;
+        case WAGER:
+            printf("wager %s to %s", enum2char((CamelColor) r.hint.color),
+                   r.hint.orientation == FORWARD ? "win" : "lose");
+            break;
+        case ROLL:
+        case SPECTATOR:
+        default:
+            printf("roll");
+            break;
+    }
+    printf(" (EV %+.2f%s)\n", r.hint_ev, r.depth == PONDER_DONE ? "" : ", still thinking");
+}
+
+
+//////////////////////////////////// Distributed Sweeps //////////////////////////////////////
+// Playout sweeps split across worker processes. The coordinator cuts samples [0, samples) into shards of
+// DIST_SHARD and hands one at a time to each worker over a Unix socket ("unix:<path>", or any address with a
+// '/') or TCP ("host:port"). Sample i always plays from its own stream seeded by (seed, i) and histograms are
+// plain counts, so the merged result is the same whatever the number of workers or who played which shard.
+// A worker that disconnects, or sits on a shard past its deadline, is dropped and its shard goes back to the
+// queue, and while no worker is connected the coordinator plays pending shards itself. Positions travel as
+// raw Game structs, so both ends must be the same build: the handshake checks the protocol version and
+// sizeof(Game)
+
+#define DIST_MAGIC       0x444C4D43u // "CMLD"
+#define DIST_VERSION     1
+#define DIST_SHARD       4096
+#define DIST_MAX_WORKERS 64
+#define DIST_IDLE_MS     1000  // with no worker connected for this long the coordinator plays a shard
+#define DIST_SHARD_MS    60000 // default deadline for a worker to answer one shard
+
+
+typedef struct {
+    const char* address;
+    int local_workers; // worker processes forked here, more may connect from other machines
+    int crash_after;   // testing: local worker 0 drops its connection mid-shard after this many shards, 0 never
+    int hang_after;    // testing: local worker 0 stops answering, still connected, after this many shards, 0 never
+    int shard_ms;      // deadline for one shard, DIST_SHARD_MS when 0
+} DistConfig;
+
+typedef struct {
+    int workers;      // connections accepted
+    int shards;
+    int shards_lost;  // handed out again after their worker disconnected or passed the deadline
+    int shards_late;  // of those, the ones whose worker passed the deadline
+    int shards_local; // played by the coordinator while no worker was connected
+    double seconds;
+} DistResult;
+
+typedef enum { MSG_HELLO, MSG_SHARD, MSG_RESULT, MSG_DONE } DistMessage;
+
+typedef struct {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t game_size;
+    uint32_t type;  // DistMessage
+    uint64_t shard;
+    uint64_t begin; // MSG_SHARD: samples [begin, begin + count), followed by the SweepJob
+    uint64_t count;
+} DistHeader;
+
+typedef union {
+    SweepJob job;        // MSG_SHARD
+    SweepHistogram hist; // MSG_RESULT
+} DistPayload;
+
+bool write_full(int fd, const void* buf, size_t n) {
+    const uint8_t* p = buf;
+    while (n > 0) {
+        ssize_t sent = send(fd, p, n, MSG_NOSIGNAL); // a dead peer is an error, not a SIGPIPE
+        if (sent <= 0) {
+            return false;
+        }
+        p += sent;
+        n -= (size_t) sent;
+    }
+    return true;
+}
+
+bool read_full(int fd, void* buf, size_t n) {
+    uint8_t* p = buf;
+    while (n > 0) {
+        ssize_t got = recv(fd, p, n, 0);
+        if (got <= 0) {
+            return false;
+        }
+        p += got;
+        n -= (size_t) got;
+    }
+    return true;
+}
+
+size_t dist_payload_size(uint32_t type) {
+    return type == MSG_SHARD ? sizeof(SweepJob) : type == MSG_RESULT ? sizeof(SweepHistogram) : 0;
+}
+
+bool dist_send(int fd, DistMessage type, uint64_t shard, uint64_t begin, uint64_t count, const void* payload) {
+    DistHeader header = {.magic     = DIST_MAGIC,
+                         .version   = DIST_VERSION,
+                         .game_size = sizeof(Game),
+                         .type      = type,
+                         .shard     = shard,
+                         .begin     = begin,
+                         .count     = count};
+    return write_full(fd, &header, sizeof(header)) && write_full(fd, payload, dist_payload_size(type));
+}
+
+// reads one message, payload must hold the largest payload. False on a closed socket or a foreign peer
+bool dist_recv(int fd, DistHeader* header, DistPayload* payload) {
+    return read_full(fd, header, sizeof(DistHeader)) && header->magic == DIST_MAGIC &&
+           header->version == DIST_VERSION && header->game_size == sizeof(Game) && header->type <= MSG_DONE &&
+           read_full(fd, payload, dist_payload_size(header->type));
+}
+
+// resolves address into a socket, bound and listening or connected. Returns the fd or -1
+int dist_socket(const char* address, bool listening) {
+    if (strncmp(address, "unix:", 5) == 0 || strchr(address, '/') != NULL) {
+        const char* path        = strncmp(address, "unix:", 5) == 0 ? address + 5 : address;
+        struct sockaddr_un addr = {.sun_family = AF_UNIX};
+        if (strlen(path) >= sizeof(addr.sun_path)) {
+            return -1;
+        }
+        strcpy(addr.sun_path, path);
+        int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+        if (listening) {
+            unlink(path); // left over from a coordinator that did not shut down
+        }
+        if (fd >= 0 && (listening ? bind(fd, (struct sockaddr*) &addr, sizeof(addr)) == 0 && listen(fd, 16) == 0
+                                  : connect(fd, (struct sockaddr*) &addr, sizeof(addr)) == 0)) {
+            return fd;
+        }
+        if (fd >= 0) {
+            close(fd);
+        }
+        return -1;
+    }
+
+    char host[256];
+    const char* colon = strrchr(address, ':');
+    if (colon == NULL || (size_t) (colon - address) >= sizeof(host)) {
+        return -1;
+    }
+    memcpy(host, address, (size_t) (colon - address));
+    host[colon - address]  = '\0';
+    struct addrinfo hints  = {.ai_family = AF_UNSPEC, .ai_socktype = SOCK_STREAM, .ai_flags = listening ? AI_PASSIVE : 0};
+    struct addrinfo* found = NULL;
+    if (getaddrinfo(host[0] != '\0' ? host : NULL, colon + 1, &hints, &found) != 0) {
+        return -1;
+    }
+    int fd = -1;
+    for (struct addrinfo* a = found; a != NULL && fd < 0; a = a->ai_next) {
+        fd = socket(a->ai_family, a->ai_socktype, a->ai_protocol);
+        if (fd < 0) {
+            continue;
+        }
+        int one = 1;
+        setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+        if (listening) {
+            setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+        }
+        if (!(listening ? bind(fd, a->ai_addr, a->ai_addrlen) == 0 && listen(fd, 16) == 0
+                        : connect(fd, a->ai_addr, a->ai_addrlen) == 0)) {
+            close(fd);
+            fd = -1;
+        }
+    }
+    freeaddrinfo(found);
+    return fd;
+}
+
+// serves shards on a connected socket until the coordinator is done or gone. With crash_after > 0 it
+// walks away holding its next shard once it has answered that many, with hang_after > 0 it keeps the
+// connection but never answers again
+bool dist_serve(int fd, int crash_after, int hang_after) {
+    static DistPayload payload;
+    SweepHistogram hist;
+    DistHeader header;
+    bool ok = dist_send(fd, MSG_HELLO, 0, 0, 0, NULL);
+    for (int served = 0; ok; served++) {
+        if (!dist_recv(fd, &header, &payload) || header.type == MSG_DONE) {
+            break;
+        }
+        if (header.type != MSG_SHARD || (crash_after > 0 && served == crash_after)) {
+            ok = false;
+            break;
+        }
+        if (hang_after > 0 && served == hang_after) {
+            uint8_t byte;
+            while (recv(fd, &byte, 1, 0) > 0) {
+            } // until the coordinator gives up on us
+            ok = false;
+            break;
+        }
+        memset(&hist, 0, sizeof(hist));
+        camels_sweep_range(&payload.job, header.begin, header.count, &hist);
+        ok = dist_send(fd, MSG_RESULT, header.shard, header.begin, header.count, &hist);
+    }
+    close(fd);
+    return ok;
+}
+
+// worker process: connects to the coordinator at address and plays whatever it is handed
+bool dist_worker(const char* address) {
+    int fd = dist_socket(address, false);
+    return fd >= 0 && dist_serve(fd, 0, 0);
+}
 
-            if (!remove_card_from_hand(&game->players[curr_player_id], turn->color)) {
-                return false;
+typedef enum { SHARD_PENDING, SHARD_ASSIGNED, SHARD_DONE } ShardState;
+
+typedef struct {
+    int fd;
+    int shard;         // -1 while idle
+    bool dead;         // a send failed, dropped on the next pass
+    uint64_t deadline; // now_ns() by which shard must be answered
+} DistPeer;
+
+uint64_t shard_count(const SweepJob* job, int shard) {
+    uint64_t begin = (uint64_t) shard * DIST_SHARD;
+    return job->samples - begin < DIST_SHARD ? job->samples - begin : DIST_SHARD;
+}
+
+// runs job across every worker that connects to config->address and merges their histograms into out.
+// Returns false when the address cannot be served
+bool dist_sweep(const SweepJob* job, const DistConfig* config, SweepHistogram* out, DistResult* result) {
+    int listener = dist_socket(config->address, true);
+    if (listener < 0) {
+        return false;
+    }
+    struct sockaddr_storage self;
+    socklen_t self_len = sizeof(self);
+    getsockname(listener, (struct sockaddr*) &self, &self_len); // TCP port 0 picks a free port
+
+    uint64_t start = now_ns();
+    *result        = (DistResult) {.shards = (int) ((job->samples + DIST_SHARD - 1) / DIST_SHARD)};
+    int n_shards   = result->shards;
+    uint8_t* state = calloc((size_t) n_shards + 1, 1);
+    assert(state != NULL && "Out of memory");
+
+    pid_t children[DIST_MAX_WORKERS];
+    int n_children = 0;
+    fflush(NULL); // children leave with _exit, they must not inherit half-written buffers
+    for (int w = 0; w < config->local_workers && w < DIST_MAX_WORKERS; w++) {
+        pid_t pid = fork();
+        if (pid == 0) {
+            close(listener);
+            int fd  = socket(self.ss_family, SOCK_STREAM, 0);
+            bool ok = fd >= 0 && connect(fd, (struct sockaddr*) &self, self_len) == 0 &&
+                      dist_serve(fd, w == 0 ? config->crash_after : 0, w == 0 ? config->hang_after : 0);
+            _exit(ok ? 0 : 1);
+        }
+        if (pid > 0) {
+            children[n_children++] = pid;
+        }
+    }
+
+    memset(out, 0, sizeof(*out));
+    uint64_t shard_ns = (uint64_t) (config->shard_ms > 0 ? config->shard_ms : DIST_SHARD_MS) * 1000000;
+    static DistPayload payload;
+    DistHeader header;
+    DistPeer peers[DIST_MAX_WORKERS];
+    int n_peers = 0, n_done = 0, next = 0; // shards before next are all assigned or done
+    while (n_done < n_shards) {
+        for (int i = 0; i < n_peers; i++) {
+            while (next < n_shards && state[next] != SHARD_PENDING) {
+                next++;
             }
+            if (peers[i].shard < 0 && next < n_shards) {
+                state[next]   = SHARD_ASSIGNED;
+                peers[i].shard    = next;
+                peers[i].deadline = now_ns() + shard_ns;
+                peers[i].dead     = !dist_send(peers[i].fd, MSG_SHARD, (uint64_t) next, (uint64_t) next * DIST_SHARD,
+                                           shard_count(job, next), job);
+            }
+        }
 
-            Wager w = {.color = turn->color, .player = curr_player_id};
-            if (turn->orientation == FORWARD) {
-                stack_push(&game->winner_bets, w);
-            } else {
-                stack_push(&game->loser_bets, w);
+        struct pollfd fds[DIST_MAX_WORKERS + 1] = {{.fd = listener, .events = POLLIN}};
+        for (int i = 0; i < n_peers; i++) {
+            fds[i + 1] = (struct pollfd) {.fd = peers[i].fd, .events = POLLIN};
+        }
+        // wake for the earliest deadline, and never wait longer than DIST_IDLE_MS
+        uint64_t now = now_ns();
+        int timeout  = DIST_IDLE_MS;
+        for (int i = 0; i < n_peers; i++) {
+            if (peers[i].shard >= 0) {
+                uint64_t left = peers[i].deadline > now ? (peers[i].deadline - now) / 1000000 + 1 : 0;
+                timeout       = left < (uint64_t) timeout ? (int) left : timeout;
             }
+        }
+        if (poll(fds, (nfds_t) n_peers + 1, timeout) == 0 && n_peers == 0) {
+            // nobody to hand work to, play the next shard here. With no peers nothing is assigned
+            while (state[next] != SHARD_PENDING) {
+                next++;
+            }
+            SweepHistogram hist = {0};
+            camels_sweep_range(job, (uint64_t) next * DIST_SHARD, shard_count(job, next), &hist);
+            camels_sweep_merge(out, &hist);
+            state[next] = SHARD_DONE;
+            n_done++;
+            result->shards_local++;
+            continue;
+        }
 
-            break;
+        now = now_ns();
+        for (int i = n_peers - 1; i >= 0; i--) {
+            bool drop = peers[i].dead;
+            if (!drop && fds[i + 1].revents != 0) {
+                drop = !dist_recv(peers[i].fd, &header, &payload) || header.type != MSG_RESULT ||
+                       (int) header.shard != peers[i].shard;
+                if (!drop) {
+                    camels_sweep_merge(out, &payload.hist);
+                    state[peers[i].shard] = SHARD_DONE;
+                    n_done++;
+                    peers[i].shard = -1;
+                }
+            }
+            if (!drop && peers[i].shard >= 0 && now >= peers[i].deadline) {
+                // hung or far too slow: whatever it sends later is never read
+                drop = true;
+                result->shards_late++;
+            }
+            if (drop) {
+                // its shard goes back to the queue for whoever is free next
+                if (peers[i].shard >= 0) {
+                    state[peers[i].shard] = SHARD_PENDING;
+                    next                  = peers[i].shard < next ? peers[i].shard : next;
+                    result->shards_lost++;
+                }
+                close(peers[i].fd);
+                peers[i] = peers[--n_peers];
+            }
+        }
+
+        if (fds[0].revents & POLLIN) {
+            int fd = accept(listener, NULL, NULL);
+            if (fd >= 0 && n_peers < DIST_MAX_WORKERS && dist_recv(fd, &header, &payload) && header.type == MSG_HELLO) {
+                peers[n_peers++] = (DistPeer) {.fd = fd, .shard = -1};
+                result->workers++;
+            } else if (fd >= 0) {
+                close(fd);
+            }
+        }
+    }
+
+    for (int i = 0; i < n_peers; i++) {
+        dist_send(peers[i].fd, MSG_DONE, 0, 0, 0, NULL);
+        close(peers[i].fd);
+    }
+    close(listener);
+    if (self.ss_family == AF_UNIX) {
+        unlink(((struct sockaddr_un*) &self)->sun_path);
+    }
+    for (int i = 0; i < n_children; i++) {
+        kill(children[i], SIGKILL); // every shard is in, a hung local worker must not hold up the return
+        waitpid(children[i], NULL, 0);
+    }
+    free(state);
+    result->seconds = (double) (now_ns() - start) / 1e9;
+    return true;
+}
+
+
+//////////////////////////////////// Shared Memory Queries //////////////////////////////////////
+// Odds and advice for services on the same host without a socket or text in between. The server maps a
+// file holding a ShmHeader and a ring of ShmSlots. A client claims a free slot, writes its Game straight
+// into it, marks it REQUEST and rings the doorbell; a server thread claims it, answers in place and posts
+// the slot's semaphore. Both semaphores live in the mapping (process shared, futex backed on Linux), so a
+// waiting side sleeps in the kernel instead of spinning. A client that gives up on a slot the server is
+// still working on marks it ABANDONED and the server frees it when done. Both ends must be the same build:
+// the header carries the layout version and sizeof(Game)
+
+#define SHM_MAGIC      "CMLSSHM1"
+#define SHM_VERSION    1
+#define SHM_SLOTS      256
+#define SHM_TIMEOUT_MS 2000
+
+typedef enum { SLOT_FREE, SLOT_CLAIMED, SLOT_REQUEST, SLOT_SERVING, SLOT_RESPONSE, SLOT_ABANDONED } ShmSlotState;
+
+typedef struct {
+    float first[N_BETS_COLORS];
+    float second[N_BETS_COLORS];
+    float last[N_BETS_COLORS];
+    float ticket_ev[N_BETS_COLORS]; // 0 where no ticket is left
+    Turn hint;                      // roll or the best ticket, wagers and spectators are not weighed
+    float hint_ev;
+} ShmAnswer;
+
+typedef struct {
+    _Alignas(64) _Atomic uint32_t state; // ShmSlotState, each slot on its own cache lines
+    uint32_t player_id;
+    uint32_t exact; // exact leg odds, approximate when 0
+    sem_t done;     // posted when the answer is in
+    Game game;
+    ShmAnswer answer;
+} ShmSlot;
+
+typedef struct {
+    char magic[8];
+    uint32_t version;
+    uint32_t game_size;
+    uint32_t slots;
+    _Atomic uint32_t stopping;
+    _Atomic uint32_t next_claim; // where the next client starts looking for a free slot
+    sem_t doorbell;              // one post per request
+    _Alignas(64) ShmSlot ring[];
+} ShmHeader;
+
+typedef struct {
+    ShmHeader* header;
+    size_t size;
+} ShmMap;
+
+typedef struct {
+    ShmMap map;
+    const char* path;
+    pthread_t* threads;
+    int n_threads;
+    atomic_ulong served;
+} ShmServer;
+
+bool shm_map(ShmMap* map, int fd, size_t size) {
+    void* p = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    map->header = p == MAP_FAILED ? NULL : p;
+    map->size   = size;
+    return map->header != NULL;
+}
+
+void shm_answer(Game* game, int player_id, bool exact, LegTracker* tracker, ShmAnswer* out) {
+    PonderResult r = {.depth = PONDER_EXACT, .player_id = player_id};
+    if (exact) {
+        camels_leg_tracker_odds(tracker, game, &r.odds);
+    } else {
+        camels_approx_leg_odds(game, &r.odds);
+    }
+    camels_ponder_moves(game, &r);
+    for (int c = 0; c < N_BETS_COLORS; c++) {
+        out->first[c]     = (float) r.odds.first[c];
+        out->second[c]    = (float) r.odds.second[c];
+        out->last[c]      = (float) r.odds.last[c];
+        out->ticket_ev[c] = r.has_ticket[c] ? (float) r.ticket_ev[c] : 0.0f;
+    }
+    out->hint    = r.hint;
+    out->hint_ev = (float) r.hint_ev;
+}
+
+void* shm_server_main(void* arg) {
+    ShmServer* server = arg;
+    ShmHeader* h      = server->map.header;
+    LegTracker tracker;
+    if (!camels_leg_tracker_init(&tracker, 16)) {
+        return NULL;
+    }
+    uint32_t cursor = 0;
+    while (true) {
+        while (sem_wait(&h->doorbell) != 0) {
         }
-        case ROLL: {
-            roll_dice(game);
-            Roll die = stack_peak(&game->dice);
-            LOG("Turn %d: %d rolled %s%d\n", game->turn, curr_player_id, enum2char((CamelColor) die.color), die.value);
-            move_camel(game, die.color, die.value);
-            game->players[curr_player_id].points++;
+        if (atomic_load(&h->stopping)) {
             break;
         }
-        case TICKET: {
-            int amount = assign_ticket(game, turn->color, curr_player_id);
-            if (amount == -1) {
-                LOG("Turn %d: Could not assign ticket to %d", game->turn, curr_player_id);
-                return false;
+        // claim any posted request, not necessarily the one that rang
+        for (uint32_t n = 0; n < h->slots; n++, cursor = (cursor + 1) % h->slots) {
+            ShmSlot* slot     = &h->ring[cursor];
+            uint32_t expected = SLOT_REQUEST;
+            if (!atomic_compare_exchange_strong(&slot->state, &expected, SLOT_SERVING)) {
+                continue;
+            }
+            shm_answer(&slot->game, (int) slot->player_id, slot->exact != 0, &tracker, &slot->answer);
+            atomic_fetch_add(&server->served, 1);
+            expected = SLOT_SERVING;
+            if (atomic_compare_exchange_strong(&slot->state, &expected, SLOT_RESPONSE)) {
+                sem_post(&slot->done);
+            } else {
+                atomic_store(&slot->state, SLOT_FREE); // the client gave up on it
             }
-            LOG("Turn %d: %d picked a %s:%d Ticket", game->turn, curr_player_id, enum2char((CamelColor) turn->color),
-                amount);
             break;
         }
+    }
+    camels_leg_tracker_free(&tracker);
+    return NULL;
+}
 
-        case SPECTATOR: {
-            Spectator spec = {.orientation = turn->orientation, .player = curr_player_id};
-            bool allowed   = place_spec_tile(game, curr_player_id, turn->position, spec);
-            if (!allowed) {
-                LOG("Turn %d: %d COULD NOT place Spectator card (%s1) on %d", game->turn, curr_player_id,
-                    orient2char(turn->orientation), turn->position);
-                return false;
+// creates the ring at path and starts threads to answer it (0 for one per online core)
+bool shm_server_start(ShmServer* server, const char* path, int threads) {
+    size_t size = sizeof(ShmHeader) + SHM_SLOTS * sizeof(ShmSlot);
+    int fd      = open(path, O_RDWR | O_CREAT | O_TRUNC, 0600);
+    memset(server, 0, sizeof(*server));
+    if (fd < 0 || ftruncate(fd, (off_t) size) != 0) {
+        if (fd >= 0) {
+            close(fd);
+        }
+        return false;
+    }
+    if (!shm_map(&server->map, fd, size)) {
+        return false;
+    }
+    ShmHeader* h = server->map.header;
+    h->version   = SHM_VERSION;
+    h->game_size = sizeof(Game);
+    h->slots     = SHM_SLOTS;
+    sem_init(&h->doorbell, 1, 0);
+    for (int s = 0; s < SHM_SLOTS; s++) {
+        atomic_init(&h->ring[s].state, SLOT_FREE);
+        sem_init(&h->ring[s].done, 1, 0);
+    }
+    atomic_thread_fence(memory_order_release);
+    memcpy(h->magic, SHM_MAGIC, sizeof(h->magic)); // last, clients check it before anything else
+
+    threads            = threads > 0 ? threads : (int) sysconf(_SC_NPROCESSORS_ONLN);
+    threads            = threads > 0 ? threads : 1;
+    server->path       = path;
+    server->threads    = calloc((size_t) threads, sizeof(pthread_t));
+    assert(server->threads != NULL && "Out of memory");
+    for (int t = 0; t < threads; t++) {
+        if (pthread_create(&server->threads[t], NULL, shm_server_main, server) == 0) {
+            server->n_threads++;
+        }
+    }
+    return server->n_threads > 0;
+}
+
+// stops the threads, requests still waiting are left unanswered, and removes the file
+void shm_server_stop(ShmServer* server) {
+    ShmHeader* h = server->map.header;
+    atomic_store(&h->stopping, 1);
+    for (int t = 0; t < server->n_threads; t++) {
+        sem_post(&h->doorbell);
+    }
+    for (int t = 0; t < server->n_threads; t++) {
+        pthread_join(server->threads[t], NULL);
+    }
+    free(server->threads);
+    munmap(h, server->map.size);
+    unlink(server->path);
+}
+
+bool shm_client_open(ShmMap* map, const char* path) {
+    int fd = open(path, O_RDWR);
+    struct stat st;
+    if (fd < 0 || fstat(fd, &st) != 0 || (size_t) st.st_size < sizeof(ShmHeader)) {
+        if (fd >= 0) {
+            close(fd);
+        }
+        return false;
+    }
+    if (!shm_map(map, fd, (size_t) st.st_size)) {
+        return false;
+    }
+    ShmHeader* h = map->header;
+    if (memcmp(h->magic, SHM_MAGIC, sizeof(h->magic)) != 0 || h->version != SHM_VERSION ||
+        h->game_size != sizeof(Game) || map->size < sizeof(ShmHeader) + h->slots * sizeof(ShmSlot)) {
+        munmap(h, map->size);
+        return false;
+    }
+    return true;
+}
+
+void shm_client_close(ShmMap* map) { munmap(map->header, map->size); }
+
+// a free slot for the caller to write its request into, spins while every slot is busy
+ShmSlot* shm_claim(ShmMap* map) {
+    ShmHeader* h = map->header;
+    while (true) {
+        uint32_t start = atomic_fetch_add(&h->next_claim, 1);
+        for (uint32_t n = 0; n < h->slots; n++) {
+            ShmSlot* slot     = &h->ring[(start + n) % h->slots];
+            uint32_t expected = SLOT_FREE;
+            if (atomic_compare_exchange_strong(&slot->state, &expected, SLOT_CLAIMED)) {
+                return slot;
             }
-            LOG("Turn %d: %d placed Spectator card (%s1) on %d", game->turn, curr_player_id,
-                orient2char(turn->orientation), turn->position);
-            break;
         }
+        sched_yield();
+    }
+}
+
+// hands a claimed slot to the server and waits for the answer in slot->answer. False when none came in
+// SHM_TIMEOUT_MS, the slot is gone then. Otherwise release it with shm_release once the answer is read
+bool shm_submit(ShmMap* map, ShmSlot* slot) {
+    atomic_store(&slot->state, SLOT_REQUEST);
+    sem_post(&map->header->doorbell);
+
+    struct timespec deadline;
+    clock_gettime(CLOCK_REALTIME, &deadline);
+    deadline.tv_sec += SHM_TIMEOUT_MS / 1000;
+    deadline.tv_nsec += (SHM_TIMEOUT_MS % 1000) * 1000000L;
+    if (deadline.tv_nsec >= 1000000000L) {
+        deadline.tv_sec++;
+        deadline.tv_nsec -= 1000000000L;
+    }
+    while (sem_timedwait(&slot->done, &deadline) != 0) {
+        if (errno != ETIMEDOUT) {
+            continue; // interrupted
+        }
+        uint32_t expected = SLOT_REQUEST;
+        if (atomic_compare_exchange_strong(&slot->state, &expected, SLOT_FREE)) {
+            return false; // never picked up, the doorbell post is swallowed by a server pass that finds nothing
+        }
+        expected = SLOT_SERVING;
+        if (atomic_compare_exchange_strong(&slot->state, &expected, SLOT_ABANDONED)) {
+            return false;
+        }
+        // answered just now, its post is on the way
+        while (sem_wait(&slot->done) != 0) {
+        }
+        break;
+    }
+    return true;
+}
+
+void shm_release(ShmSlot* slot) { atomic_store(&slot->state, SLOT_FREE); }
+
+// one round trip with a copy in and out, for callers that do not build the Game in the slot
+bool shm_query(ShmMap* map, Game* game, int player_id, bool exact, ShmAnswer* answer) {
+    ShmSlot* slot   = shm_claim(map);
+    slot->game      = *game;
+    slot->player_id = (uint32_t) player_id;
+    slot->exact     = exact;
+    if (!shm_submit(map, slot)) {
+        return false;
+    }
+    *answer = slot->answer;
+    shm_release(slot);
+    return true;
+}
+
+//////////////////////////////////// Engine Protocol //////////////////////////////////////
+// A long-lived analysis process driven by one command per line, for GUIs and services that would otherwise
+// start the interactive binary per query. Searches run on a Ponder, so its leg cache and the approximate
+// tables stay warm from one position to the next, and every phase streams an info line as it lands.
+//
+//   isready                        -> readyok
+//   position startpos [seed]       a freshly dealt game, seed 0 unless given
+//   position <state>               a game in the encoding below
+//   go [movetime <ms>]             analyse for the player to move: info lines then bestmove. movetime is the
+//                                  sampling budget of the wager phase
+//   stop                           bestmove from what is known so far
+//   odds                           exact leg odds of the position, answered at once
+//   quit                           end of input works too, a running search is stopped first
+//
+// A state is nine space separated fields:
+//   tiles    17 tiles split by '/', each its camels bottom first (R B Y G P W K) then +n or -n for the
+//            spectator tile of player n
+//   dice     the leg's rolls in order, e.g. B2,K-1, or - when none
+//   tickets  5 colors split by '/', each the players holding its tickets in the order they were taken
+//   players  6 players split by '/', each points:hand as hex:spectator used (0 or 1)
+//   winner   overall winner wagers in order as player then color, e.g. 0R3B, or -
+//   loser    overall loser wagers the same way
+//   to move, turn, round
+
+#define ENGINE_LINE 512
+
+typedef struct {
+    FILE* out;
+    Ponder ponder;
+    bool searching; // a go is running and owes a bestmove, guarded by the out lock
+    Game game;
+    int to_move;
+    LegTracker tracker; // for odds, the pondering thread has its own
+} Engine;
+
+void engine_turn(FILE* out, Turn* turn) {
+    switch (turn->turn_type) {
+        case TICKET:
+            fprintf(out, "ticket %s", enum2char((CamelColor) turn->color));
+            break;
+        case WAGER:
+            fprintf(out, "wager %s %s", turn->orientation == FORWARD ? "win" : "lose", enum2char((CamelColor) turn->color));
+            break;
+        case ROLL:
+        case SPECTATOR:
         default:
+            fprintf(out, "roll");
             break;
     }
+}
+
+void engine_odds(FILE* out, const char* label, LegOdds* odds) {
+    const double* groups[3] = {odds->first, odds->second, odds->last};
+    const char* names[3]    = {"first", "second", "last"};
+    fprintf(out, "%s", label);
+    for (int k = 0; k < 3; k++) {
+        fprintf(out, " %s", names[k]);
+        for (int c = 0; c < N_BETS_COLORS; c++) {
+            fprintf(out, " %.4f", groups[k][c]);
+        }
+    }
+}
+
+// bestmove from r, with out locked
+void engine_bestmove(Engine* engine, PonderResult* r) {
+    fprintf(engine->out, "bestmove ");
+    engine_turn(engine->out, &r->hint);
+    fprintf(engine->out, "\n");
+    fflush(engine->out);
+    engine->searching = false;
+}
+
+// Ponder redraw callback: one info line per phase, bestmove after the last
+void engine_info(void* ctx, Game* game) {
+    (void) game;
+    Engine* engine = ctx;
+    PonderResult r;
+    flockfile(engine->out);
+    if (engine->searching && camels_ponder_result(&engine->ponder, &r)) {
+        const char* depth[] = {"none", "approx", "exact", "done"};
+        engine_odds(engine->out, "info", &r.odds);
+        fprintf(engine->out, " depth %s tickets", depth[r.depth]);
+        for (int c = 0; c < N_BETS_COLORS; c++) {
+            fprintf(engine->out, r.has_ticket[c] ? " %+.3f" : " -", r.ticket_ev[c]);
+        }
+        fprintf(engine->out, " hint ");
+        engine_turn(engine->out, &r.hint);
+        fprintf(engine->out, " ev %+.3f\n", r.hint_ev);
+        fflush(engine->out);
+        if (r.depth == PONDER_DONE) {
+            engine_bestmove(engine, &r);
+        }
+    }
+    funlockfile(engine->out);
+}
+
+void engine_stop(Engine* engine) {
+    PonderResult r;
+    flockfile(engine->out);
+    if (engine->searching) {
+        if (!camels_ponder_result(&engine->ponder, &r)) {
+            r.hint = (Turn) {.turn_type = ROLL}; // stopped before the first phase landed
+        }
+        engine_bestmove(engine, &r);
+    }
+    funlockfile(engine->out);
+    camels_ponder_stop(&engine->ponder);
+}
+
+// runs the protocol until quit or end of input. False when the engine could not start
+bool run_engine(FILE* in, FILE* out) {
+    static Engine engine;
+    engine.out       = out;
+    engine.searching = false;
+    if (!camels_leg_tracker_init(&engine.tracker, 16) || !camels_ponder_init(&engine.ponder, engine_info, &engine)) {
+        return false;
+    }
+    Rng deal        = {.state = 0};
+    camels_game_rng = &deal;
+    camels_init_game(&engine.game);
+    camels_game_rng = NULL;
+    engine.to_move  = 0;
+
+    char line[ENGINE_LINE];
+    while (fgets(line, sizeof(line), in) != NULL) {
+        line[strcspn(line, "\r\n")] = '\0';
+        char* args                  = strchr(line, ' ');
+        args                        = args != NULL ? args + 1 : line + strlen(line);
+        flockfile(out);
+        if (strcmp(line, "quit") == 0) {
+            funlockfile(out);
+            break;
+        } else if (strcmp(line, "isready") == 0) {
+            fprintf(out, "readyok\n");
+        } else if (strncmp(line, "position ", 9) == 0) {
+            funlockfile(out);
+            engine_stop(&engine);
+            flockfile(out);
+            static Game parsed;
+            int to_move;
+            if (strncmp(args, "startpos", 8) == 0) {
+                Rng rng         = {.state = strtoull(args + 8, NULL, 10)};
+                camels_game_rng = &rng;
+                memset(&engine.game, 0, sizeof(Game));
+                camels_init_game(&engine.game);
+                camels_game_rng = NULL;
+                engine.to_move  = 0;
+            } else if (camels_decode_game(args, &parsed, &to_move)) {
+                engine.game    = parsed;
+                engine.to_move = to_move;
+            } else {
+                fprintf(out, "error bad position\n");
+            }
+        } else if (strcmp(line, "go") == 0 || strncmp(line, "go ", 3) == 0) {
+            double movetime = PONDER_WAGER_MS;
+            sscanf(args, "movetime %lf", &movetime);
+            funlockfile(out);
+            engine_stop(&engine);
+            flockfile(out);
+            engine.ponder.wager_ms = movetime;
+            engine.searching       = true;
+            camels_ponder_start(&engine.ponder, &engine.game, engine.to_move);
+        } else if (strcmp(line, "stop") == 0) {
+            funlockfile(out);
+            engine_stop(&engine);
+            flockfile(out);
+        } else if (strcmp(line, "odds") == 0) {
+            LegOdds odds;
+            camels_leg_tracker_odds(&engine.tracker, &engine.game, &odds);
+            engine_odds(out, "odds", &odds);
+            fprintf(out, "\n");
+        } else if (line[0] != '\0') {
+            fprintf(out, "error unknown command %s\n", line);
+        }
+        fflush(out);
+        funlockfile(out);
+    }
+    engine_stop(&engine);
+    camels_ponder_free(&engine.ponder);
+    camels_leg_tracker_free(&engine.tracker);
     return true;
 }
 
+
 #ifndef TEST_BUILD
+// what the terminal shows under the board besides the pondering results
+typedef struct {
+    Evaluator* eval; // NULL without --weights
+} View;
+
+void redraw_view(void* ctx, Game* game) {
+    View* view = ctx;
+    render_horizontal(game);
+    if (view->eval != NULL) {
+        render_eval(view->eval, game);
+    }
+    if (camels_tablebase != NULL) {
+        render_tablebase(camels_tablebase, game);
+    }
+}
+
+// Ponder redraw callback: the view with the current prompt back under it
+void redraw_pondering(void* ctx, Game* game) {
+    flockfile(stdout);
+    redraw_view(ctx, game);
+    fputs(prompt_line, stdout);
+    fflush(stdout);
+    funlockfile(stdout);
+}
+
+// --search hook: how each search of seat 0 went and the turn it chose
+void print_search_move(void* ctx, Game* game, int player_id, Turn* turn) {
+    SearchStats* stats = ctx;
+    if (player_id != 0) {
+        return;
+    }
+    printf("turn %3d  depth %2d  %9lu nodes  %8.0f nodes/s  value %+6.2f  ", game->turn, stats->depth,
+           (unsigned long) stats->nodes, stats->nodes_per_second, stats->value);
+    if (turn->turn_type == SPECTATOR) {
+        printf("spectator %s1 on %d\n", orient2char(turn->orientation), turn->position);
+        return;
+    }
+    engine_turn(stdout, turn);
+    printf("\n");
+}
+
 int main(int argc, char** argv) {
     srand((unsigned int) time(NULL));
+    camels_log_enabled = true; // bots and batch runs turn off per-turn logging
     // srand((unsigned int) 4);
 
-    Game game = {0};
-    init_game(&game);
-    render_horizontal(&game);
-    printf("Enter any key to start game\n");
-    wait_for_enter();
-
-    int curr_player_id = 0;
-    int first, second;
-    Turn turn = {0};
-    while (!game.winner) {
-        while (game.dice.count != N_DICE && !game.winner) {
-            bool valid_turn = false;
+    // --self-play <file> [games] [threads]: write a training dataset from bot games and exit
+    if (argc >= 3 && strcmp(argv[1], "--self-play") == 0) {
+        SelfPlayConfig config = {.games       = argc > 3 ? atol(argv[3]) : 1000,
+                                 .threads     = argc > 4 ? atoi(argv[4]) : 0,
+                                 .sample_rate = 0.25,
+                                 .seed        = (uint64_t) time(NULL),
+                                 .compress    = true};
+        SelfPlayResult result;
+        if (!camels_self_play(&config, argv[2], &result)) {
+            fprintf(stderr, "Self-play could not write %s\n", argv[2]);
+            return 1;
+        }
+        printf("%ld games, %lu positions, %lu bytes in %.2fs: %.0f positions/s\n", result.games,
+               (unsigned long) result.positions, (unsigned long) result.bytes, result.seconds,
+               (double) result.positions / result.seconds);
+        return 0;
+    }
 
-            while (!valid_turn) {
-                get_user_input(&game, curr_player_id, &turn);
-                valid_turn = next_turn(&game, &turn, curr_player_id);
+    // --tournament [deals] [threads]: round-robin of the built-in bots, ratings and exit
+    if (argc >= 2 && strcmp(argv[1], "--tournament") == 0) {
+        TournamentConfig config = {.deals      = argc > 2 ? atol(argv[2]) : 1000,
+                                   .threads    = argc > 3 ? atoi(argv[3]) : 0,
+                                   .seed       = (uint64_t) time(NULL),
+                                   .n_entrants = N_BUILTIN_ENTRANTS};
+        memcpy(config.entrants, camels_builtin_entrants, sizeof(camels_builtin_entrants));
+        TournamentResult result;
+        if (!camels_tournament(&config, &result)) {
+            fprintf(stderr, "Tournament needs at least one deal\n");
+            return 1;
+        }
+        printf("%ld games in %.2fs: %.0f games/s\n\n%-8s %8s %7s", result.games, result.seconds,
+               (double) result.games / result.seconds, "", "elo", "95%");
+        for (int j = 0; j < config.n_entrants; j++) {
+            printf(" %8s", config.entrants[j].name);
+        }
+        printf("\n");
+        for (int i = 0; i < config.n_entrants; i++) {
+            printf("%-8s %+8.1f %6.1f ", config.entrants[i].name, result.elo[i], result.elo_ci[i]);
+            for (int j = 0; j < config.n_entrants; j++) {
+                if (i == j) {
+                    printf(" %8s", "-");
+                } else {
+                    printf(" %8.3f", result.score[i][j]);
+                }
             }
+            printf("\n");
+        }
+        return 0;
+    }
+
+    // --search [ms] [paranoid]: one game with a searching player in seat 0 against the odds and greedy bots,
+    // printing the depth and speed of every search
+    if (argc >= 2 && strcmp(argv[1], "--search") == 0) {
+        static Searcher search;
+        SearchConfig config = {.mode      = argc > 3 && strcmp(argv[3], "paranoid") == 0 ? SEARCH_PARANOID : SEARCH_MAXN,
+                               .budget_ms = argc > 2 ? atof(argv[2]) : 100.0};
+        if (!camels_searcher_init(&search, config)) {
+            fprintf(stderr, "Could not allocate the search table\n");
+            return 1;
+        }
+        camels_searcher         = &search;
+        camels_log_enabled      = false;
+        Policy seats[N_PLAYERS] = {camels_bot_expectimax, camels_bot_odds,   camels_bot_greedy,
+                                   camels_bot_odds,       camels_bot_greedy, camels_bot_odds};
+        GameHooks hooks         = {.on_turn_done = print_search_move, .ctx = &search.stats};
+        Rng rng                 = {.state = (uint64_t) time(NULL)};
+        Game game               = {0};
+        camels_game_rng         = &rng;
+        camels_init_game(&game);
+        camels_game_rng = NULL;
+        camels_play_bot_game(&game, seats, &rng, &hooks);
+        for (int p = 0; p < N_PLAYERS; p++) {
+            printf("player %d: %d points\n", p, game.players[p].points);
+        }
+        camels_searcher = NULL;
+        camels_searcher_free(&search);
+        return 0;
+    }
+
+    // --export <file> [games]: write per-turn results of bot games as columns and exit
+    if (argc >= 3 && strcmp(argv[1], "--export") == 0) {
+        uint64_t rows, bytes;
+        if (!camels_export_games(argv[2], argc > 3 ? atol(argv[3]) : 1000, (uint64_t) time(NULL), &rows, &bytes)) {
+            fprintf(stderr, "Could not export to %s\n", argv[2]);
+            return 1;
+        }
+        printf("%lu rows, %lu bytes (%.2f bytes/row)\n", (unsigned long) rows, (unsigned long) bytes,
+               (double) bytes / (double) rows);
+        return 0;
+    }
+
+    // --tablebase-gen <file> [span]: solve the endgame tablebase for the last span tiles and exit
+    if (argc >= 3 && strcmp(argv[1], "--tablebase-gen") == 0) {
+        uint32_t entries;
+        clock_t start = clock();
+        if (!camels_tablebase_generate(argv[2], argc > 3 ? atoi(argv[3]) : TB_SPAN, &entries)) {
+            fprintf(stderr, "Could not write tablebase %s\n", argv[2]);
+            return 1;
+        }
+        printf("%u positions in %.2fs\n", entries, elapsed_ms(start) / 1000.0);
+        return 0;
+    }
+
+    // --sweep <address> <games> [local workers]: whole-game bot sweep sharded across workers, print the histogram
+    if (argc >= 4 && strcmp(argv[1], "--sweep") == 0) {
+        static SweepJob job;
+        job.mode    = SWEEP_GAMES;
+        job.seed    = (uint64_t) time(NULL);
+        job.samples = (uint64_t) atoll(argv[3]);
+        DistConfig config = {.address = argv[2], .local_workers = argc > 4 ? atoi(argv[4]) : 0};
+        SweepHistogram hist;
+        DistResult result;
+        if (!dist_sweep(&job, &config, &hist, &result)) {
+            fprintf(stderr, "Could not listen on %s\n", argv[2]);
+            return 1;
+        }
+        printf("%lu games (seed %lu), %d shards over %d workers, %d lost (%d late), %d played here, %.2fs\n",
+               (unsigned long) hist.samples, (unsigned long) job.seed, result.shards, result.workers,
+               result.shards_lost, result.shards_late, result.shards_local, result.seconds);
+        for (int c = 0; c < N_BETS_COLORS; c++) {
+            printf("%-7s first %6.2f%%  last %6.2f%%\n", enum2char((CamelColor) c),
+                   100.0 * (double) hist.first[c] / (double) hist.samples,
+                   100.0 * (double) hist.last[c] / (double) hist.samples);
+        }
+        for (int p = 0; p < N_PLAYERS; p++) {
+            printf("seat %d  wins %6.2f%%\n", p, 100.0 * (double) hist.seat[p] / (double) hist.samples);
+        }
+        return 0;
+    }
+
+    // --worker <address>: play sweep shards for the coordinator at address until it is done
+    if (argc == 3 && strcmp(argv[1], "--worker") == 0) {
+        return dist_worker(argv[2]) ? 0 : 1;
+    }
 
-            // render game state
-            render_horizontal(&game);
-            curr_player_id = (curr_player_id + 1) % N_PLAYERS;
-            game.turn++;
+    // --serve <file> [threads]: answer shared memory queries from local clients until SIGINT or SIGTERM
+    if (argc >= 3 && strcmp(argv[1], "--serve") == 0) {
+        sigset_t stop;
+        sigemptyset(&stop);
+        sigaddset(&stop, SIGINT);
+        sigaddset(&stop, SIGTERM);
+        pthread_sigmask(SIG_BLOCK, &stop, NULL); // server threads inherit the mask, only sigwait sees them
+        static ShmServer server;
+        if (!shm_server_start(&server, argv[2], argc > 3 ? atoi(argv[3]) : 0)) {
+            fprintf(stderr, "Could not serve %s\n", argv[2]);
+            return 1;
         }
-        // give out points for round
-        score_round(&game, &first, &second);
-        printf("First place: %s\tSecond Place: %s\n", enum2char((CamelColor) first), enum2char((CamelColor) second));
-        render_horizontal(&game);
+        printf("Serving %s with %d threads\n", argv[2], server.n_threads);
+        int sig;
+        sigwait(&stop, &sig);
+        shm_server_stop(&server);
+        printf("%lu queries answered\n", (unsigned long) atomic_load(&server.served));
+        return 0;
+    }
+
+    // --engine: line protocol on stdin and stdout, see Engine Protocol
+    if (argc == 2 && strcmp(argv[1], "--engine") == 0) {
+        camels_log_enabled = false;
+        return run_engine(stdin, stdout) ? 0 : 1;
+    }
+
+    // --tablebase <file>: exact race odds under the board whenever the tablebase covers the position
+    static Tablebase tb;
+    if (argc == 3 && strcmp(argv[1], "--tablebase") == 0) {
+        if (!camels_tablebase_open(&tb, argv[2])) {
+            fprintf(stderr, "Could not load tablebase %s\n", argv[2]);
+            return 1;
+        }
+        camels_tablebase = &tb;
+    }
 
-        if (!game.winner) {
-            printf("Enter any key for next round\n");
-            wait_for_enter();
+    // --weights <file>: show evaluator odds under the board
+    static Evaluator eval;
+    bool has_eval = false;
+    if (argc == 3 && strcmp(argv[1], "--weights") == 0) {
+        if (!camels_eval_load(&eval, argv[2])) {
+            fprintf(stderr, "Could not load weights from %s\n", argv[2]);
+            return 1;
         }
-        end_round(&game);
-        render_horizontal(&game);
+        has_eval = true;
+    }
+
+    // analysis of the position runs while the player thinks, results land under the board
+    static Ponder pondering;
+    View view = {.eval = has_eval ? &eval : NULL};
+    if (camels_ponder_init(&pondering, redraw_pondering, &view)) {
+        ponder = &pondering;
     }
 
-    qsort(game.players, N_PLAYERS, sizeof(Player), compare);
-    render_horizontal(&game);
+    static Session session;
+    Policy seats[N_PLAYERS] = {NULL}; // every seat is a human at this terminal
+    camels_start_game(&session, seats, (uint64_t) time(NULL));
+    Game* game = &session.game;
+
+    render_horizontal(game);
+    printf("Enter any key to start game\n");
+    wait_for_enter();
+
+    Event events[SESSION_EVENTS];
+    Turn turn      = {0};
+    bool game_over = false;
+    while (!game_over) {
+        int n = camels_poll_events(&session, events, SESSION_EVENTS);
+        for (int i = 0; i < n; i++) {
+            Event* e = &events[i];
+            switch (e->type) {
+                case EV_AWAIT_TURN: {
+                    if (ponder != NULL) {
+                        camels_ponder_start(ponder, game, e->player);
+                    }
+                    get_user_input(game, e->player, &turn);
+                    if (ponder != NULL) {
+                        camels_ponder_stop(ponder);
+                        prompt_line[0] = '\0'; // no redraw is left to show it
+                    }
+                    camels_submit_turn(&session, e->player, &turn);
+                    break;
+                }
+                case EV_TURN: {
+                    // render game state
+                    redraw_view(&view, game);
+                    break;
+                }
+                case EV_LEG_SCORED: {
+                    printf("First place: %s\tSecond Place: %s\n", enum2char((CamelColor) e->first),
+                           enum2char((CamelColor) e->second));
+                    render_horizontal(game);
+                    if (!game->winner) {
+                        printf("Enter any key for next round\n");
+                        wait_for_enter();
+                    }
+                    break;
+                }
+                case EV_ROUND_ENDED: {
+                    render_horizontal(game);
+                    break;
+                }
+                case EV_GAME_OVER: {
+                    game_over = true;
+                    break;
+                }
+                case EV_REJECTED:
+                default:
+                    break;
+            }
+        }
+    }
+
+    if (ponder != NULL) {
+        camels_ponder_free(ponder);
+        ponder = NULL;
+    }
+    qsort(game->players, N_PLAYERS, sizeof(Player), compare);
+    render_horizontal(game);
+#ifdef CAMELS_STATS
+    camels_stats_merge();
+    camels_stats_dump(stderr, &camels_stats_total);
+#endif
     return 0;
 }
 
@@ -6,6 +6,7 @@
 
 // Define TEST_BUILD before including main.c to exclude main()
 #define TEST_BUILD
+#include "engine.c"
 #include "main.c"
 
 int tests_run = 0;
@@ -15,7 +16,7 @@ Game* setup_game(void) {
     static Game game;
     memset(&game, 0, sizeof(Game));
     srand(42); // Fixed seed for reproducible tests
-    init_game(&game);
+    camels_init_game(&game);
     return &game;
 }
 
@@ -73,11 +74,11 @@ static char* test_init_player_hand(void) {
     init_player_hand(&player);
 
     mu_assert("Hand size should be 5", hand_size(&player) == N_BETS_COLORS);
-    mu_assert("Should have RED", player.hand[0].color == BRED);
-    mu_assert("Should have BLUE", player.hand[1].color == BBLUE);
-    mu_assert("Should have YELLOW", player.hand[2].color == BYELLOW);
-    mu_assert("Should have GREEN", player.hand[3].color == BGREEN);
-    mu_assert("Should have PURPLE", player.hand[4].color == BPURPLE);
+    mu_assert("Should have RED", has_card_in_hand(&player, BRED));
+    mu_assert("Should have BLUE", has_card_in_hand(&player, BBLUE));
+    mu_assert("Should have YELLOW", has_card_in_hand(&player, BYELLOW));
+    mu_assert("Should have GREEN", has_card_in_hand(&player, BGREEN));
+    mu_assert("Should have PURPLE", has_card_in_hand(&player, BPURPLE));
 
     return 0;
 }
@@ -217,6 +218,22 @@ static char* test_assign_all_tickets(void) {
     return 0;
 }
 
+static char* test_ticket_top(void) {
+    Game* game = setup_game();
+
+    assign_ticket(game, BBLUE, 3);
+    assign_ticket(game, BBLUE, 4);
+    mu_assert("Top should move past the dealt tickets", game->tickets[BBLUE].top == 2);
+    mu_assert("Next ticket should be a 2", top_ticket(&game->tickets[BBLUE])->amount == 2);
+    mu_assert("Dealt tickets keep their holders", game->tickets[BBLUE].items[1].player_id == 4);
+
+    end_round(game);
+    mu_assert("Reset should restore the 5", top_ticket(&game->tickets[BBLUE])->amount == 5);
+    mu_assert("Reset should clear the holders", game->tickets[BBLUE].items[1].player_id == -1);
+
+    return 0;
+}
+
 //////////////////////////////////// Spectator Tests //////////////////////////////////////
 
 static char* test_place_spec_tile(void) {
@@ -330,6 +347,35 @@ static char* test_move_camel_to_finish(void) {
     return 0;
 }
 
+static char* test_move_kernel_fuzz(void) {
+    static Game reference, block;
+    for (uint64_t seed = 0; seed < 200; seed++) {
+        Rng rng = {.state = seed};
+        memset(&reference, 0, sizeof(Game));
+        camels_game_rng = &rng;
+        camels_init_game(&reference);
+        camels_game_rng = NULL;
+        for (int s = 0; s < 3; s++) {
+            int tile = rng_range(&rng, 1, BOARD_SIZE - 2);
+            if (reference.board[tile].camel_stack.count == 0) {
+                reference.board[tile].has_spec = true;
+                reference.board[tile].spec     = (Spectator) {.player = (uint8_t) s, .orientation = (uint8_t) rng_range(&rng, 0, 1)};
+            }
+        }
+        block = reference;
+
+        // any camel, any distance including none and past either end of the board
+        for (int move = 0; move < 60; move++) {
+            CamelColor color = (CamelColor) rng_range(&rng, 0, N_CAMELS - 1);
+            int spaces       = rng_range(&rng, -4, 4);
+            move_camel_with(&reference, color, spaces, move_stack);
+            move_camel_with(&block, color, spaces, move_stack_block);
+            mu_assert("Block kernel should match move_stack", memcmp(&reference, &block, sizeof(Game)) == 0);
+        }
+    }
+    return 0;
+}
+
 //////////////////////////////////// Scoring Tests //////////////////////////////////////
 
 static char* test_get_top_camels(void) {
@@ -646,16 +692,15 @@ static char* test_score_round_integration(void) {
 
     // Move camels to specific positions
     // We need to ensure RED is first, BLUE is second
-    Camel* red    = get_camel(game, CRED);
-    Camel* blue   = get_camel(game, CBLUE);
-    Camel* yellow = get_camel(game, CYELLOW);
+    // Camel pointers go stale once a stack moves, so look each one up right before moving it
 
     // Move RED to position 10 (higher than others)
-    move_camel(game, CRED, 10 - red->space);
+    move_camel(game, CRED, 10 - get_camel(game, CRED)->space);
     // Move BLUE to position 9
-    move_camel(game, CBLUE, 9 - blue->space);
-    // Move YELLOW to position 5
-    move_camel(game, CYELLOW, 5 - yellow->space);
+    move_camel(game, CBLUE, 9 - get_camel(game, CBLUE)->space);
+    // Move GREEN (may have been carried along) and YELLOW to position 5
+    move_camel(game, CGREEN, 5 - get_camel(game, CGREEN)->space);
+    move_camel(game, CYELLOW, 5 - get_camel(game, CYELLOW)->space);
 
     int p0_initial = game->players[0].points;
     int p1_initial = game->players[1].points;
@@ -694,6 +739,8 @@ static char* test_full_game_scoring(void) {
     // Ensure we know who is second for the ticket points
     Camel* blue = get_camel(game, CBLUE);
     move_camel(game, CBLUE, (BOARD_SIZE - 2) - blue->space);
+    // drop anything BLUE carried along so it stays on top of second place
+    move_camel(game, CGREEN, 5 - get_camel(game, CGREEN)->space);
 
     int p0_initial = game->players[0].points;
     int p1_initial = game->players[1].points;
@@ -822,6 +869,8 @@ static char* test_stack_victory_order(void) {
     // Move Red and Blue to the finish line in a stack
     // Red on bottom (index 0), Blue on top (index 1)
     game->board[BOARD_SIZE - 1].camel_stack.count = 0;
+    // keep GREEN from riding along on top of the stack
+    move_camel(game, CGREEN, 5 - get_camel(game, CGREEN)->space);
     move_camel(game, CRED, (BOARD_SIZE - 1) - get_camel(game, CRED)->space);
     move_camel(game, CBLUE, (BOARD_SIZE - 1) - get_camel(game, CBLUE)->space);
 
@@ -851,6 +900,1457 @@ static char* test_spectator_reverse_move(void) {
     mu_assert("Owner of spectator tile should get 1 point", game->players[5].points == 1);
     return 0;
 }
+//////////////////////////////////// Wager Valuation Tests //////////////////////////////////////
+
+static char* test_remaining_dice(void) {
+    Game* game = setup_game();
+    DiceColor left[N_DICE + 1];
+
+    mu_assert("Full pyramid at start of leg", remaining_dice(game, left) == N_DICE + 1);
+    for (int i = 0; i < N_DICE; i++) {
+        roll_dice(game);
+    }
+    mu_assert("One die should be left after a leg", remaining_dice(game, left) == 1);
+
+    return 0;
+}
+
+static char* test_get_last_camel(void) {
+    Game* game = setup_game();
+
+    // stack every racing camel on tile 3 with YELLOW at the bottom
+    for (int c = CYELLOW; c < CWHITE; c++) {
+        move_camel(game, (CamelColor) c, 3 - get_camel(game, (CamelColor) c)->space);
+    }
+    move_camel(game, CRED, 4 - get_camel(game, CRED)->space);
+    move_camel(game, CBLUE, 4 - get_camel(game, CBLUE)->space);
+
+    mu_assert("Bottom camel of the rear tile should be last", get_last_camel(game) == CYELLOW);
+    return 0;
+}
+
+static char* test_queued_wager_ev(void) {
+    double q[2] = {1.0, 1.0};
+
+    mu_assert("Sure bet behind 2 correct bets pays 3", queued_wager_ev(1.0, 2, q, 0) > 2.99);
+    mu_assert("Sure loss costs 1", queued_wager_ev(0.0, 0, q, 0) < -0.99);
+    mu_assert("Two certain bets ahead drop 8 to 3", queued_wager_ev(1.0, 0, q, 2) > 2.99);
+    mu_assert("Two certain bets ahead drop 8 to 3", queued_wager_ev(1.0, 0, q, 2) < 3.01);
+
+    return 0;
+}
+
+static char* test_value_wagers(void) {
+    Game* game = setup_game();
+    Rng rng    = {.state = 7};
+
+    // GREEN runs away from the pack, one tile from the finish
+    move_camel(game, CGREEN, (BOARD_SIZE - 2) - get_camel(game, CGREEN)->space);
+    Wager w = {.player = 1, .color = BGREEN};
+    stack_push(&game->winner_bets, w);
+    remove_card_from_hand(&game->players[1], BGREEN);
+
+    WagerValue values[N_BETS_COLORS];
+    int samples = value_wagers(game, 0, &rng, WAGER_BUDGET_MS, values);
+
+    mu_assert("Should run playouts", samples > 0);
+    mu_assert("GREEN should be the favourite", values[BGREEN].p_first > 0.9);
+    mu_assert("Queued bet caps GREEN near 5", values[BGREEN].winner_now < 5.0);
+    mu_assert("Queued bet caps GREEN near 5", values[BGREEN].winner_now > 4.0);
+    mu_assert("Waiting should cost queue position", values[BGREEN].winner_wait < values[BGREEN].winner_now);
+    mu_assert("Player 0 still holds GREEN", values[BGREEN].available);
+    mu_assert("GREEN should never be last", values[BGREEN].p_last < 0.01);
+
+    return 0;
+}
+
+//////////////////////////////////// Stats Tests //////////////////////////////////////
+
+static char* test_stats_merge(void) {
+    camels_stats_merge();
+    camels_stats_total = (Stats) {0};
+
+    stats_local.move_calls       = 3;
+    stats_local.move_carried_max = 4;
+    camels_stats_merge();
+    mu_assert("Local counters should be cleared", stats_local.move_calls == 0);
+
+    stats_local.move_calls       = 2;
+    stats_local.move_carried_max = 2;
+    camels_stats_merge();
+    mu_assert("Counters should add up", camels_stats_total.move_calls == 5);
+    mu_assert("Maxima should not add up", camels_stats_total.move_carried_max == 4);
+
+    return 0;
+}
+
+#ifdef CAMELS_STATS
+static char* test_stats_counters(void) {
+    Game* game  = setup_game();
+    stats_local = (Stats) {0};
+
+    move_camel(game, CRED, 1);
+    Turn turn = {.turn_type = TICKET, .color = BRED};
+    for (int i = 0; i <= N_TICKETS; i++) {
+        next_turn(game, &turn, 0);
+    }
+
+    mu_assert("move_camel should be counted", stats_local.move_calls == 1);
+    mu_assert("Carried camels should be counted", stats_local.move_carried >= 1);
+    mu_assert("get_camel scans should be counted", stats_local.get_camel_scanned >= 1);
+    mu_assert("Every turn should be counted", stats_local.turns == N_TICKETS + 1);
+    mu_assert("The fifth ticket should be rejected", stats_local.invalid_turns == 1);
+
+    return 0;
+}
+#endif
+
+//////////////////////////////////// Evaluation Tests //////////////////////////////////////
+
+static char* test_extract_features(void) {
+    Game* game = setup_game();
+    _Alignas(16) float features[N_FEATURES];
+
+    Spectator spec = {.player = 0, .orientation = REVERSE};
+    place_spec_tile(game, 0, 8, spec);
+    assign_ticket(game, BBLUE, 0);
+    remove_card_from_hand(&game->players[2], BGREEN);
+    extract_features(game, features);
+
+    Camel* red = get_camel(game, CRED);
+    mu_assert("Red distance to finish", fabsf(features[CRED] - (float) (BOARD_SIZE - 1 - red->space) / 16.0f) < 1e-6f);
+    mu_assert("Reverse spectator on tile 8", features[14 + 8] < -0.5f);
+    mu_assert("Whole pyramid left", features[30] > 0.5f && features[30 + DGREY] > 0.5f);
+    mu_assert("Blue top ticket is now 3", fabsf(features[36 + BBLUE] - 0.6f) < 1e-6f);
+    mu_assert("Player 2 spent GREEN", features[47 + 2 * N_BETS_COLORS + BGREEN] < 0.5f);
+    mu_assert("Padding stays zero", features[N_FEATURES - 1] < 1e-9f && features[N_FEATURES - 1] > -1e-9f);
+
+    return 0;
+}
+
+static char* test_eval_linear(void) {
+    Game* game = setup_game();
+    static Evaluator ev;
+    memset(&ev, 0, sizeof(ev));
+    float out[N_EVAL_OUTPUTS];
+
+    camels_eval_game(&ev, game, out);
+    mu_assert("Zero weights give uniform odds", fabsf(out[0] - 0.2f) < 1e-6f);
+
+    ev.b1[BYELLOW] = 20.0f; // leg winner group
+    camels_eval_game(&ev, game, out);
+    mu_assert("Bias should pick the leg winner", out[BYELLOW] > 0.99f);
+    mu_assert("Race group stays uniform", fabsf(out[N_BETS_COLORS] - 0.2f) < 1e-6f);
+
+    return 0;
+}
+
+static char* test_eval_save_load(void) {
+    Game* game = setup_game();
+    static Evaluator ev, loaded;
+    memset(&ev, 0, sizeof(ev));
+    Rng rng = {.state = 3};
+
+    ev.kind = EVAL_MLP;
+    for (int h = 0; h < EVAL_HIDDEN; h++) {
+        for (int i = 0; i < N_FEATURES_USED; i++) {
+            ev.w1[h][i] = (float) rng_range(&rng, -100, 100) / 100.0f;
+        }
+        ev.w2[h % N_EVAL_OUTPUTS][h] = 1.5f;
+    }
+    const char* path = "build/test/eval_weights.txt";
+    mu_assert("Weights should save", eval_save(&ev, path));
+    mu_assert("Weights should load", camels_eval_load(&loaded, path));
+    remove(path);
+
+    float a[N_EVAL_OUTPUTS], b[N_EVAL_OUTPUTS];
+    camels_eval_game(&ev, game, a);
+    camels_eval_game(&loaded, game, b);
+    mu_assert("Loaded kind should match", loaded.kind == EVAL_MLP);
+    for (int o = 0; o < N_EVAL_OUTPUTS; o++) {
+        mu_assert("Loaded weights should evaluate the same", fabsf(a[o] - b[o]) < 1e-6f);
+    }
+    mu_assert("Missing file should fail", !camels_eval_load(&loaded, "build/test/no_such_weights.txt"));
+
+    return 0;
+}
+
+//////////////////////////////////// Self-play Tests //////////////////////////////////////
+
+static char* test_legal_turns(void) {
+    Game* game = setup_game();
+    Turn options[MAX_TURN_OPTIONS];
+    bool saved         = camels_log_enabled;
+    camels_log_enabled = false;
+
+    int n = legal_turns(game, 0, options);
+    mu_assert("Roll, 5 tickets, 10 wagers and spectator spots", n > 1 + N_BETS_COLORS + 2 * N_BETS_COLORS);
+    for (int i = 0; i < n; i++) {
+        Game copy = *game;
+        mu_assert("Every legal turn should be accepted", next_turn(&copy, &options[i], 0));
+    }
+
+    Turn spec = {.turn_type = SPECTATOR, .orientation = FORWARD, .position = 8};
+    next_turn(game, &spec, 0);
+    n = legal_turns(game, 0, options);
+    for (int i = 0; i < n; i++) {
+        mu_assert("Spectator is used up", options[i].turn_type != SPECTATOR);
+    }
+    camels_log_enabled = saved;
+
+    return 0;
+}
+
+static char* test_sample_compression(void) {
+    static Sample samples[3], decoded[3];
+    Game* game = setup_game();
+
+    encode_sample(game, 0, &samples[0]);
+    move_camel(game, CRED, 2);
+    encode_sample(game, 1, &samples[1]);
+    encode_sample(game, 2, &samples[2]);
+
+    static uint8_t packed[2 * 3 * sizeof(Sample)];
+    size_t len = compress_samples(samples, 3, packed);
+    mu_assert("Similar samples should compress", len < sizeof(samples) / 2);
+    mu_assert("Samples should decode", decompress_samples(packed, len, decoded, 3));
+    mu_assert("Samples should round trip", memcmp(samples, decoded, sizeof(samples)) == 0);
+    mu_assert("Truncated payload should fail", !decompress_samples(packed, len - 1, decoded, 3));
+
+    return 0;
+}
+
+static char* test_self_play_dataset(void) {
+    const char* path = "build/test/self_play.dat";
+    static DatasetReader reader;
+    static Sample scratch[DATASET_CHUNK_RECORDS];
+
+    for (int compress = 0; compress <= 1; compress++) {
+        SelfPlayConfig config = {.threads = 2, .games = 20, .sample_rate = 0.5, .seed = 9, .compress = compress};
+        SelfPlayResult result;
+        mu_assert("Self-play should write the dataset", camels_self_play(&config, path, &result));
+        mu_assert("Should record positions", result.positions > 0);
+
+        Sample sample;
+        uint64_t read = 0;
+        bool labelled = true;
+        mu_assert("Dataset should open", dataset_open(&reader, path));
+        while (dataset_next(&reader, &sample)) {
+            read++;
+            labelled = labelled && sample.leg_first < N_BETS_COLORS && sample.race_first < N_BETS_COLORS &&
+                       sample.race_last < N_BETS_COLORS;
+        }
+        dataset_close_reader(&reader);
+        mu_assert("Sequential read should see every position", read == result.positions);
+        mu_assert("Every position should carry its outcomes", labelled);
+
+        DatasetMap map;
+        size_t n;
+        uint64_t mapped = 0;
+        mu_assert("Dataset should map", dataset_map(&map, path));
+        const Sample* chunk;
+        while ((chunk = dataset_map_chunk(&map, scratch, &n)) != NULL) {
+            mapped += n;
+            mu_assert("Raw chunks should be read in place", compress || chunk != scratch);
+        }
+        dataset_unmap(&map);
+        mu_assert("Mapped read should see every position", mapped == result.positions);
+    }
+
+    // games are written in index order, so the file is the same byte for byte at any thread count
+    static char files[2][1 << 16];
+    size_t sizes[2];
+    for (int t = 0; t < 2; t++) {
+        SelfPlayConfig config = {.threads = 1 + 2 * t, .games = 40, .sample_rate = 0.5, .seed = 4, .compress = true};
+        SelfPlayResult result;
+        mu_assert("Self-play should write the dataset", camels_self_play(&config, path, &result));
+        FILE* f = fopen(path, "rb");
+        mu_assert("Dataset should open", f != NULL);
+        sizes[t] = fread(files[t], 1, sizeof(files[t]), f);
+        fclose(f);
+    }
+    mu_assert("Dataset should not depend on the thread count",
+              sizes[0] == sizes[1] && sizes[0] < sizeof(files[0]) && memcmp(files[0], files[1], sizes[0]) == 0);
+    remove(path);
+
+    return 0;
+}
+
+//////////////////////////////////// Columnar Export Tests //////////////////////////////////////
+
+static char* test_column_encodings(void) {
+    int64_t values[64], decoded[64];
+    static uint8_t buff[64 * 20];
+    for (int i = 0; i < 64; i++) {
+        values[i] = i < 40 ? 7 : (i % 3) - 1;
+    }
+
+    size_t len = encode_rle(values, 64, false, buff);
+    mu_assert("RLE should round trip", decode_column(ENC_RLE, buff, len, decoded, 64));
+    mu_assert("RLE should round trip", memcmp(values, decoded, sizeof(values)) == 0);
+
+    len = encode_rle(values, 64, true, buff);
+    mu_assert("Delta RLE should round trip", decode_column(ENC_DELTA_RLE, buff, len, decoded, 64));
+    mu_assert("Delta RLE should round trip", memcmp(values, decoded, sizeof(values)) == 0);
+
+    len = encode_mod_delta(values, 64, buff);
+    mu_assert("Modular delta RLE should round trip", decode_column(ENC_MOD_DELTA_RLE, buff, len, decoded, 64));
+    mu_assert("Modular delta RLE should round trip", memcmp(values, decoded, sizeof(values)) == 0);
+
+    len = encode_dict(values, 64, buff);
+    mu_assert("4 distinct values pack into 2 bits", len < 64 / 4 + 8);
+    mu_assert("Dictionary should round trip", decode_column(ENC_DICT, buff, len, decoded, 64));
+    mu_assert("Dictionary should round trip", memcmp(values, decoded, sizeof(values)) == 0);
+    mu_assert("Truncated chunk should fail", !decode_column(ENC_DICT, buff, len - 1, decoded, 64));
+
+    len = encode_huffman(values, 64, buff);
+    mu_assert("Huffman should round trip", decode_column(ENC_HUFFMAN, buff, len, decoded, 64));
+    mu_assert("Huffman should round trip", memcmp(values, decoded, sizeof(values)) == 0);
+    mu_assert("Truncated chunk should fail", !decode_column(ENC_HUFFMAN, buff, len - 1, decoded, 64));
+    len = encode_huffman(values, 40, buff);
+    mu_assert("A lone value takes no bits", len == 3 && decode_column(ENC_HUFFMAN, buff, len, decoded, 40));
+
+    return 0;
+}
+
+static char* test_export_games(void) {
+    const char* path = "build/test/export.col";
+    uint64_t rows, bytes;
+    mu_assert("Export should succeed", camels_export_games(path, 20, 5, &rows, &bytes));
+    mu_assert("Should write a row per turn", rows > 20 * N_PLAYERS);
+
+    static int64_t seats[COLUMN_GROUP_ROWS], games[COLUMN_GROUP_ROWS], turns[COLUMN_GROUP_ROWS],
+        winners[COLUMN_GROUP_ROWS];
+    ColumnReader reader;
+    mu_assert("Seat column should open", columns_open(&reader, path, COL_SEAT));
+    size_t n = columns_next(&reader, seats);
+    mu_assert("Small export fits one row group", n == rows && columns_next(&reader, seats) == 0);
+    columns_close_reader(&reader);
+
+    columns_open(&reader, path, COL_GAME);
+    mu_assert("Per-game columns have a row per game", columns_next(&reader, games) == 20);
+    columns_close_reader(&reader);
+    columns_open(&reader, path, COL_TURNS);
+    columns_next(&reader, turns);
+    columns_close_reader(&reader);
+    columns_open(&reader, path, COL_WINNER);
+    columns_next(&reader, winners);
+    columns_close_reader(&reader);
+
+    size_t row = 0;
+    for (int g = 0; g < 20; g++) {
+        mu_assert("Games are in order", games[g] == g);
+        mu_assert("Winner is a camel", winners[g] >= 0 && winners[g] < N_BETS_COLORS);
+        mu_assert("Every game starts with seat 0", row < n && seats[row] == 0);
+        for (int64_t t = 1; t < turns[g]; t++) {
+            mu_assert("Seats take turns", seats[row + (size_t) t] == (seats[row + (size_t) t - 1] + 1) % N_PLAYERS);
+        }
+        row += (size_t) turns[g];
+    }
+    mu_assert("Turn counts cover every turn row", row == n);
+    remove(path);
+
+    return 0;
+}
+
+//////////////////////////////////// Session Tests //////////////////////////////////////
+
+static char* test_session_human_and_bots(void) {
+    static Session session;
+    Policy seats[N_PLAYERS] = {NULL,              camels_bot_greedy, camels_bot_greedy,
+                               camels_bot_greedy, camels_bot_greedy, camels_bot_greedy};
+    Event events[SESSION_EVENTS];
+    bool saved         = camels_log_enabled;
+    camels_log_enabled = false;
+
+    camels_start_game(&session, seats, 11);
+    int n = camels_poll_events(&session, events, SESSION_EVENTS);
+    mu_assert("Seat 0 should be asked first", n == 1 && events[0].type == EV_AWAIT_TURN && events[0].player == 0);
+    mu_assert("Nothing happens while waiting", camels_poll_events(&session, events, SESSION_EVENTS) == 0);
+
+    Turn turn = {.turn_type = ROLL};
+    mu_assert("Only the player to move may submit", !camels_submit_turn(&session, 1, &turn));
+    mu_assert("Roll should be accepted", camels_submit_turn(&session, 0, &turn));
+
+    n = camels_poll_events(&session, events, SESSION_EVENTS);
+    mu_assert("Human turn is reported first", events[0].type == EV_TURN && events[0].player == 0);
+    mu_assert("Bots play until the human is needed", events[n - 1].type == EV_AWAIT_TURN);
+
+    Turn bad = {.turn_type = SPECTATOR, .orientation = FORWARD, .position = BOARD_SIZE};
+    mu_assert("Off-board spectator should be rejected", !camels_submit_turn(&session, 0, &bad));
+    n = camels_poll_events(&session, events, SESSION_EVENTS);
+    mu_assert("Rejection then a new prompt", n == 2 && events[0].type == EV_REJECTED && events[1].type == EV_AWAIT_TURN);
+    camels_log_enabled = saved;
+
+    return 0;
+}
+
+static char* test_session_bots_finish(void) {
+    static Session session;
+    Policy seats[N_PLAYERS] = {camels_bot_random, camels_bot_greedy, camels_bot_random,
+                               camels_bot_greedy, camels_bot_random, camels_bot_greedy};
+    Event events[4];
+    bool saved         = camels_log_enabled;
+    camels_log_enabled = false;
+
+    camels_start_game(&session, seats, 12);
+    int legs = 0, turns = 0;
+    bool over = false;
+    while (!session_over(&session)) {
+        int n = camels_poll_events(&session, events, 4);
+        for (int i = 0; i < n; i++) {
+            legs += events[i].type == EV_LEG_SCORED;
+            turns += events[i].type == EV_TURN;
+            over = over || events[i].type == EV_GAME_OVER;
+        }
+    }
+    camels_log_enabled = saved;
+
+    mu_assert("Game should finish", over && session.game.winner);
+    mu_assert("Every turn is reported", turns == session.game.turn);
+    mu_assert("Every leg is scored", legs == session.game.round);
+
+    return 0;
+}
+
+//////////////////////////////////// Fork Tests //////////////////////////////////////
+
+// same camels in the same stack order on every tile
+static bool same_board(Game* a, Game* b) {
+    for (int i = 0; i < BOARD_SIZE; i++) {
+        CamelStack* sa = &a->board[i].camel_stack;
+        CamelStack* sb = &b->board[i].camel_stack;
+        if (sa->count != sb->count || a->board[i].has_spec != b->board[i].has_spec) {
+            return false;
+        }
+        for (size_t j = 0; j < sa->count; j++) {
+            if (sa->items[j].color != sb->items[j].color || sa->items[j].space != sb->items[j].space) {
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+static char* test_fork_roll_matches_move_camel(void) {
+    Game* game = setup_game();
+    Spectator spec = {.player = 3, .orientation = REVERSE};
+    place_spec_tile(game, 3, 4, spec);
+
+    GameFork root, child;
+    fork_from_game(&root, game);
+    fork_game(&root, &child);
+    mu_assert("Fork shares the board", child.board == root.board && root.board->refs == 2);
+
+    Roll die = {.color = CYELLOW, .value = 2}; // 2 -> 4 hits the spectator
+    fork_roll(&child, die);
+    mu_assert("Child owns a new board", child.board != root.board);
+    mu_assert("Untouched tiles stay shared", child.board->tiles[10] == root.board->tiles[10]);
+    mu_assert("Tickets stay shared", child.tickets == root.tickets);
+
+    static Game expected, from_child, from_root;
+    expected = *game;
+    stack_push(&expected.dice, die);
+    move_camel(&expected, die.color, die.value);
+    fork_to_game(&child, &from_child);
+    fork_to_game(&root, &from_root);
+
+    mu_assert("Child should match move_camel", same_board(&expected, &from_child));
+    mu_assert("Spectator point goes to the child", from_child.players[3].points == expected.players[3].points);
+    mu_assert("Parent is unchanged", same_board(game, &from_root) && from_root.players[3].points == 0);
+
+    mu_assert("Child board borrows from the root", child.board->parent == root.board);
+    fork_release(&child);
+    mu_assert("Root board goes back to one owner", root.board->refs == 1);
+    fork_release(&root);
+
+    return 0;
+}
+
+static char* test_fork_tickets_and_wagers(void) {
+    Game* game = setup_game();
+    GameFork root, a, b;
+    fork_from_game(&root, game);
+    fork_game(&root, &a);
+    fork_game(&root, &b);
+
+    mu_assert("Fork takes the 5 ticket", fork_take_ticket(&a, BRED, 1) == 5);
+    mu_assert("Sibling still sees the 5 ticket", fork_take_ticket(&b, BRED, 2) == 5);
+    mu_assert("Fork can wager", fork_wager(&a, 1, BGREEN, FORWARD));
+    mu_assert("Card is spent in the fork", !fork_wager(&a, 1, BGREEN, REVERSE));
+    mu_assert("Parent keeps the card", has_card_in_hand(&root.players->players[1], BGREEN));
+    mu_assert("Board was never copied", a.board == root.board && b.board == root.board);
+
+    fork_release(&a);
+    fork_release(&b);
+    fork_release(&root);
+    return 0;
+}
+
+//////////////////////////////////// Leg Odds Tests //////////////////////////////////////
+
+// a position two rolls into the leg, keeps the exact walk small
+static Game* setup_leg(void) {
+    Game* game = setup_game();
+    Roll rolls[2] = {{.color = CYELLOW, .value = 2}, {.color = CBLACK, .value = -1}};
+    for (int i = 0; i < 2; i++) {
+        stack_push(&game->dice, rolls[i]);
+        move_camel(game, (CamelColor) rolls[i].color, rolls[i].value);
+    }
+    return game;
+}
+
+static bool close_to(double a, double b) { return fabs(a - b) < 1e-9; }
+
+// swaps the labels of two racing camels everywhere they appear
+static void swap_colors(Game* game, CamelColor a, CamelColor b) {
+    for (int i = 0; i < BOARD_SIZE; i++) {
+        CamelStack* stack = &game->board[i].camel_stack;
+        for (size_t j = 0; j < stack->count; j++) {
+            if (stack->items[j].color == a || stack->items[j].color == b) {
+                stack->items[j].color = (uint8_t) (stack->items[j].color == a ? b : a);
+            }
+        }
+    }
+    for (size_t i = 0; i < game->dice.count; i++) {
+        if (game->dice.items[i].color == a || game->dice.items[i].color == b) {
+            game->dice.items[i].color = (uint8_t) (game->dice.items[i].color == a ? b : a);
+        }
+    }
+}
+
+static char* test_leg_odds_exact(void) {
+    Game* game = setup_leg();
+    LegOdds odds, cached;
+    leg_odds(game, &odds);
+
+    double first = 0.0, second = 0.0;
+    for (int c = 0; c < N_BETS_COLORS; c++) {
+        first += odds.first[c];
+        second += odds.second[c];
+    }
+    mu_assert("First place odds should sum to 1", close_to(first, 1.0));
+    mu_assert("Second place odds should sum to 1", close_to(second, 1.0));
+
+    LegCache cache;
+    mu_assert("Cache should allocate", leg_cache_init(&cache, 12, true));
+    cached_leg_odds(&cache, game, &cached);
+    for (int c = 0; c < N_BETS_COLORS; c++) {
+        mu_assert("Cached walk should match the plain walk",
+                  close_to(odds.first[c], cached.first[c]) && close_to(odds.second[c], cached.second[c]));
+    }
+    mu_assert("Dice orders should meet in the same positions", cache.hits > 0);
+    leg_cache_free(&cache);
+
+    return 0;
+}
+
+static char* test_leg_key_relabel(void) {
+    Game* game = setup_leg();
+    static Game relabeled;
+    relabeled = *game;
+    swap_colors(&relabeled, CRED, CGREEN);
+    swap_colors(&relabeled, CBLACK, CWHITE);
+
+    LegKey key, other;
+    uint8_t perm[N_BETS_COLORS], other_perm[N_BETS_COLORS];
+    leg_key(game, true, &key, perm);
+    leg_key(&relabeled, true, &other, other_perm);
+    mu_assert("Relabelings should share a canonical key", memcmp(&key, &other, sizeof(LegKey)) == 0);
+    mu_assert("Swapped colors should swap labels", perm[CRED] == other_perm[CGREEN]);
+    leg_key(game, false, &key, perm);
+    leg_key(&relabeled, false, &other, other_perm);
+    mu_assert("Color keys should tell them apart", memcmp(&key, &other, sizeof(LegKey)) != 0);
+
+    LegCache cache;
+    LegOdds odds, swapped;
+    leg_cache_init(&cache, 12, true);
+    cached_leg_odds(&cache, game, &odds);
+    uint64_t misses = cache.misses;
+    cached_leg_odds(&cache, &relabeled, &swapped);
+    mu_assert("Relabeled position should be a cache hit", cache.misses == misses);
+    mu_assert("Odds should follow the camels",
+              close_to(odds.first[CRED], swapped.first[CGREEN]) && close_to(odds.second[CGREEN], swapped.second[CRED]));
+    mu_assert("Untouched colors keep their odds", close_to(odds.first[CBLUE], swapped.first[CBLUE]));
+    leg_cache_free(&cache);
+
+    return 0;
+}
+
+static char* test_approx_leg_odds(void) {
+    Game* game = setup_leg();
+    LegOdds exact, approx;
+    leg_odds(game, &exact);
+    camels_approx_leg_odds(game, &approx);
+
+    double first = 0.0, second = 0.0, last = 0.0;
+    int best = 0, best_exact = 0;
+    for (int c = 0; c < N_BETS_COLORS; c++) {
+        first += approx.first[c];
+        second += approx.second[c];
+        last += approx.last[c];
+        best       = approx.first[c] > approx.first[best] ? c : best;
+        best_exact = exact.first[c] > exact.first[best_exact] ? c : best_exact;
+        mu_assert("Approximate odds should stay near the exact walk",
+                  fabs(approx.first[c] - exact.first[c]) < 0.15 && fabs(approx.second[c] - exact.second[c]) < 0.15 &&
+                      fabs(approx.last[c] - exact.last[c]) < 0.15);
+    }
+    mu_assert("Approximate odds should sum to 1", fabs(first - 1.0) < 1e-5 && fabs(second - 1.0) < 1e-5 &&
+                                                      fabs(last - 1.0) < 1e-5);
+    mu_assert("Approximate favorite should be the exact favorite", best == best_exact);
+
+    // nothing left to approximate once the leg is over
+    Game* done = setup_game();
+    for (int c = 0; c < N_DICE; c++) {
+        Roll roll = {.color = (uint8_t) c, .value = 1};
+        stack_push(&done->dice, roll);
+    }
+    leg_odds(done, &exact);
+    camels_approx_leg_odds(done, &approx);
+    mu_assert("Finished leg should be exact", close_to(exact.first[CRED], approx.first[CRED]));
+
+    return 0;
+}
+
+static char* test_leg_tracker(void) {
+    Game* game = setup_leg();
+    LegTracker tracker;
+    LegOdds odds, exact;
+    mu_assert("Tracker should allocate", camels_leg_tracker_init(&tracker, 14));
+    camels_leg_tracker_odds(&tracker, game, &odds);
+    uint64_t walked = tracker.cache.misses;
+
+    Turn ticket = {.turn_type = TICKET, .color = BRED};
+    mu_assert("Ticket should be taken", next_turn(game, &ticket, 0));
+    camels_leg_tracker_odds(&tracker, game, &odds);
+    mu_assert("A ticket should be answered from the root", tracker.root_hits == 1);
+
+    Turn roll = {.turn_type = ROLL};
+    mu_assert("Roll should be played", next_turn(game, &roll, 1));
+    camels_leg_tracker_odds(&tracker, game, &odds);
+    mu_assert("A roll should land on a position already walked", tracker.cache.misses == walked);
+    leg_odds(game, &exact);
+    for (int c = 0; c < N_BETS_COLORS; c++) {
+        mu_assert("Re-rooted odds should match a fresh walk",
+                  close_to(odds.first[c], exact.first[c]) && close_to(odds.last[c], exact.last[c]));
+    }
+    camels_leg_tracker_free(&tracker);
+
+    return 0;
+}
+
+//////////////////////////////////// Tablebase Tests //////////////////////////////////////
+
+static char* test_tablebase_index(void) {
+    static Game game;
+    for (uint32_t i = 0; i < tb_entries(4); i++) {
+        uint8_t order[N_BETS_COLORS];
+        uint32_t index;
+        tb_position(&game, 4, i);
+        mu_assert("Position should be in the table", tb_index(&game, 4, order, &index));
+        mu_assert("Index should round trip", index == i);
+        mu_assert("Labels follow reading order", order[0] == 0 && order[4] == 4);
+    }
+    mu_assert("Five camels in one tile", tb_entries(1) == 1);
+    mu_assert("Five camels in three tiles", tb_entries(3) == 21);
+
+    return 0;
+}
+
+static char* test_tablebase_odds(void) {
+    const char* path = "build/test/tablebase.bin";
+    uint32_t entries;
+    mu_assert("Generate should succeed", camels_tablebase_generate(path, 3, &entries));
+    mu_assert("Should solve every position", entries == tb_entries(3));
+    Tablebase tb;
+    mu_assert("Open should succeed", camels_tablebase_open(&tb, path));
+
+    // one stack on the last tile: whichever die moves first carries the top camel over the line
+    static Game game;
+    tb_position(&game, 3, entries - 1);
+    swap_colors(&game, CRED, CPURPLE);
+    double p_first[N_BETS_COLORS], p_last[N_BETS_COLORS];
+    mu_assert("Stack on the last tile is in the table", camels_tablebase_odds(&tb, &game, p_first, p_last));
+    mu_assert("Top camel always wins", close_to(p_first[CRED], 1.0));
+    mu_assert("Bottom camel always loses", close_to(p_last[CPURPLE], 1.0));
+
+    // crazy camels parked behind the pack keep a live position in the table
+    tb_position(&game, 3, 7);
+    for (int c = CWHITE; c <= CBLACK; c++) {
+        Camel crazy = {.color = (uint8_t) c, .orientation = REVERSE, .space = 2};
+        stack_push(&game.board[2].camel_stack, crazy);
+    }
+    WagerValue values[N_BETS_COLORS];
+    Rng rng          = {.state = 3};
+    camels_tablebase = &tb;
+    mu_assert("Parked crazies should be answered exactly", value_wagers(&game, 0, &rng, WAGER_BUDGET_MS, values) == 0);
+    mu_assert("Exact odds come from the entry", fabs(values[2].p_first - tb.table[7].first[2]) < 1e-6);
+    mu_assert("Crazies near the finish fall back to sampling",
+              value_wagers(setup_game(), 0, &rng, WAGER_BUDGET_MS, values) > 0);
+    camels_tablebase = NULL;
+    tablebase_close(&tb);
+
+    mu_assert("Missing file should fail", !camels_tablebase_open(&tb, "build/test/no_such_tablebase.bin"));
+
+    return 0;
+}
+
+//////////////////////////////////// Race Ranking Tests //////////////////////////////////////
+
+static bool same_camels(Game* a, Game* b) {
+    for (int t = 0; t < BOARD_SIZE; t++) {
+        CamelStack* x = &a->board[t].camel_stack;
+        CamelStack* y = &b->board[t].camel_stack;
+        if (x->count != y->count || memcmp(x->items, y->items, x->count * sizeof(Camel)) != 0) {
+            return false;
+        }
+    }
+    return a->winner == b->winner;
+}
+
+static char* test_race_rank_roundtrip(void) {
+    static Game game;
+    uint64_t n = race_configurations(true);
+    mu_assert("Seven camels on seventeen tiles", race_configurations(false) == 245157ull * 5040);
+    mu_assert("Every dice mask but the empty one", n == race_configurations(false) * 63);
+
+    Rng rng = {.state = 11};
+    for (int i = 0; i < 20000; i++) {
+        uint64_t rank = i < 2 ? (i == 0 ? 0 : n - 1) : rng_next(&rng) % n;
+        race_unrank(rank, true, &game);
+        mu_assert("Rank should round trip", race_rank(&game, true) == rank);
+        mu_assert("Without dice the rank drops its lowest digit", race_rank(&game, false) == rank / 63);
+    }
+    race_unrank(n - 1, true, &game);
+    mu_assert("Last rank stacks every camel on the finish", game.board[BOARD_SIZE - 1].camel_stack.count == N_CAMELS);
+    mu_assert("Last rank has a winner and every die left", game.winner && game.dice.count == 0);
+
+    return 0;
+}
+
+static char* test_race_rank_positions(void) {
+    static Game game, back;
+    for (uint64_t seed = 0; seed < 20; seed++) {
+        Rng rng         = {.state = seed};
+        camels_game_rng = &rng;
+        camels_init_game(&game);
+        while (!game.winner) {
+            if (game.dice.count == N_DICE) {
+                reset_dice(&game);
+            }
+            roll_dice(&game);
+            Roll die = game.dice.items[game.dice.count - 1];
+            move_camel(&game, (CamelColor) die.color, die.value);
+
+            uint64_t rank = race_rank(&game, true);
+            mu_assert("Rank should be in range", rank < race_configurations(true));
+            race_unrank(rank, true, &back);
+            mu_assert("Unrank should rebuild every stack", same_camels(&game, &back));
+            mu_assert("Unrank should leave the same dice", race_dice_left(&back) == race_dice_left(&game));
+        }
+        camels_game_rng = NULL;
+    }
+
+    return 0;
+}
+
+//////////////////////////////////// Pondering Tests //////////////////////////////////////
+
+// polls until the pondering thread reaches depth, gives up after a few seconds
+static bool wait_for_ponder(Ponder* p, int depth, PonderResult* out) {
+    struct timespec tick = {.tv_sec = 0, .tv_nsec = 1000000};
+    for (int i = 0; i < 5000; i++) {
+        if (camels_ponder_result(p, out) && out->depth >= depth) {
+            return true;
+        }
+        nanosleep(&tick, NULL);
+    }
+    return false;
+}
+
+static char* test_ponder_results(void) {
+    static Ponder p;
+    mu_assert("Pondering thread should start", camels_ponder_init(&p, NULL, NULL));
+    Game* game = setup_leg();
+    camels_ponder_start(&p, game, 2);
+
+    PonderResult r;
+    mu_assert("Analysis should finish", wait_for_ponder(&p, PONDER_DONE, &r));
+    mu_assert("Result should be for the position handed in", r.turn == game->turn && r.player_id == 2);
+    LegOdds exact;
+    leg_odds(game, &exact);
+    for (int c = 0; c < N_BETS_COLORS; c++) {
+        mu_assert("Finished analysis should carry exact leg odds", close_to(r.odds.first[c], exact.first[c]));
+    }
+    mu_assert("Hint should be a legal turn", next_turn(game, &r.hint, 2));
+    mu_assert("Hint should beat a roll", r.hint_ev >= 1.0);
+
+    camels_ponder_free(&p);
+    return 0;
+}
+
+static char* test_ponder_stop(void) {
+    static Ponder p;
+    mu_assert("Pondering thread should start", camels_ponder_init(&p, NULL, NULL));
+    Game* game = setup_leg();
+    PonderResult r;
+    camels_ponder_start(&p, game, 0);
+    camels_ponder_stop(&p);
+    mu_assert("Stopping should drop the result", !camels_ponder_result(&p, &r));
+
+    // the same thread picks up the next position
+    game->turn = 7;
+    camels_ponder_start(&p, game, 1);
+    mu_assert("Restarted analysis should finish", wait_for_ponder(&p, PONDER_DONE, &r));
+    mu_assert("Result should follow the new position", r.turn == 7 && r.player_id == 1);
+
+    camels_ponder_free(&p);
+    return 0;
+}
+
+//////////////////////////////////// Batch Evaluation Tests //////////////////////////////////////
+
+#define TEST_BATCH 40
+
+// dealt games a few rolls into their first leg, so exact walks stay quick
+static Game* setup_batch_game(int i) {
+    static Game game;
+    Rng rng = {.state = (uint64_t) i};
+    memset(&game, 0, sizeof(Game));
+    camels_game_rng = &rng;
+    camels_init_game(&game);
+    camels_game_rng = NULL;
+    for (int r = 0; r < 2 + i % 3; r++) {
+        sim_roll(&game, &rng);
+    }
+    if (i % 4 == 0) {
+        place_spec_tile(&game, 0, 10, (Spectator) {.player = 0, .orientation = REVERSE});
+    }
+    take_ticket(&game.tickets[i % N_BETS_COLORS], 1);
+    return &game;
+}
+
+static char* test_batch_roundtrip(void) {
+    PositionBatch batch;
+    mu_assert("Batch should allocate", position_batch_alloc(&batch, 2));
+    static Game rebuilt;
+    for (int i = 0; i < 4; i++) {
+        Game* game = setup_batch_game(i);
+        batch.count = 0;
+        mu_assert("Row should fit", position_batch_push(&batch, game));
+        position_batch_game(&batch, 0, &rebuilt);
+
+        LegKey key, other;
+        uint8_t perm[N_BETS_COLORS];
+        leg_key(game, false, &key, perm);
+        leg_key(&rebuilt, false, &other, perm);
+        mu_assert("Rebuilt race should have the same key", memcmp(&key, &other, sizeof(LegKey)) == 0);
+        mu_assert("Top ticket should be recorded", batch.ticket[i % N_BETS_COLORS][0] == 3);
+    }
+    batch.count = 2;
+    mu_assert("Full batch should refuse a row", !position_batch_push(&batch, setup_game()));
+    position_batch_free(&batch);
+
+    return 0;
+}
+
+static char* test_batch_eval(void) {
+    PositionBatch batch;
+    BatchOdds out;
+    EvalPool pool;
+    mu_assert("Batch should allocate", position_batch_alloc(&batch, TEST_BATCH) && batch_odds_alloc(&out, TEST_BATCH));
+    mu_assert("Pool should start", eval_pool_init(&pool, 3));
+    for (int i = 0; i < TEST_BATCH; i++) {
+        position_batch_push(&batch, setup_batch_game(i));
+    }
+
+    eval_pool_run(&pool, &batch, &out, true);
+    for (int i = 0; i < TEST_BATCH; i++) {
+        LegOdds exact;
+        leg_odds(setup_batch_game(i), &exact);
+        for (int c = 0; c < N_BETS_COLORS; c++) {
+            mu_assert("Batch odds should match a single walk", fabs(out.first[c][i] - exact.first[c]) < 1e-5 &&
+                                                                  fabs(out.last[c][i] - exact.last[c]) < 1e-5);
+        }
+        int c      = i % N_BETS_COLORS;
+        double ev  = ticket_ev(3, exact.first[c], exact.second[c]);
+        mu_assert("Ticket EV should price the ticket left on top", fabs(out.ticket_ev[c][i] - ev) < 1e-4);
+    }
+
+    eval_pool_run(&pool, &batch, &out, false);
+    LegOdds approx;
+    camels_approx_leg_odds(setup_batch_game(7), &approx);
+    mu_assert("Approximate batch should match approx_leg_odds", fabs(out.second[CGREEN][7] - approx.second[CGREEN]) < 1e-6);
+
+    eval_pool_free(&pool);
+    position_batch_free(&batch);
+    batch_odds_free(&out);
+    return 0;
+}
+
+//////////////////////////////////// Shared Memory Query Tests //////////////////////////////////////
+
+#define TEST_SHM_PATH "build/test/shm.ring"
+
+static char* test_shm_query(void) {
+    ShmServer server;
+    ShmMap map;
+    mu_assert("Server should start", shm_server_start(&server, TEST_SHM_PATH, 2));
+    mu_assert("Client should map the ring", shm_client_open(&map, TEST_SHM_PATH));
+
+    Game* game = setup_leg();
+    ShmAnswer answer;
+    LegOdds expected;
+    mu_assert("Approximate query should be answered", shm_query(&map, game, 3, false, &answer));
+    camels_approx_leg_odds(game, &expected);
+    mu_assert("Answer should carry approximate odds", fabs(answer.first[CYELLOW] - expected.first[CYELLOW]) < 1e-6);
+
+    mu_assert("Exact query should be answered", shm_query(&map, game, 3, true, &answer));
+    leg_odds(game, &expected);
+    double ev = ticket_ev(5, expected.first[CBLUE], expected.second[CBLUE]);
+    mu_assert("Answer should carry exact ticket EVs", fabs(answer.ticket_ev[CBLUE] - ev) < 1e-5);
+    mu_assert("Hint should be a legal turn", next_turn(game, &answer.hint, 3));
+
+    // the slot is written in place, nothing is copied in
+    ShmSlot* slot   = shm_claim(&map);
+    slot->game      = *setup_leg();
+    slot->player_id = 0;
+    slot->exact     = 0;
+    mu_assert("In-place request should be answered", shm_submit(&map, slot));
+    camels_approx_leg_odds(setup_leg(), &expected);
+    mu_assert("In-place answer should match", fabs(slot->answer.first[CYELLOW] - expected.first[CYELLOW]) < 1e-6);
+    shm_release(slot);
+
+    shm_client_close(&map);
+    shm_server_stop(&server);
+    mu_assert("Client should refuse a file that is not a ring", !shm_client_open(&map, "build/test/tablebase.bin"));
+    return 0;
+}
+
+static char* test_shm_clients(void) {
+    ShmServer server;
+    mu_assert("Server should start", shm_server_start(&server, TEST_SHM_PATH, 2));
+    fflush(NULL);
+    pid_t clients[4];
+    for (int k = 0; k < 4; k++) {
+        clients[k] = fork();
+        if (clients[k] == 0) {
+            // each client checks its own answers against a local computation
+            ShmMap map;
+            bool ok = shm_client_open(&map, TEST_SHM_PATH);
+            for (int i = 0; i < 50 && ok; i++) {
+                Game* game = setup_batch_game(k * 50 + i);
+                ShmAnswer answer;
+                LegOdds expected;
+                camels_approx_leg_odds(game, &expected);
+                ok = shm_query(&map, game, k, false, &answer) && fabs(answer.last[CRED] - expected.last[CRED]) < 1e-6;
+            }
+            _exit(ok ? 0 : 1);
+        }
+    }
+    bool all_ok = true;
+    for (int k = 0; k < 4; k++) {
+        int status;
+        all_ok = waitpid(clients[k], &status, 0) == clients[k] && WIFEXITED(status) && WEXITSTATUS(status) == 0 && all_ok;
+    }
+    mu_assert("Every concurrent client should get its own answers", all_ok);
+    mu_assert("Every query should be served once", atomic_load(&server.served) == 200);
+    shm_server_stop(&server);
+    return 0;
+}
+
+//////////////////////////////////// Engine Protocol Tests //////////////////////////////////////
+
+// decodes a state with the given board, dice and clock fields and a fresh deal of everything else
+static bool decodes(const char* tiles, const char* dice, const char* clock) {
+    static Game game;
+    char state[ENGINE_LINE];
+    int to_move;
+    snprintf(state, sizeof(state), "%s %s //// 0:1f:0/0:1f:0/0:1f:0/0:1f:0/0:1f:0/0:1f:0 - - %s", tiles, dice, clock);
+    return camels_decode_game(state, &game, &to_move);
+}
+
+static char* test_engine_encoding(void) {
+    Game* game = setup_leg();
+    take_ticket(&game->tickets[BGREEN], 2);
+    game->board[9].has_spec = true;
+    game->board[9].spec     = (Spectator) {.player = 4, .orientation = REVERSE};
+    Wager wager             = {.player = 1, .color = CPURPLE};
+    stack_push(&game->loser_bets, wager);
+    game->players[1].hand &= (uint8_t) ~(1u << BPURPLE);
+    game->players[3].points = 7;
+    game->turn              = 5;
+
+    static Game decoded;
+    char first[ENGINE_LINE], second[ENGINE_LINE];
+    int to_move;
+    mu_assert("Position should encode", camels_encode_game(game, 3, first, sizeof(first)));
+    mu_assert("Encoded position should decode", camels_decode_game(first, &decoded, &to_move));
+    mu_assert("Decoded position should encode the same", camels_encode_game(&decoded, to_move, second, sizeof(second)));
+    mu_assert("Encoding should roundtrip", strcmp(first, second) == 0 && to_move == 3);
+
+    LegOdds want, got;
+    leg_odds(game, &want);
+    leg_odds(&decoded, &got);
+    mu_assert("Decoded position should have the same odds", close_to(want.first[BYELLOW], got.first[BYELLOW]));
+    mu_assert("Truncated position should be rejected", !camels_decode_game("RBYGPWK////", &decoded, &to_move));
+    mu_assert("A legal position should decode", decodes("RBYGP/WK//+1/////////////", "R2,W-1", "0 7 2"));
+    mu_assert("A spectator on the finish tile should be rejected", !decodes("RBYGP/WK///////////////+1", "-", "0 0 0"));
+    mu_assert("A spectator under camels should be rejected", !decodes("RBYGP+1/WK///////////////", "-", "0 0 0"));
+    mu_assert("Neighbouring spectators should be rejected", !decodes("RBYGP/WK//+2/+3////////////", "-", "0 0 0"));
+    mu_assert("Two spectators on a tile should be rejected", !decodes("RBYGP/WK//+2+3/////////////", "-", "0 0 0"));
+    mu_assert("A racing die cannot roll backwards", !decodes("RBYGP/WK///////////////", "R-2", "0 0 0"));
+    mu_assert("The crazy die cannot roll forwards", !decodes("RBYGP/WK///////////////", "W2", "0 0 0"));
+    mu_assert("A die cannot be rolled twice", !decodes("RBYGP/WK///////////////", "R1,R2", "0 0 0"));
+    mu_assert("Both crazy camels share one die", !decodes("RBYGP/WK///////////////", "W-1,K-2", "0 0 0"));
+    mu_assert("An overlong turn should be rejected", !decodes("RBYGP/WK///////////////", "-", "0 70000 0"));
+    mu_assert("An overlong round should be rejected", !decodes("RBYGP/WK///////////////", "-", "0 0 999"));
+    return 0;
+}
+
+static char* test_engine_session(void) {
+    static char commands[] = "isready\nposition startpos 3\nodds\nposition nonsense\ngo movetime 5\nquit\n";
+    FILE* in               = fmemopen(commands, strlen(commands), "r");
+    FILE* out              = tmpfile();
+    mu_assert("Engine should start", in != NULL && out != NULL && run_engine(in, out));
+
+    char reply[4096] = {0};
+    rewind(out);
+    size_t n = fread(reply, 1, sizeof(reply) - 1, out);
+    reply[n] = '\0';
+    fclose(in);
+    fclose(out);
+    mu_assert("Engine should answer isready", strstr(reply, "readyok\n") == reply);
+    mu_assert("Engine should report odds", strstr(reply, "\nodds first ") != NULL);
+    mu_assert("Engine should reject a bad position", strstr(reply, "\nerror bad position\n") != NULL);
+    mu_assert("A search should end with one bestmove", strstr(reply, "bestmove ") != NULL &&
+                                                           strstr(strstr(reply, "bestmove ") + 1, "bestmove ") == NULL);
+    return 0;
+}
+
+//////////////////////////////////// Library API Tests //////////////////////////////////////
+
+static char* test_api_bot_game(void) {
+    CamelsSeat seats[CAMELS_PLAYERS] = {CAMELS_GREEDY_BOT, CAMELS_RANDOM_BOT, CAMELS_GREEDY_BOT,
+                                        CAMELS_RANDOM_BOT, CAMELS_GREEDY_BOT, CAMELS_RANDOM_BOT};
+    CamelsGame* game                 = camels_new(11, seats);
+    mu_assert("Game should be created", game != NULL && camels_abi_version() == CAMELS_ABI_VERSION);
+
+    CamelsEvent events[16];
+    bool over = false;
+    for (int polls = 0; !over && polls < 10000; polls++) {
+        int n = camels_poll(game, events, 16);
+        for (int i = 0; i < n; i++) {
+            mu_assert("Bot seats should never wait for input", events[i].type != CAMELS_AWAIT_TURN);
+            over |= events[i].type == CAMELS_GAME_OVER;
+        }
+    }
+    mu_assert("Bots should finish the game", over && camels_to_move(game) == -1);
+    bool crossed = false;
+    for (int c = 0; c < CAMELS_COLORS; c++) {
+        crossed |= camels_space(game, c) == CAMELS_SPACES - 1;
+    }
+    mu_assert("A camel should have crossed the finish", crossed);
+    camels_free(game);
+    return 0;
+}
+
+static char* test_api_human_turns(void) {
+    CamelsSeat seats[CAMELS_PLAYERS] = {CAMELS_HUMAN};
+    CamelsGame* game                 = camels_new(5, seats);
+    CamelsEvent events[16];
+    int n = camels_poll(game, events, 16);
+    mu_assert("Human seat should be asked for a turn", n == 1 && events[0].type == CAMELS_AWAIT_TURN &&
+                                                           events[0].player == 0 && camels_to_move(game) == 0);
+
+    CamelsTurn turns[CAMELS_MAX_TURNS];
+    int options = camels_legal_turns(game, 0, turns);
+    mu_assert("Opening should offer every kind of turn", options > 2 * CAMELS_COLORS);
+    mu_assert("Out of range seats should have no turns",
+              camels_legal_turns(game, -1, turns) == 0 && camels_legal_turns(game, CAMELS_PLAYERS, turns) == 0);
+    mu_assert("Out of range seats and camels should read -1",
+              camels_points(game, CAMELS_PLAYERS) == -1 && camels_space(game, CAMELS_COLORS) == -1 &&
+                  camels_space(game, -1) == -1);
+    CamelsTurn ticket = {.type = CAMELS_TICKET, .color = CAMELS_GREEN};
+    mu_assert("Out of turn submit should be refused", !camels_submit(game, 1, &ticket));
+
+    CamelsGame* copy = camels_clone(game);
+    mu_assert("Ticket should be taken", camels_submit(game, 0, &ticket));
+    mu_assert("Next seat should be up", camels_to_move(game) == 1 && camels_to_move(copy) == 0);
+
+    char state[CAMELS_STATE_SIZE], reloaded[CAMELS_STATE_SIZE];
+    mu_assert("State should fit", camels_state(game, state, sizeof(state)));
+    CamelsGame* loaded = camels_load(state);
+    mu_assert("State should load", loaded != NULL && camels_state(loaded, reloaded, sizeof(reloaded)));
+    mu_assert("Loaded game should be the same position", strcmp(state, reloaded) == 0);
+    mu_assert("Garbage should not load", camels_load("camels") == NULL);
+
+    CamelsOdds odds;
+    camels_leg_odds(loaded, &odds);
+    double total = 0;
+    for (int c = 0; c < CAMELS_COLORS; c++) {
+        total += odds.first[c];
+    }
+    mu_assert("Leg odds should sum to one", fabs(total - 1.0) < 1e-9);
+    camels_free(loaded);
+    camels_free(copy);
+    camels_free(game);
+    return 0;
+}
+
+//////////////////////////////////// Sequential Sampling Tests //////////////////////////////////////
+
+static char* test_race_odds_within(void) {
+    Game* game = setup_game();
+    Rng rng    = {.state = 3};
+    double p_first[N_BETS_COLORS], p_last[N_BETS_COLORS];
+    double ref_first[N_BETS_COLORS], ref_last[N_BETS_COLORS];
+
+    int close = race_odds_within(game, &rng, SEQ_WATCH_ALL, 0.02, 0.95, 100000, p_first, p_last);
+    race_odds(game, &rng, 1e9, 40000, ref_first, ref_last);
+    for (int c = 0; c < N_BETS_COLORS; c++) {
+        mu_assert("Estimate should be near a long run", fabs(p_first[c] - ref_first[c]) < 0.03);
+        mu_assert("Estimate should be near a long run", fabs(p_last[c] - ref_last[c]) < 0.03);
+    }
+    mu_assert("Close race should need more than the minimum", close > SEQ_MIN_SAMPLES && close < 100000);
+
+    // GREEN one tile from the finish, away from the pack
+    move_camel(game, CGREEN, (BOARD_SIZE - 2) - get_camel(game, CGREEN)->space);
+    int clear = race_odds_within(game, &rng, SEQ_WATCH_FIRST(BGREEN), 0.02, 0.95, 100000, p_first, p_last);
+    mu_assert("Clear-cut race should stop much sooner", clear * 4 < close && p_first[BGREEN] > 0.9);
+    mu_assert("Watching nothing should play nothing",
+              race_odds_within(game, &rng, 0, 0.02, 0.95, 100000, p_first, p_last) == 0 && p_first[BGREEN] <= 0.0);
+    return 0;
+}
+
+static char* test_race_compare(void) {
+    Game* game = setup_game();
+    Rng rng    = {.state = 5};
+    move_camel(game, CGREEN, (BOARD_SIZE - 6) - get_camel(game, CGREEN)->space);
+
+    Bet leader   = {.kind = BET_TICKET, .color = BGREEN};
+    Bet trailing = {.kind = BET_TICKET, .color = BRED};
+    Comparison c = race_compare(game, &rng, leader, trailing, 0.1, 0.95, 100000);
+    mu_assert("Leader's ticket should be better", c.verdict == 1 && c.samples == SEQ_MIN_SAMPLES);
+    c = race_compare(game, &rng, trailing, leader, 0.1, 0.95, 100000);
+    mu_assert("Order of the bets should flip the verdict", c.verdict == -1);
+
+    c = race_compare(game, &rng, leader, leader, 0.1, 0.95, 100000);
+    mu_assert("A bet should tie with itself at the first check", c.verdict == 0 && c.samples == SEQ_MIN_SAMPLES);
+    c = race_compare(game, &rng, leader, leader, 0.0, 0.95, 2000);
+    mu_assert("Without a margin a tie should run to max_samples", c.verdict == 0 && c.samples == 2000);
+    return 0;
+}
+
+//////////////////////////////////// Variance Reduction Tests //////////////////////////////////////
+
+static char* test_sampler_draws(void) {
+    Game* game = setup_game();
+    Rng rng    = {.state = 4};
+    DiceSampler s;
+
+    // one round of strata is every ordered pair of the first two dice exactly once
+    sampler_init(&s, SAMPLE_STRATIFIED, game, &rng);
+    int round = sampler_round(&s);
+    mu_assert("A fresh leg should have 6 * 5 orders", round == (N_DICE + 1) * N_DICE);
+    int seen[N_DICE + 1][N_DICE + 1] = {{0}};
+    for (int i = 0; i < round; i++) {
+        sampler_begin(&s, (uint64_t) i);
+        int first = sampler_draw(&s, DRAW_DIE, N_DICE + 1);
+        sampler_draw(&s, DRAW_CRAZY, 2);
+        sampler_draw(&s, DRAW_VALUE, 3);
+        seen[first][sampler_draw(&s, DRAW_DIE, N_DICE)]++;
+    }
+    bool each_once = true;
+    for (int a = 0; a <= N_DICE; a++) {
+        for (int b = 0; b < N_DICE; b++) {
+            each_once &= seen[a][b] == 1;
+        }
+    }
+    mu_assert("Each order should come up once per round", each_once);
+
+    // the second playout of a pair replays the first with face values mirrored
+    sampler_init(&s, SAMPLE_ANTITHETIC, game, &rng);
+    int draws[2][12];
+    for (int i = 0; i < 2; i++) {
+        sampler_begin(&s, (uint64_t) i);
+        for (int d = 0; d < 12; d++) {
+            draws[i][d] = sampler_draw(&s, (DrawKind) (d % 3), 3);
+        }
+    }
+    bool mirrored = true;
+    for (int d = 0; d < 12; d++) {
+        mirrored &= draws[1][d] == (d % 3 == DRAW_VALUE ? 2 - draws[0][d] : draws[0][d]);
+    }
+    mu_assert("Antithetic pair should mirror only the values", mirrored);
+    return 0;
+}
+
+static char* test_sampler_unbiased(void) {
+    Game* game = setup_game();
+    Rng rng    = {.state = 8};
+    double ref_first[N_BETS_COLORS], ref_last[N_BETS_COLORS];
+    race_odds(game, &rng, 1e9, 40000, ref_first, ref_last);
+
+    for (int mode = 0; mode < N_SAMPLE_MODES; mode++) {
+        DiceSampler s;
+        double p_first[N_BETS_COLORS], p_last[N_BETS_COLORS];
+        sampler_init(&s, (SampleMode) mode, game, &rng);
+        int n = race_odds_sampled(game, &s, 8000, p_first, p_last);
+        mu_assert("Samples should be whole rounds", n % sampler_round(&s) == 0 && n > 7900);
+        for (int c = 0; c < N_BETS_COLORS; c++) {
+            mu_assert("Every mode should agree with plain sampling", fabs(p_first[c] - ref_first[c]) < 0.03);
+            mu_assert("Every mode should agree with plain sampling", fabs(p_last[c] - ref_last[c]) < 0.03);
+        }
+    }
+    return 0;
+}
+
+//////////////////////////////////// Expectimax Search Tests //////////////////////////////////////
+
+// red far clear of the pack with its own die, purple's and grey left; nobody has a wager card or a spectator
+// tile left
+static Game* setup_search(void) {
+    Game* game = setup_game();
+    for (int b = 0; b < BOARD_SIZE; b++) {
+        game->board[b].camel_stack.count = 0;
+    }
+    int spaces[N_CAMELS] = {10, 0, 1, 2, 2, 14, 15}; // by CamelColor
+    for (int c = 0; c < N_CAMELS; c++) {
+        Camel camel = {.color       = (uint8_t) c,
+                       .orientation = c < N_BETS_COLORS ? FORWARD : REVERSE,
+                       .space       = (int8_t) spaces[c]};
+        stack_push(&game->board[spaces[c]].camel_stack, camel);
+    }
+    Roll rolls[3] = {{.color = CBLUE, .value = 1}, {.color = CYELLOW, .value = 1}, {.color = CGREEN, .value = 1}};
+    for (int i = 0; i < 3; i++) {
+        stack_push(&game->dice, rolls[i]);
+    }
+    for (int p = 0; p < N_PLAYERS; p++) {
+        game->players[p].used_spec = true;
+        game->players[p].hand      = 0;
+    }
+    return game;
+}
+
+static char* test_search_sure_ticket(void) {
+    SearchMode modes[2] = {SEARCH_MAXN, SEARCH_PARANOID};
+    for (int m = 0; m < 2; m++) {
+        static Searcher s;
+        SearchConfig config = {.mode = modes[m], .budget_ms = 50.0};
+        mu_assert("Searcher should allocate its table", camels_searcher_init(&s, config));
+        Turn turn;
+        camels_searcher = &s;
+        camels_bot_expectimax(setup_search(), 2, NULL, &turn);
+        camels_searcher = NULL;
+        mu_assert("Should take the leader's 5 ticket", turn.turn_type == TICKET && turn.color == BRED);
+        mu_assert("Should finish at least two iterations", s.stats.depth >= 2);
+        mu_assert("Should report its speed", s.stats.nodes > 0 && s.stats.nodes_per_second > 0.0);
+        mu_assert("Should stay near the budget", s.stats.seconds < 0.5);
+        camels_searcher_free(&s);
+    }
+
+    Turn turn;
+    camels_bot_expectimax(setup_search(), 2, NULL, &turn);
+    mu_assert("Without a searcher the bot rolls", turn.turn_type == ROLL);
+
+    return 0;
+}
+
+static char* test_search_pruning_exact(void) {
+    static Searcher pruned, full;
+    SearchMode modes[2] = {SEARCH_MAXN, SEARCH_PARANOID};
+    for (int m = 0; m < 2; m++) {
+        for (int player = 0; player < N_PLAYERS; player += 2) {
+            SearchConfig config = {.mode = modes[m], .budget_ms = 1e6, .max_depth = 3};
+            mu_assert("Searcher should allocate its table", camels_searcher_init(&pruned, config));
+            config.exhaustive = true;
+            mu_assert("Searcher should allocate its table", camels_searcher_init(&full, config));
+
+            Turn a, b;
+            search_best(&pruned, setup_search(), player, &a);
+            search_best(&full, setup_search(), player, &b);
+            mu_assert("Both should finish the depth asked for", pruned.stats.depth == 3 && full.stats.depth == 3);
+            mu_assert("Cuts and the table should not change the value",
+                      fabs(pruned.stats.value - full.stats.value) < 1e-9);
+            mu_assert("Cuts and the table should only save nodes", pruned.stats.nodes <= full.stats.nodes);
+            if (modes[m] == SEARCH_PARANOID) {
+                mu_assert("Paranoid should cut", pruned.stats.cutoffs + pruned.stats.probe_cutoffs > 0);
+            }
+            camels_searcher_free(&pruned);
+            camels_searcher_free(&full);
+        }
+    }
+
+    return 0;
+}
+
+//////////////////////////////////// Tournament Tests //////////////////////////////////////
+
+static char* test_tournament_seatings(void) {
+    uint8_t seatings[TOURNAMENT_SEATINGS];
+    mu_assert("Should be C(6, 3) seatings", tournament_seatings(seatings) == TOURNAMENT_SEATINGS);
+    int seat_count[N_PLAYERS] = {0};
+    for (int s = 0; s < TOURNAMENT_SEATINGS; s++) {
+        for (int p = 0; p < N_PLAYERS; p++) {
+            seat_count[p] += (seatings[s] >> p & 1u) ? 1 : 0;
+        }
+    }
+    for (int p = 0; p < N_PLAYERS; p++) {
+        mu_assert("Each side should sit in every seat half the time", seat_count[p] == TOURNAMENT_SEATINGS / 2);
+    }
+
+    // common random numbers: a policy against itself splits every deal exactly
+    static TournamentConfig config = {.deals = 4, .threads = 2, .seed = 3, .n_entrants = 2};
+    config.entrants[0]             = (Entrant) {"random", camels_bot_random};
+    config.entrants[1]             = (Entrant) {"random too", camels_bot_random};
+    static TournamentResult result;
+    mu_assert("Tournament should run", camels_tournament(&config, &result));
+    mu_assert("Every pair should play every seating", result.games == 4 * TOURNAMENT_SEATINGS);
+    mu_assert("Mirror match should score exactly half", close_to(result.score[0][1], 0.5));
+    mu_assert("Mirror match should rate level", fabs(result.elo[0] - result.elo[1]) < 1e-6);
+    mu_assert("Four batches should take the t quantile for 3 degrees of freedom", close_to(student_t95(3), 3.182));
+    mu_assert("Full batches should take the t quantile for 15 degrees of freedom",
+              close_to(student_t95(TOURNAMENT_BATCHES - 1), 2.131));
+    return 0;
+}
+
+static char* test_tournament_ratings(void) {
+    static TournamentConfig config = {.deals = 32, .threads = 1, .seed = 11, .n_entrants = 3};
+    memcpy(config.entrants, camels_builtin_entrants, sizeof(camels_builtin_entrants));
+    static TournamentResult serial, parallel;
+    mu_assert("Tournament should run", camels_tournament(&config, &serial));
+    config.threads = 3;
+    mu_assert("Tournament should run", camels_tournament(&config, &parallel));
+
+    mu_assert("Thread count should not change the scores", close_to(serial.score[1][2], parallel.score[1][2]));
+    mu_assert("Scores of a pair should add to one", close_to(serial.score[0][1] + serial.score[1][0], 1.0));
+    mu_assert("Greedy should beat random beyond the interval",
+              serial.elo[1] - serial.elo_ci[1] > serial.elo[0] + serial.elo_ci[0]);
+    mu_assert("Ratings should be centred", fabs(serial.elo[0] + serial.elo[1] + serial.elo[2]) < 1e-6);
+    return 0;
+}
+
+//////////////////////////////////// Placement Tests //////////////////////////////////////
+
+static void* pinned_thread(void* arg) {
+    int* node = arg;
+    *node     = placement_enter(0);
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    pthread_getaffinity_np(pthread_self(), sizeof(set), &set);
+    return CPU_COUNT(&set) == 1 ? arg : NULL;
+}
+
+static char* test_placement_pinning(void) {
+    const Topology* topo = get_topology();
+    mu_assert("Should find at least one usable cpu", topo->n_cpus >= 1 && topo->n_nodes >= 1);
+    int on_nodes = 0;
+    for (int n = 0; n < topo->n_nodes; n++) {
+        on_nodes += topo->node_cpus[n];
+    }
+    mu_assert("Every cpu should be on a node", on_nodes == topo->n_cpus);
+
+    // pin on a thread of its own so the test runner keeps every core
+    bool saved    = placement.pin;
+    placement.pin = true;
+    int node      = -1;
+    void* pinned  = NULL;
+    pthread_t thread;
+    pthread_create(&thread, NULL, pinned_thread, &node);
+    pthread_join(thread, &pinned);
+    placement.pin = saved;
+    mu_assert("Pinned thread should run on one cpu", pinned != NULL);
+    mu_assert("Pinned thread should be on its cpu's node", node == topo->node_of[0]);
+
+    WorkerBlock* block = worker_block_get(node);
+    mu_assert("Worker block should be allocated", block != NULL && block->node == node);
+    worker_block_put(block);
+    mu_assert("Node pool should hand the block back", worker_block_get(node) == block);
+    worker_block_put(block);
+    return 0;
+}
+
+static char* test_huge_alloc(void) {
+    HugeRegion big, small;
+    mu_assert("Large table should be allocated", huge_alloc(&big, 3 * HUGE_PAGE_BYTES + 100));
+    mu_assert("Mapped table should sit on a huge page boundary",
+              big.size == 0 || (big.size >= 3 * HUGE_PAGE_BYTES + 100 && (uintptr_t) big.base % HUGE_PAGE_BYTES == 0));
+    uint8_t* bytes = big.base;
+    mu_assert("Table should start zeroed", bytes[0] == 0 && bytes[3 * HUGE_PAGE_BYTES + 99] == 0);
+    bytes[3 * HUGE_PAGE_BYTES + 99] = 1;
+    huge_free(&big);
+
+    bool saved           = placement.huge_pages;
+    placement.huge_pages = false;
+    mu_assert("Disabled huge pages should fall back to the heap", huge_alloc(&small, 3 * HUGE_PAGE_BYTES));
+    placement.huge_pages = saved;
+    mu_assert("Fallback should be plain memory", small.kind == HUGE_NONE && small.size == 0);
+    huge_free(&small);
+    return 0;
+}
+
+//////////////////////////////////// Distributed Sweep Tests //////////////////////////////////////
+
+// a race sweep a little over a few shards, so the last shard is short
+static SweepJob* setup_sweep(int shards) {
+    static SweepJob job;
+    memset(&job, 0, sizeof(job));
+    job.mode     = SWEEP_RACE;
+    job.seed     = 7;
+    job.samples  = (uint64_t) shards * DIST_SHARD - 100;
+    job.position = *setup_game();
+    return &job;
+}
+
+static char* test_sweep_worker_count(void) {
+    SweepJob* job = setup_sweep(4);
+    SweepHistogram single = {0}, hist;
+    camels_sweep_range(job, 0, job->samples, &single);
+    mu_assert("Every sample should be counted", single.samples == job->samples);
+
+    DistResult result;
+    DistConfig unix_one = {.address = "build/test/dist.sock", .local_workers = 1};
+    mu_assert("Unix coordinator should run", dist_sweep(job, &unix_one, &hist, &result));
+    mu_assert("One worker should match a single process", memcmp(&single, &hist, sizeof(hist)) == 0);
+    mu_assert("Worker should have played every shard", result.workers == 1 && result.shards_local == 0);
+
+    DistConfig tcp_three = {.address = "127.0.0.1:0", .local_workers = 3};
+    mu_assert("TCP coordinator should run", dist_sweep(job, &tcp_three, &hist, &result));
+    mu_assert("Three workers should match a single process", memcmp(&single, &hist, sizeof(hist)) == 0);
+    mu_assert("All three workers should connect", result.workers == 3 && result.shards == 4);
+
+    return 0;
+}
+
+static char* test_sweep_worker_death(void) {
+    SweepJob* job = setup_sweep(8);
+    SweepHistogram single = {0}, hist;
+    camels_sweep_range(job, 0, job->samples, &single);
+
+    DistResult result;
+    DistConfig config = {.address = "build/test/dist.sock", .local_workers = 2, .crash_after = 1};
+    mu_assert("Coordinator should run", dist_sweep(job, &config, &hist, &result));
+    mu_assert("The dead worker's shard should be handed out again", result.shards_lost == 1);
+    mu_assert("Losing a worker should not change the result", memcmp(&single, &hist, sizeof(hist)) == 0);
+
+    return 0;
+}
+
+static char* test_sweep_worker_hang(void) {
+    SweepJob* job = setup_sweep(6);
+    SweepHistogram single = {0}, hist;
+    camels_sweep_range(job, 0, job->samples, &single);
+
+    DistResult result;
+    DistConfig config = {.address = "build/test/dist.sock", .local_workers = 2, .hang_after = 1, .shard_ms = 2000};
+    mu_assert("Coordinator should run", dist_sweep(job, &config, &hist, &result));
+    mu_assert("The hung worker's shard should be handed out again", result.shards_lost == 1 && result.shards_late == 1);
+    mu_assert("A hung worker should not change the result", memcmp(&single, &hist, sizeof(hist)) == 0);
+
+    return 0;
+}
+
 //////////////////////////////////// Test Suite //////////////////////////////////////
 
 static char* all_tests(void) {
@@ -874,6 +2374,7 @@ static char* all_tests(void) {
     printf("Running Ticket Tests...\n");
     mu_run_test(test_assign_ticket);
     mu_run_test(test_assign_all_tickets);
+    mu_run_test(test_ticket_top);
 
     printf("Running Spectator Tests...\n");
     mu_run_test(test_place_spec_tile);
@@ -888,6 +2389,7 @@ static char* all_tests(void) {
     mu_run_test(test_get_camel);
     mu_run_test(test_move_camel_forward);
     mu_run_test(test_move_camel_to_finish);
+    mu_run_test(test_move_kernel_fuzz);
 
     printf("Running Scoring Tests...\n");
     mu_run_test(test_get_top_camels);
@@ -924,6 +2426,99 @@ static char* all_tests(void) {
     mu_run_test(test_stack_victory_order);
     mu_run_test(test_spectator_reverse_move);
 
+    printf("Running Wager Valuation Tests...\n");
+    mu_run_test(test_remaining_dice);
+    mu_run_test(test_get_last_camel);
+    mu_run_test(test_queued_wager_ev);
+    mu_run_test(test_value_wagers);
+
+    printf("Running Evaluation Tests...\n");
+    mu_run_test(test_extract_features);
+    mu_run_test(test_eval_linear);
+    mu_run_test(test_eval_save_load);
+
+    printf("Running Self-play Tests...\n");
+    mu_run_test(test_legal_turns);
+    mu_run_test(test_sample_compression);
+    mu_run_test(test_self_play_dataset);
+
+    printf("Running Columnar Export Tests...\n");
+    mu_run_test(test_column_encodings);
+    mu_run_test(test_export_games);
+
+    printf("Running Session Tests...\n");
+    mu_run_test(test_session_human_and_bots);
+    mu_run_test(test_session_bots_finish);
+
+    printf("Running Fork Tests...\n");
+    mu_run_test(test_fork_roll_matches_move_camel);
+    mu_run_test(test_fork_tickets_and_wagers);
+
+    printf("Running Leg Odds Tests...\n");
+    mu_run_test(test_leg_odds_exact);
+    mu_run_test(test_leg_key_relabel);
+    mu_run_test(test_approx_leg_odds);
+    mu_run_test(test_leg_tracker);
+
+    printf("Running Tablebase Tests...\n");
+    mu_run_test(test_tablebase_index);
+    mu_run_test(test_tablebase_odds);
+
+    printf("Running Race Ranking Tests...\n");
+    mu_run_test(test_race_rank_roundtrip);
+    mu_run_test(test_race_rank_positions);
+
+    printf("Running Pondering Tests...\n");
+    mu_run_test(test_ponder_results);
+    mu_run_test(test_ponder_stop);
+
+    printf("Running Batch Evaluation Tests...\n");
+    mu_run_test(test_batch_roundtrip);
+    mu_run_test(test_batch_eval);
+
+    printf("Running Shared Memory Query Tests...\n");
+    mu_run_test(test_shm_query);
+    mu_run_test(test_shm_clients);
+
+    printf("Running Engine Protocol Tests...\n");
+    mu_run_test(test_engine_encoding);
+    mu_run_test(test_engine_session);
+
+    printf("Running Library API Tests...\n");
+    mu_run_test(test_api_bot_game);
+    mu_run_test(test_api_human_turns);
+
+    printf("Running Sequential Sampling Tests...\n");
+    mu_run_test(test_race_odds_within);
+    mu_run_test(test_race_compare);
+
+    printf("Running Variance Reduction Tests...\n");
+    mu_run_test(test_sampler_draws);
+    mu_run_test(test_sampler_unbiased);
+
+    printf("Running Expectimax Search Tests...\n");
+    mu_run_test(test_search_sure_ticket);
+    mu_run_test(test_search_pruning_exact);
+
+    printf("Running Tournament Tests...\n");
+    mu_run_test(test_tournament_seatings);
+    mu_run_test(test_tournament_ratings);
+
+    printf("Running Placement Tests...\n");
+    mu_run_test(test_placement_pinning);
+    mu_run_test(test_huge_alloc);
+
+    printf("Running Distributed Sweep Tests...\n");
+    mu_run_test(test_sweep_worker_count);
+    mu_run_test(test_sweep_worker_death);
+    mu_run_test(test_sweep_worker_hang);
+
+    printf("Running Stats Tests...\n");
+    mu_run_test(test_stats_merge);
+#ifdef CAMELS_STATS
+    mu_run_test(test_stats_counters);
+#endif
+
     return 0;
 }
 